@@ -66,10 +66,13 @@ private:
 		}
 	}
 	void HandleStringMessage(const TcpConnectionPtr &connection,
-	                         const string &message,
+	                         const BufferView &message,
 	                         TimeStamp receive_time)
 	{
-		printf("%s: %s", receive_time.ToFormattedTimeString().c_str(), message.c_str());
+		printf("%s: %.*s",
+		       receive_time.ToFormattedTimeString().c_str(),
+		       message.length(),
+		       message.data());
 	}
 
 	TcpClient client_;
@@ -1,9 +1,6 @@
 #include "codec.h"
 
 #include <stdio.h>
-#include <endian.h> // htobe32()
-
-#include <string>
 
 #include <netlib/buffer.h>
 #include <netlib/tcp_connection.h>
@@ -11,20 +8,17 @@
 #include <netlib/logging.h>
 
 using namespace netlib;
-using std::string;
 
-Codec::Codec(const StringMessageCallback &callback):
-	string_message_callback_(callback)
+Codec::Codec(const ViewMessageCallback &callback):
+	view_message_callback_(callback)
 {}
 
-void Codec::Send(const TcpConnectionPtr &connection, const string &message)
+void Codec::Send(const TcpConnectionPtr &connection, const BufferView &message)
 {
-	Buffer buffer;
-	int32_t length = static_cast<int32_t>(message.size());
-	int32_t length_be32 = ::htobe32(length);
-	buffer.Prepend(&length_be32, static_cast<int>(sizeof length_be32));
-	buffer.Append(message.data(), length);
-	connection->Send(&buffer);
+	Buffer buffer(message.length());
+	buffer.Append(message.data(), message.length());
+	buffer.PrependInt32(message.length());
+	connection->Send(std::move(buffer));
 }
 
 void Codec::HandleMessage(const TcpConnectionPtr &connection,
@@ -43,8 +37,7 @@ void Codec::HandleMessage(const TcpConnectionPtr &connection,
 		else if(buffer->ReadableByte() >= kHeaderLength + length)
 		{
 			buffer->Retrieve(kHeaderLength);
-			string message(buffer->ReadableBegin(), length);
-			string_message_callback_(connection, message, receive_time);
+			view_message_callback_(connection, buffer->PeekView(length), receive_time);
 			buffer->Retrieve(length);
 		}
 		else
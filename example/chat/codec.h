@@ -1,22 +1,25 @@
 #ifndef NETLIB_EXAMPLE_CHAT_CODEC_H_
 #define NETLIB_EXAMPLE_CHAT_CODEC_H_
 
+#include <netlib/buffer_view.h>
 #include <netlib/non_copyable.h>
 #include <netlib/function.h>
 
 class Codec: public netlib::NonCopyable
 {
 public:
-	using StringMessageCallback = std::function<void(const netlib::TcpConnectionPtr&,
-	                              const std::string&,
-	                              netlib::TimeStamp)>;
+	// The message is a view into the connection's input buffer, valid only during
+	// the callback.
+	using ViewMessageCallback = std::function<void(const netlib::TcpConnectionPtr&,
+	                            const netlib::BufferView&,
+	                            netlib::TimeStamp)>;
 
-	explicit Codec(const StringMessageCallback&);
-	void Send(const netlib::TcpConnectionPtr&, const std::string&);
+	explicit Codec(const ViewMessageCallback&);
+	void Send(const netlib::TcpConnectionPtr&, const netlib::BufferView&);
 	void HandleMessage(const netlib::TcpConnectionPtr&, netlib::Buffer*, netlib::TimeStamp);
 
 private:
-	StringMessageCallback string_message_callback_;
+	ViewMessageCallback view_message_callback_;
 	static const int kHeaderLength = static_cast<int>(sizeof(int32_t));
 	static const int kMinMessageLength = 0;
 	static const int kMaxMessageLength = 64 * 1024; // 64KB
@@ -4,6 +4,7 @@
 
 #include <netlib/event_loop.h>
 #include <netlib/logging.h>
+#include <netlib/mutex.h>
 #include <netlib/tcp_server.h>
 
 using namespace netlib;
@@ -56,7 +57,7 @@ private:
 		}
 	}
 	void HandleStringMessage(const TcpConnectionPtr &connection,
-	                         const string &message,
+	                         const BufferView &message,
 	                         TimeStamp)
 	{
 		ConnectionSetPtr connection_set_ptr;
@@ -46,7 +46,7 @@ private:
 		}
 	}
 	void HandleStringMessage(const TcpConnectionPtr &connection,
-	                         const string &message,
+	                         const BufferView &message,
 	                         TimeStamp)
 	{
 		for(ConnectionSet::iterator it = connection_set_.begin();
@@ -1,7 +1,5 @@
 #include "sudoku.h"
 
-#include <algorithm>
-
 #include <netlib/event_loop.h>
 #include <netlib/socket_address.h>
 #include <netlib/logging.h>
@@ -49,10 +47,11 @@ private:
 			const char *crlf = buffer->FindCRLF();
 			if(crlf != nullptr) // If found a complete request.
 			{
-				string request(buffer->ReadableBegin(), crlf);
+				// Parse in place: the view is consumed before its bytes are retrieved.
+				int request_length = static_cast<int>(crlf - buffer->ReadableBegin());
+				good_request = ProcessRequest(connection, buffer->PeekView(request_length));
 				buffer->RetrieveUntil(crlf + 2);
 				length = buffer->ReadableByte();
-				good_request = ProcessRequest(connection, request);
 			}
 			if(crlf == nullptr || good_request == false)
 			{
@@ -62,31 +61,26 @@ private:
 			}
 		}
 	}
-	bool ProcessRequest(const TcpConnectionPtr &connection, const string &request)
+	bool ProcessRequest(const TcpConnectionPtr &connection, const BufferView &request)
 	{
-		string id, puzzle;
-		bool good_request = true;
-
-		string::const_iterator colon = std::find(request.begin(), request.end(), ':');
-		if(colon != request.end())
+		BufferView id, puzzle(request);
+		int colon = request.Find(':');
+		if(colon >= 0)
 		{
-			id.assign(request.begin(), colon);
-			puzzle.assign(colon + 1, request.end());
-		}
-		else
-		{
-			puzzle = request;
+			id = request.SubView(0, colon);
+			puzzle = request.SubView(colon + 1);
 		}
 
-		if(static_cast<int>(puzzle.size()) == kCellNumber)
+		bool good_request = true;
+		if(puzzle.length() == kCellNumber)
 		{
 			LOG_DEBUG("%s", connection->name().c_str());
 			TimeStamp start(TimeStamp::Now());
-			string result = SolveSudoku(puzzle);
+			string result = SolveSudoku(puzzle.ToString());
 			LOG_INFO("%f sec", TimeDifferenceInSecond(TimeStamp::Now(), start));
 			if(id.empty() == false)
 			{
-				connection->Send(id + ":");
+				result = id.ToString() + ":" + result;
 			}
 			connection->Send(result + "\r\n");
 		}
@@ -1,7 +1,6 @@
 #include "sudoku.h"
 
-#include <algorithm>
-
+#include <netlib/buffer_slice.h>
 #include <netlib/event_loop.h>
 #include <netlib/socket_address.h>
 #include <netlib/logging.h>
@@ -54,10 +53,11 @@ private:
 			const char *crlf = buffer->FindCRLF();
 			if(crlf != nullptr) // If found a complete request.
 			{
-				string request(buffer->ReadableBegin(), crlf);
+				// Parse in place: the view is consumed before its bytes are retrieved.
+				int request_length = static_cast<int>(crlf - buffer->ReadableBegin());
+				good_request = ProcessRequest(connection, buffer->PeekView(request_length));
 				buffer->RetrieveUntil(crlf + 2);
 				length = buffer->ReadableByte();
-				good_request = ProcessRequest(connection, request);
 			}
 			if(crlf == nullptr || good_request == false)
 			{
@@ -67,25 +67,27 @@ private:
 			}
 		}
 	}
-	bool ProcessRequest(const TcpConnectionPtr &connection, const string &request)
+	bool ProcessRequest(const TcpConnectionPtr &connection, const BufferView &request)
 	{
-		string id, puzzle;
-		bool good_request = true;
-
-		string::const_iterator colon = std::find(request.begin(), request.end(), ':');
-		if(colon != request.end())
+		BufferView id, puzzle(request);
+		int colon = request.Find(':');
+		if(colon >= 0)
 		{
-			id.assign(request.begin(), colon);
-			puzzle.assign(colon + 1, request.end());
-		}
-		else
-		{
-			puzzle = request;
+			id = request.SubView(0, colon);
+			puzzle = request.SubView(colon + 1);
 		}
 
-		if(static_cast<int>(puzzle.size()) == kCellNumber)
+		bool good_request = true;
+		if(puzzle.length() == kCellNumber)
 		{
-			thread_pool_.RunOrAddTask(bind(&Solve, connection, puzzle, id));
+			// The request outlives this callback: copy it once into a pooled slab
+			// that the id and puzzle slices share.
+			BufferSlice slice(connection->loop()->slab_pool(), request);
+			thread_pool_.RunOrAddTask(bind(&Solve,
+			                               connection,
+			                               slice.SubSlice(request.length() - kCellNumber,
+			                                              kCellNumber),
+			                               slice.SubSlice(0, id.length())));
 		}
 		else
 		{
@@ -94,15 +96,15 @@ private:
 		return good_request;
 	}
 	static void Solve(const TcpConnectionPtr &connection,
-	                  const string &puzzle,
-	                  const string &id)
+	                  const BufferSlice &puzzle,
+	                  const BufferSlice &id)
 	{
 		TimeStamp start(TimeStamp::Now());
-		string result = SolveSudoku(puzzle);
+		string result = SolveSudoku(puzzle.view().ToString());
 		LOG_INFO("%f sec", TimeDifferenceInSecond(TimeStamp::Now(), start));
 		if(id.empty() == false)
 		{
-			connection->Send(id + ":");
+			result = id.view().ToString() + ":" + result;
 		}
 		connection->Send(result + "\r\n");
 	}
@@ -1,17 +1,15 @@
 #include "sudoku.h"
 
-#include <algorithm>
-
 #include <netlib/event_loop.h>
 #include <netlib/socket_address.h>
 #include <netlib/logging.h>
+#include <netlib/loop_watchdog.h>
 #include <netlib/tcp_server.h>
 
 using namespace netlib;
 using std::bind;
 using namespace std::placeholders;
 using std::string;
-using std::find;
 
 // Review: HandleMessage, ProcessRequest
 
@@ -53,10 +51,11 @@ private:
 			const char *crlf = buffer->FindCRLF();
 			if(crlf != nullptr) // If found a complete request.
 			{
-				string request(buffer->ReadableBegin(), crlf);
+				// Parse in place: the view is consumed before its bytes are retrieved.
+				int request_length = static_cast<int>(crlf - buffer->ReadableBegin());
+				good_request = ProcessRequest(connection, buffer->PeekView(request_length));
 				buffer->RetrieveUntil(crlf + 2); // Move over "\r\n"
 				length = buffer->ReadableByte();
-				good_request = ProcessRequest(connection, request);
 			}
 			if(crlf == nullptr || good_request == false)
 			{
@@ -66,29 +65,25 @@ private:
 			}
 		}
 	}
-	bool ProcessRequest(const TcpConnectionPtr &connection, const string &request)
+	bool ProcessRequest(const TcpConnectionPtr &connection, const BufferView &request)
 	{
-		string id, puzzle;
-		string::const_iterator colon = find(request.begin(), request.end(), ':');
-		if(colon != request.end())
-		{
-			id.assign(request.begin(), colon);
-			puzzle.assign(colon + 1, request.end());
-		}
-		else
+		BufferView id, puzzle(request);
+		int colon = request.Find(':');
+		if(colon >= 0)
 		{
-			puzzle = request;
+			id = request.SubView(0, colon);
+			puzzle = request.SubView(colon + 1);
 		}
 
 		bool good_request = true;
-		if(static_cast<int>(puzzle.size()) == kCellNumber)
+		if(puzzle.length() == kCellNumber)
 		{
 			TimeStamp start(TimeStamp::Now());
-			string result = SolveSudoku(puzzle);
+			string result = SolveSudoku(puzzle.ToString());
 			LOG_INFO("%f", TimeDifferenceInSecond(TimeStamp::Now(), start));
 			if(id.empty() == false)
 			{
-				connection->Send(id + ":");
+				result = id.ToString() + ":" + result;
 			}
 			connection->Send(result + "\r\n");
 		}
@@ -105,6 +100,10 @@ private:
 int main(int argc, char* argv[])
 {
 	EventLoop loop;
+	// Solving runs on the loop: report a puzzle that holds it, and all connections, for 1s.
+	LoopWatchdog watchdog(1.0);
+	watchdog.Register(&loop);
+	watchdog.Start();
 	SocketAddress listen_address(7188);
 	SudokuServer server(&loop, listen_address);
 	server.Start();
@@ -7,19 +7,25 @@
 
 #include <netlib/acceptor.h>
 #include <netlib/event_loop.h>
+#include <netlib/io_uring_poller.h>
 #include <netlib/logging.h>
 #include <netlib/socket_address.h>
 #include <netlib/socket_operation.h> // CreateNonblockingTcpSocket()
 
 using std::bind;
 using netlib::Acceptor;
+using netlib::SocketAddress;
 
 Acceptor::Acceptor(EventLoop *owner_loop, const SocketAddress &server_address):
 	owner_loop_(owner_loop),
 	server_socket_(nso::CreateNonblockingTcpSocket(server_address.socket_family())),
 	server_channel_(owner_loop_, server_socket_.socket()),
 	listening_(false),
-	idle_fd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+	idle_fd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)),
+	io_uring_(owner_loop->io_uring_poller()),
+	accept_pending_(false),
+	accept_request_(0),
+	self_(std::make_shared<Acceptor*>(this))
 {
 	assert(idle_fd_ >= 0);
 	server_socket_.SetReuseAddress(true);
@@ -48,20 +54,75 @@ void Acceptor::HandleRead()
 	else
 	{
 		LOG_ERROR("server_socket_.Accept()");
-		if(errno == EMFILE)
+		HandleAcceptError(errno);
+	}
+}
+void Acceptor::HandleAcceptError(int error)
+{
+	if(error == EMFILE)
+	{
+		::close(idle_fd_);
+		idle_fd_ = ::accept(server_socket_.socket(), NULL, NULL);
+		::close(idle_fd_);
+		idle_fd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+	}
+}
+
+void Acceptor::SubmitAccept()
+{
+	std::weak_ptr<Acceptor*> weak_self(self_);
+	accept_pending_ = true;
+	accept_request_ = io_uring_->SubmitAccept(server_socket_.socket(),
+	                  [weak_self](int result, const SocketAddress &client_address)
+	{
+		std::shared_ptr<Acceptor*> self(weak_self.lock());
+		if(self)
+		{
+			(*self)->HandleAcceptCompletion(result, client_address);
+		}
+		else if(result >= 0) // Accepted as the acceptor was destructed.
+		{
+			::close(result);
+		}
+	});
+}
+void Acceptor::HandleAcceptCompletion(int result, const SocketAddress &client_address)
+{
+	accept_pending_ = false;
+	if(result >= 0)
+	{
+		if(new_connection_callback_)
 		{
-			::close(idle_fd_);
-			idle_fd_ = ::accept(server_socket_.socket(), NULL, NULL);
-			::close(idle_fd_);
-			idle_fd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+			new_connection_callback_(result, client_address);
+		}
+		else
+		{
+			::close(result);
 		}
 	}
+	else
+	{
+		errno = -result;
+		LOG_ERROR("Acceptor::HandleAcceptCompletion()");
+		HandleAcceptError(-result);
+	}
+	SubmitAccept();
 }
 
 Acceptor::~Acceptor()
 {
-	server_channel_.set_requested_event(Channel::NONE_EVENT);
-	server_channel_.RemoveChannel();
+	if(io_uring_ != nullptr)
+	{
+		if(accept_pending_ == true)
+		{
+			io_uring_->CancelRequest(accept_request_);
+		}
+	}
+	else
+	{
+		server_channel_.set_requested_event(Channel::NONE_EVENT);
+		server_channel_.RemoveChannel();
+	}
 	::close(idle_fd_);
 }
 
@@ -69,7 +130,14 @@ void Acceptor::Listen()
 {
 	owner_loop_->AssertInLoopThread();
 
-	server_channel_.set_requested_event(Channel::READ_EVENT);
+	if(io_uring_ == nullptr)
+	{
+		server_channel_.set_requested_event(Channel::READ_EVENT);
+	}
 	server_socket_.Listen();
 	listening_ = true;
+	if(io_uring_ != nullptr)
+	{
+		SubmitAccept();
+	}
 }
@@ -1,7 +1,10 @@
 #ifndef NETLIB_NETLIB_ACCEPTOR_H_
 #define NETLIB_NETLIB_ACCEPTOR_H_
 
+#include <stdint.h> // uint64_t
+
 #include <functional>
+#include <memory> // shared_ptr<>
 
 #include <netlib/channel.h>
 #include <netlib/non_copyable.h>
@@ -11,15 +14,19 @@ namespace netlib
 {
 
 class EventLoop;
+class IoUringPoller;
 class SocketAddress;
 
 // Interface:
-// Ctor -> -HandleRead
+// Ctor -> -HandleRead -> -HandleAcceptError
 // Dtor
 // listening
 // set_new_connection_callback
-// Listen
+// Listen -> -SubmitAccept
+//			-SubmitAccept -> -HandleAcceptCompletion -> -HandleAcceptError
 
+// In a loop whose poller is an IoUringPoller, keeps one accept request in flight
+// instead of waiting for the listening socket to become readable.
 class Acceptor: public NonCopyable
 {
 public:
@@ -40,6 +47,10 @@ public:
 
 private:
 	void HandleRead();
+	// Free the idle fd to accept and close the connection that can't be served.
+	void HandleAcceptError(int error);
+	void SubmitAccept();
+	void HandleAcceptCompletion(int result, const SocketAddress &client_address);
 
 	EventLoop *owner_loop_;
 	Socket server_socket_;
@@ -47,6 +58,11 @@ private:
 	bool listening_;
 	int idle_fd_;
 	NewConnectionCallback new_connection_callback_;
+	IoUringPoller *io_uring_; // owner_loop_->io_uring_poller().
+	bool accept_pending_;
+	uint64_t accept_request_;
+	// Points to this acceptor, for the accept request: it may complete after the dtor.
+	std::shared_ptr<Acceptor*> self_;
 };
 
 }
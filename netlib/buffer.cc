@@ -1,25 +1,266 @@
 #include <netlib/buffer.h>
 
+#include <sys/mman.h> // memfd_create(), mmap(), munmap()
 #include <sys/uio.h> // readv()
 #include <errno.h> // errno
+#include <stdlib.h> // malloc(), free()
+#include <unistd.h> // ftruncate(), close(), sysconf(), write()
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h> // _mm256_*, _mm_*
+#endif
+
+#include <netlib/logging.h>
+#include <netlib/slab_allocator.h>
 
 using netlib::Buffer;
 using std::string;
 
-Buffer::Buffer(int initial_size):
-	buffer_(kInitialPrependableByte + initial_size),
+Buffer::Buffer(int initial_size, SlabAllocator *allocator, bool ring):
+	allocator_(allocator),
+	ring_(ring),
+	buffer_(nullptr),
+	capacity_(0),
 	read_index_(kInitialPrependableByte),
 	write_index_(kInitialPrependableByte)
 {
+	AllocateStorage(kInitialPrependableByte + initial_size);
 	assert(PrependableByte() == kInitialPrependableByte);
 	assert(ReadableByte() == 0);
-	assert(WritableByte() == initial_size);
+	assert(WritableByte() >= initial_size);
+}
+Buffer::Buffer(const Buffer &rhs):
+	allocator_(rhs.allocator_),
+	ring_(rhs.ring_),
+	buffer_(nullptr),
+	capacity_(0),
+	read_index_(rhs.read_index_),
+	write_index_(rhs.write_index_)
+{
+	AllocateStorage(rhs.capacity_);
+	if(ring_ != rhs.ring_) // No ring: the readable bytes may wrap past capacity_.
+	{
+		read_index_ = write_index_ = kInitialPrependableByte;
+		Append(rhs.ReadableBegin(), rhs.ReadableByte());
+	}
+	else
+	{
+		MemoryCopy(BufferBegin() + read_index_, rhs.ReadableBegin(), ReadableByte());
+	}
+}
+Buffer::Buffer(Buffer &&rhs):
+	allocator_(rhs.allocator_),
+	ring_(rhs.ring_),
+	buffer_(rhs.buffer_),
+	capacity_(rhs.capacity_),
+	read_index_(rhs.read_index_),
+	write_index_(rhs.write_index_)
+{
+	rhs.ring_ = false; // A small linear buffer is cheaper to leave behind than a mapping.
+	rhs.AllocateStorage(kInitialPrependableByte);
+	rhs.read_index_ = rhs.write_index_ = kInitialPrependableByte;
+}
+Buffer::~Buffer()
+{
+	DeallocateStorage(buffer_, capacity_);
 }
 
-const char *Buffer::FindCRLF(const char *start) const
+namespace
 {
-	assert(ReadableBegin() <= start && start <= WritableBegin());
-	for(const char *ptr = start, *end = WritableBegin() - 1; ptr < end; ++ptr)
+
+// Return `capacity` bytes whose mirror follows them at base + capacity, which
+// must be a multiple of the page size, or nullptr with errno set. Under load this
+// fails for ordinary reasons(EMFILE, vm.max_map_count: each ring takes 2 mappings).
+char *MapRing(int capacity)
+{
+	int fd = ::memfd_create("netlib_buffer", MFD_CLOEXEC);
+	if(fd < 0)
+	{
+		return nullptr;
+	}
+	char *base = nullptr;
+	if(::ftruncate(fd, capacity) == 0)
+	{
+		// Reserve both halves first so that nothing else can take the second one.
+		void *reserved = ::mmap(nullptr,
+		                        2 * static_cast<size_t>(capacity),
+		                        PROT_NONE,
+		                        MAP_PRIVATE | MAP_ANONYMOUS,
+		                        -1,
+		                        0);
+		base = (reserved == MAP_FAILED) ? nullptr : static_cast<char*>(reserved);
+		for(int half = 0; base != nullptr && half < 2; ++half)
+		{
+			if(::mmap(base + half * capacity,
+			          capacity,
+			          PROT_READ | PROT_WRITE,
+			          MAP_SHARED | MAP_FIXED,
+			          fd,
+			          0) == MAP_FAILED)
+			{
+				int saved_errno = errno;
+				::munmap(base, 2 * static_cast<size_t>(capacity));
+				errno = saved_errno;
+				base = nullptr;
+			}
+		}
+	}
+	int saved_errno = errno;
+	::close(fd); // The mappings keep the memory alive.
+	errno = saved_errno;
+	return base;
+}
+
+}
+
+int Buffer::RoundCapacity(int capacity) const
+{
+	if(ring_ == true)
+	{
+		static const int kPageSize = static_cast<int>(::sysconf(_SC_PAGESIZE));
+		return (capacity + kPageSize - 1) / kPageSize * kPageSize;
+	}
+	else if(allocator_ != nullptr)
+	{
+		return SlabAllocator::RoundUp(capacity);
+	}
+	return capacity;
+}
+void Buffer::AllocateStorage(int capacity)
+{
+	if(ring_ == true)
+	{
+		capacity_ = RoundCapacity(capacity);
+		buffer_ = MapRing(capacity_);
+		if(buffer_ != nullptr)
+		{
+			return;
+		}
+		LOG_ERROR("Buffer::AllocateStorage(): MapRing ERROR, use linear mode");
+		ring_ = false;
+	}
+	capacity_ = RoundCapacity(capacity);
+	if(allocator_ != nullptr)
+	{
+		buffer_ = allocator_->Allocate(capacity_);
+	}
+	else
+	{
+		buffer_ = static_cast<char*>(::malloc(capacity_));
+		if(buffer_ == nullptr)
+		{
+			LOG_FATAL("Buffer::AllocateStorage(): malloc FATAL");
+		}
+	}
+}
+void Buffer::DeallocateStorage(char *buffer, int capacity)
+{
+	if(ring_ == true)
+	{
+		::munmap(buffer, 2 * static_cast<size_t>(capacity));
+	}
+	else if(allocator_ != nullptr)
+	{
+		allocator_->Deallocate(buffer, capacity);
+	}
+	else
+	{
+		::free(buffer);
+	}
+}
+
+namespace
+{
+
+#if defined(__AVX2__)
+const int kVectorByte = 32;
+using Vector = __m256i;
+inline Vector Broadcast(char byte)
+{
+	return _mm256_set1_epi8(byte);
+}
+// Bit i of the result is set iff ptr[i] == the broadcast byte of `pattern`.
+inline uint32_t MatchMask(const char *ptr, Vector pattern)
+{
+	Vector data = _mm256_loadu_si256(reinterpret_cast<const Vector*>(ptr));
+	return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, pattern)));
+}
+#elif defined(__SSE2__)
+const int kVectorByte = 16;
+using Vector = __m128i;
+inline Vector Broadcast(char byte)
+{
+	return _mm_set1_epi8(byte);
+}
+inline uint32_t MatchMask(const char *ptr, Vector pattern)
+{
+	Vector data = _mm_loadu_si128(reinterpret_cast<const Vector*>(ptr));
+	return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(data, pattern)));
+}
+#endif
+
+// Return the first `byte` in [begin, end), or nullptr.
+const char *FindByteInRange(const char *begin, const char *end, char byte)
+{
+	const char *ptr = begin;
+#if defined(__AVX2__) || defined(__SSE2__)
+	if(end - ptr >= kVectorByte)
+	{
+		const Vector pattern = Broadcast(byte);
+		// The last block overlaps the previous one instead of falling back to bytes:
+		// bytes before `end - kVectorByte` that it re-reads are known not to match.
+		for(const char *last = end - kVectorByte; ; ptr += kVectorByte)
+		{
+			ptr = (ptr < last) ? ptr : last;
+			uint32_t mask = MatchMask(ptr, pattern);
+			if(mask != 0)
+			{
+				return ptr + __builtin_ctz(mask);
+			}
+			if(ptr == last)
+			{
+				return nullptr;
+			}
+		}
+	}
+#endif
+	for(; ptr < end; ++ptr)
+	{
+		if(*ptr == byte)
+		{
+			return ptr;
+		}
+	}
+	return nullptr;
+}
+// Return the first "\r\n" that lies entirely in [begin, end), or nullptr.
+// Every '\r' in a block is a candidate, confirm it by checking its next byte. Only
+// read a block when its last byte can still be followed by '\n' inside the range.
+const char *FindCRLFInRange(const char *begin, const char *end)
+{
+	const char *ptr = begin;
+#if defined(__AVX2__) || defined(__SSE2__)
+	if(end - ptr > kVectorByte)
+	{
+		const Vector pattern = Broadcast('\r');
+		for(const char *last = end - 1 - kVectorByte; ; ptr += kVectorByte)
+		{
+			ptr = (ptr < last) ? ptr : last;
+			for(uint32_t mask = MatchMask(ptr, pattern); mask != 0; mask &= mask - 1)
+			{
+				const char *cr = ptr + __builtin_ctz(mask);
+				if(*(cr + 1) == '\n')
+				{
+					return cr;
+				}
+			}
+			if(ptr == last)
+			{
+				return nullptr;
+			}
+		}
+	}
+#endif
+	for(const char *last = end - 1; ptr < last; ++ptr)
 	{
 		if(*ptr == '\r' && *(ptr + 1) == '\n')
 		{
@@ -28,20 +269,49 @@ const char *Buffer::FindCRLF(const char *start) const
 	}
 	return nullptr;
 }
+
+}
+
+const char *Buffer::FindCRLF(const char *start) const
+{
+	assert(ReadableBegin() <= start && start <= WritableBegin());
+	return FindCRLFInRange(start, WritableBegin());
+}
 const char *Buffer::FindCRLF() const
 {
 	return FindCRLF(ReadableBegin());
 }
+const char *Buffer::FindEOL(const char *start) const
+{
+	return FindByte(start, '\n');
+}
+const char *Buffer::FindEOL() const
+{
+	return FindEOL(ReadableBegin());
+}
+const char *Buffer::FindByte(const char *start, char byte) const
+{
+	assert(ReadableBegin() <= start && start <= WritableBegin());
+	return FindByteInRange(start, WritableBegin(), byte);
+}
+const char *Buffer::FindByte(char byte) const
+{
+	return FindByte(ReadableBegin(), byte);
+}
 
 int Buffer::ReadFd(int fd, int &saved_errno)
 {
 	char stack_buffer[64 * kOneKilobyte];
+	return ReadFd(fd, saved_errno, stack_buffer, static_cast<int>(sizeof stack_buffer));
+}
+int Buffer::ReadFd(int fd, int &saved_errno, char *extra_buffer, int extra_size)
+{
 	int writable_byte = WritableByte();
 	struct iovec vec[2];
 	vec[0].iov_base = WritableBegin();
 	vec[0].iov_len = writable_byte;
-	vec[1].iov_base = stack_buffer;
-	vec[1].iov_len = sizeof stack_buffer;
+	vec[1].iov_base = extra_buffer;
+	vec[1].iov_len = extra_size;
 	int read_byte = static_cast<int>(::readv(fd, vec, 2));
 	if(read_byte < 0)
 	{
@@ -54,7 +324,7 @@ int Buffer::ReadFd(int fd, int &saved_errno)
 	else
 	{
 		write_index_ += writable_byte;
-		Append(stack_buffer, read_byte - writable_byte);
+		Append(extra_buffer, read_byte - writable_byte);
 	}
 	return read_byte;
 }
@@ -70,12 +340,32 @@ void Buffer::Append(const char *data, int length)
 }
 void Buffer::EnsureWritableByte(int length)
 {
-	if(WritableByte() < length)
+	if(WritableByte() < length && ring_ == true)
 	{
-		// 1. Really not enough space.
+		// Never compact: the readable bytes are already contiguous. Grow into a ring
+		// of at least double the size.
+		int size = ReadableByte() + length;
+		int doubled_size = 2 * capacity_ - kInitialPrependableByte;
+		Buffer other((size > doubled_size) ? size : doubled_size, allocator_, true);
+		other.Append(ReadableBegin(), ReadableByte());
+		Swap(other);
+	}
+	else if(WritableByte() < length)
+	{
+		// 1. Really not enough space. At least double the storage, so that appending
+		// piece by piece stays amortized O(1) whether or not there is an allocator.
 		if(PrependableByte() + WritableByte() < kInitialPrependableByte + length)
 		{
-			buffer_.resize(write_index_ + length);
+			char *old_buffer = buffer_;
+			int old_capacity = capacity_;
+			int capacity = write_index_ + length;
+			if(capacity < 2 * old_capacity)
+			{
+				capacity = 2 * old_capacity;
+			}
+			AllocateStorage(capacity);
+			MemoryCopy(BufferBegin(), old_buffer, write_index_);
+			DeallocateStorage(old_buffer, old_capacity);
 		}
 		// 2. Move readable data to the front, make space inside buffer.
 		else
@@ -88,30 +378,39 @@ void Buffer::EnsureWritableByte(int length)
 		assert(WritableByte() >= length);
 	}
 }
-void *Buffer::MemoryCopy(void *dest, const void *src, size_t length)
+void Buffer::Shrink(int reserve)
 {
-	if(dest == nullptr || src == nullptr || dest == src)
+	// Compare before allocating: a ring rounds up to a page, so it is often no
+	// smaller, and mapping one just to unmap it costs a memfd and seven syscalls.
+	if(RoundCapacity(kInitialPrependableByte + ReadableByte() + reserve) < capacity_)
 	{
-		return dest;
+		Buffer other(ReadableByte() + reserve, allocator_, ring_);
+		other.Append(ReadableBegin(), ReadableByte());
+		Swap(other);
 	}
-
-	char *dest_ptr = static_cast<char*>(dest);
-	const char *src_ptr = static_cast<const char*>(src);
-	if(dest_ptr < src_ptr || dest_ptr >= src_ptr + length)
+}
+bool Buffer::SetRingMode(bool on)
+{
+	if(on != ring_)
 	{
-		for(size_t index = 0; index < length; ++index)
-		{
-			dest_ptr[index] = src_ptr[index];
-		}
+		Buffer other(ReadableByte(), allocator_, on);
+		other.Append(ReadableBegin(), ReadableByte());
+		Swap(other);
 	}
-	else // src_ptr < dest_ptr < src_ptr + length
+	return ring_ == on;
+}
+void Buffer::DetachAllocator()
+{
+	if(ring_ == true)
 	{
-		for(size_t index = 0; index < length; ++index)
-		{
-			dest_ptr[length - 1 - index] = src_ptr[length - 1 - index];
-		}
+		allocator_ = nullptr; // The mapping is not the allocator's.
+	}
+	else if(allocator_ != nullptr)
+	{
+		Buffer other(ReadableByte(), nullptr);
+		other.Append(ReadableBegin(), ReadableByte());
+		Swap(other);
 	}
-	return dest;
 }
 
 void Buffer::Prepend(const void *data, int length)
@@ -133,12 +432,31 @@ string Buffer::RetrieveAsString(int length)
 	Retrieve(length);
 	return result;
 }
+int Buffer::WriteFd(int fd, int &saved_errno)
+{
+	int write_byte = static_cast<int>(::write(fd, ReadableBegin(), ReadableByte()));
+	if(write_byte > 0)
+	{
+		Retrieve(write_byte);
+	}
+	else if(write_byte < 0)
+	{
+		saved_errno = errno;
+	}
+	return write_byte;
+}
+
 void Buffer::Retrieve(int length)
 {
 	assert(0 <= length && length <= ReadableByte());
 	if(length < ReadableByte())
 	{
 		read_index_ += length;
+		if(ring_ == true && read_index_ >= capacity_) // Continue in the first mapping.
+		{
+			read_index_ -= capacity_;
+			write_index_ -= capacity_;
+		}
 	}
 	else
 	{
@@ -155,10 +473,46 @@ void Buffer::RetrieveAll()
 	read_index_ = write_index_ = kInitialPrependableByte;
 }
 
-int32_t Buffer::PeekInt32()
+void Buffer::AppendVarint(uint64_t value)
 {
-	assert(ReadableByte() >= static_cast<int>(sizeof(int32_t)));
-	int32_t be32 = 0;
-	MemoryCopy(&be32, ReadableBegin(), sizeof be32);
-	return ::be32toh(be32);
+	EnsureWritableByte(kMaxVarintByte);
+	unsigned char *ptr = reinterpret_cast<unsigned char*>(WritableBegin());
+	unsigned char *begin = ptr;
+	for(; value >= 0x80; value >>= 7)
+	{
+		*ptr++ = static_cast<unsigned char>(value | 0x80);
+	}
+	*ptr++ = static_cast<unsigned char>(value);
+	write_index_ += static_cast<int>(ptr - begin);
+}
+
+int Buffer::PeekVarint(uint64_t &value) const
+{
+	const unsigned char *begin = reinterpret_cast<const unsigned char*>(ReadableBegin());
+	int limit = (ReadableByte() < kMaxVarintByte) ? ReadableByte() : kMaxVarintByte;
+	uint64_t result = 0;
+	for(int index = 0; index < limit; ++index)
+	{
+		// The 10th byte holds only bit 63.
+		if(index == kMaxVarintByte - 1 && begin[index] > 1)
+		{
+			return -1;
+		}
+		result |= static_cast<uint64_t>(begin[index] & 0x7f) << (7 * index);
+		if(begin[index] < 0x80)
+		{
+			value = result;
+			return index + 1;
+		}
+	}
+	return (limit == kMaxVarintByte) ? -1 : 0;
+}
+int Buffer::ReadVarint(uint64_t &value)
+{
+	int length = PeekVarint(value);
+	if(length > 0)
+	{
+		Retrieve(length);
+	}
+	return length;
 }
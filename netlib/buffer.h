@@ -2,40 +2,90 @@
 #define NETLIB_NETLIB_BUFFER_H_
 
 #include <assert.h>
+#include <endian.h> // htobe*(), be*toh()
+#include <stdint.h> // int*_t, uint*_t
+#include <string.h> // memcpy(), memmove()
 
-#include <vector>
 #include <string>
+#include <utility> // swap()
 
+#include <netlib/buffer_view.h>
 #include <netlib/copyable.h>
 
 namespace netlib
 {
 
+class SlabAllocator;
+
 // Interface:
-// Ctor -> +PrependableByte -> +ReadableByte -> +WritableByte
-// Getter: PrependableByte, ReadableByte, WritableByte
-// FindCRLF: (const char*), () -> +ReadableBegin -> -WritableBegin
+// Ctor -> +PrependableByte -> +ReadableByte -> +WritableByte -> -AllocateStorage
+//			-AllocateStorage -> -RoundCapacity
+//			-AllocateStorage -> -MapRing
+// Copy/Move Ctor -> -AllocateStorage
+// Dtor -> -DeallocateStorage
+// operator= -> +Swap
+// Getter: PrependableByte, ReadableByte, WritableByte, capacity, ring_mode
+// SetRingMode -> +Append(const char*, int) -> +Swap
+// ReadableView, PeekView -> +ReadableBegin
+// FindCRLF: (const char*), () -> +ReadableBegin -> +WritableBegin
 //			+ReadableBegin -> -BufferBegin
-//			-WritableBegin -> -BufferBegin
-// ReadFd -> +Append(const char*, int)
-// Append(const string&) -> Append(const char*, int) -> -EnsureWritableByte -> -Copy
-//			-EnsureWritableByte -> -Copy
+//			+WritableBegin -> -BufferBegin
+// FindEOL: (const char*), () -> +FindByte
+// FindByte: (const char*, char), (char) -> +ReadableBegin -> +WritableBegin
+// ReadFd(int, int&) -> ReadFd(int, int&, char*, int) -> +Append(const char*, int)
+// HasWritten
+// WriteFd -> +Retrieve
+// Append(const string&) -> Append(const char*, int) -> +EnsureWritableByte -> -MemoryCopy
+//			+EnsureWritableByte -> -MemoryCopy
+// Shrink -> -RoundCapacity, +Append(const char*, int) -> +Swap
+// DetachAllocator -> +Shrink
 // Prepend
+// AppendInt8/16/32/64 -> -HostToNetwork -> -AppendFixed -> +EnsureWritableByte
+// PrependInt8/16/32/64 -> -HostToNetwork -> -PrependFixed
+// AppendVarint -> +EnsureWritableByte
 // RetrieveAllAsString -> RetrieveAsString -> Retrieve -> RetrieveAll
-// RetrieveUntil -> +ReadableBegin -> -WritableBegin -> +Retrieve
-// PeekInt32
+// RetrieveUntil -> +ReadableBegin -> +WritableBegin -> +Retrieve
+// PeekInt8/16/32/64 -> -PeekFixed -> -NetworkToHost
+// ReadInt8/16/32/64 -> +PeekInt8/16/32/64 -> +Retrieve
+// PeekVarint
+// ReadVarint -> +PeekVarint -> +Retrieve
 
 class Buffer: public Copyable
 {
 public:
 	static const int kInitialPrependableByte = 8;
 	static const int kOneKilobyte = 1024;
+	static const int kMaxVarintByte = 10; // ceil(64 / 7)
 
-	explicit Buffer(int initial_size = kOneKilobyte);
+	// The storage comes from `allocator`(rounded up to its size class) or, if null,
+	// from malloc(). Must be destructed in the allocator's loop thread or after
+	// DetachAllocator() if the allocator may be destructed first.
+	explicit Buffer(int initial_size = kOneKilobyte, SlabAllocator *allocator = nullptr):
+		Buffer(initial_size, allocator, false)
+	{}
+	Buffer(const Buffer &rhs);
+	// Take rhs's storage, leave rhs an empty but usable buffer.
+	Buffer(Buffer &&rhs);
+	~Buffer();
+	Buffer &operator=(Buffer rhs)
+	{
+		Swap(rhs);
+		return *this;
+	}
+	void Swap(Buffer &rhs)
+	{
+		std::swap(allocator_, rhs.allocator_);
+		std::swap(ring_, rhs.ring_);
+		std::swap(buffer_, rhs.buffer_);
+		std::swap(capacity_, rhs.capacity_);
+		std::swap(read_index_, rhs.read_index_);
+		std::swap(write_index_, rhs.write_index_);
+	}
 
+	// In ring mode the bytes before read_index_ alias the writable bytes.
 	int PrependableByte() const
 	{
-		return read_index_;
+		return (ring_ == false || read_index_ < WritableByte()) ? read_index_ : WritableByte();
 	}
 	int ReadableByte() const
 	{
@@ -43,53 +93,271 @@ public:
 	}
 	int WritableByte() const
 	{
-		return static_cast<int>(buffer_.size()) - write_index_;
+		return (ring_ ? read_index_ + capacity_ : capacity_) - write_index_;
 	}
+	int capacity() const
+	{
+		return capacity_;
+	}
+	bool ring_mode() const
+	{
+		return ring_;
+	}
+
+	// Ring mode maps one memfd of capacity() bytes twice, back to back, so that the
+	// readable bytes and then the writable bytes are always contiguous, wherever
+	// they wrap. Appending never compacts and retrieving only moves read_index_, at
+	// the cost of page-granular storage that bypasses the allocator. Switching
+	// copies the readable bytes into new storage. Mapping a ring can fail(EMFILE,
+	// vm.max_map_count): the buffer then stays or, when growing, becomes linear.
+	// Return whether the buffer is in the requested mode.
+	bool SetRingMode(bool on);
 	const char *ReadableBegin() const
 	{
 		return BufferBegin() + read_index_;
 	}
 
+	// Views of the readable bytes: valid until the buffer is next written or retrieved
+	// past them.
+	BufferView ReadableView() const
+	{
+		return BufferView(ReadableBegin(), ReadableByte());
+	}
+	BufferView PeekView(int length) const
+	{
+		assert(0 <= length && length <= ReadableByte());
+		return BufferView(ReadableBegin(), length);
+	}
+
+	// Search the readable bytes 32(AVX2)/16(SSE2) bytes at a time, byte by byte for
+	// the tail or when neither is enabled by -march. Return nullptr if not found.
 	const char *FindCRLF(const char *start) const;
 	const char *FindCRLF() const;
+	const char *FindEOL(const char *start) const;
+	const char *FindEOL() const;
+	const char *FindByte(const char *start, char byte) const;
+	const char *FindByte(char byte) const;
 
 	// Input API: Read from socket and store the data in buffer.
+	// readv() into the writable bytes and then `extra_buffer`, Append() what overflows.
+	// The 2 arguments version uses a 64KB stack array as `extra_buffer`; an EventLoop
+	// passes one array shared by all its connections instead.
 	int ReadFd(int fd, int &saved_errno);
+	int ReadFd(int fd, int &saved_errno, char *extra_buffer, int extra_size);
+	// For reads done elsewhere, e.g. by an io_uring request: fill at most
+	// WritableByte() bytes from WritableBegin(), then count them with HasWritten().
+	const char *WritableBegin() const
+	{
+		return BufferBegin() + write_index_;
+	}
+	char *WritableBegin()
+	{
+		return BufferBegin() + write_index_;
+	}
+	void HasWritten(int length)
+	{
+		assert(0 <= length && length <= WritableByte());
+		write_index_ += length;
+	}
+	// Make WritableByte() >= length: move readable bytes to the front or grow to at
+	// least twice the capacity.
+	void EnsureWritableByte(int length);
+	// Reallocate to fit the readable bytes plus `reserve` writable bytes.
+	// A no-op, without allocating, if that is not smaller than the current storage.
+	void Shrink(int reserve);
+	// Return the storage to the allocator in its loop thread and use malloc() from
+	// now on, so that the buffer can be destructed in any thread.
+	void DetachAllocator();
 	void Append(const std::string &data);
 	void Append(const char *data, int length);
 	void Prepend(const void *data, int length);
+	// Integers in network byte order. Each is a constant-size memcpy(), which
+	// compiles to one unaligned load/store, plus a bswap.
+	void AppendInt8(int8_t value)
+	{
+		AppendFixed(static_cast<uint8_t>(value));
+	}
+	void AppendInt16(int16_t value)
+	{
+		AppendFixed(HostToNetwork(static_cast<uint16_t>(value)));
+	}
+	void AppendInt32(int32_t value)
+	{
+		AppendFixed(HostToNetwork(static_cast<uint32_t>(value)));
+	}
+	void AppendInt64(int64_t value)
+	{
+		AppendFixed(HostToNetwork(static_cast<uint64_t>(value)));
+	}
+	void PrependInt8(int8_t value)
+	{
+		PrependFixed(static_cast<uint8_t>(value));
+	}
+	void PrependInt16(int16_t value)
+	{
+		PrependFixed(HostToNetwork(static_cast<uint16_t>(value)));
+	}
+	void PrependInt32(int32_t value)
+	{
+		PrependFixed(HostToNetwork(static_cast<uint32_t>(value)));
+	}
+	void PrependInt64(int64_t value)
+	{
+		PrependFixed(HostToNetwork(static_cast<uint64_t>(value)));
+	}
+	// Unsigned LEB128: 7 bits per byte, low group first, high bit set on all but the
+	// last byte. At most kMaxVarintByte bytes.
+	void AppendVarint(uint64_t value);
 
 	// Output API:
+	// write() the readable bytes and retrieve what was written.
+	int WriteFd(int fd, int &saved_errno);
 	std::string RetrieveAllAsString();
 	std::string RetrieveAsString(int length);
 	void Retrieve(int length);
 	void RetrieveUntil(const char *until);
 	void RetrieveAll();
 
-	int32_t PeekInt32();
+	int8_t PeekInt8() const
+	{
+		return static_cast<int8_t>(PeekFixed<uint8_t>());
+	}
+	int16_t PeekInt16() const
+	{
+		return static_cast<int16_t>(NetworkToHost(PeekFixed<uint16_t>()));
+	}
+	int32_t PeekInt32() const
+	{
+		return static_cast<int32_t>(NetworkToHost(PeekFixed<uint32_t>()));
+	}
+	int64_t PeekInt64() const
+	{
+		return static_cast<int64_t>(NetworkToHost(PeekFixed<uint64_t>()));
+	}
+	int8_t ReadInt8()
+	{
+		int8_t result = PeekInt8();
+		Retrieve(static_cast<int>(sizeof result));
+		return result;
+	}
+	int16_t ReadInt16()
+	{
+		int16_t result = PeekInt16();
+		Retrieve(static_cast<int>(sizeof result));
+		return result;
+	}
+	int32_t ReadInt32()
+	{
+		int32_t result = PeekInt32();
+		Retrieve(static_cast<int>(sizeof result));
+		return result;
+	}
+	int64_t ReadInt64()
+	{
+		int64_t result = PeekInt64();
+		Retrieve(static_cast<int>(sizeof result));
+		return result;
+	}
+	// Decode a varint at the readable front into `value` and return its length, or
+	// return 0 if the readable bytes end inside it and -1 if it is longer than
+	// kMaxVarintByte bytes or overflows uint64_t. ReadVarint() also retrieves it on
+	// success.
+	int PeekVarint(uint64_t &value) const;
+	int ReadVarint(uint64_t &value);
 
 private:
 	const char *BufferBegin() const
 	{
-		return buffer_.data();
+		return buffer_;
 	}
 	char *BufferBegin()
 	{
-		return buffer_.data();
+		return buffer_;
 	}
-	const char *WritableBegin() const
+	// Disjoint ranges go to memcpy(), overlapping ones(the compaction in
+	// EnsureWritableByte) to memmove(); glibc dispatches both to the SSE2/AVX2/ERMS
+	// kernel of this CPU. Inline so that a constant `length` such as sizeof(int32_t)
+	// becomes a single load/store instead of a call.
+	static void *MemoryCopy(void *dest, const void *src, size_t length)
 	{
-		return BufferBegin() + write_index_;
+		char *dest_ptr = static_cast<char*>(dest);
+		const char *src_ptr = static_cast<const char*>(src);
+		if(dest_ptr == nullptr || src_ptr == nullptr || dest_ptr == src_ptr)
+		{
+			return dest;
+		}
+		if(dest_ptr + length <= src_ptr || src_ptr + length <= dest_ptr)
+		{
+			return ::memcpy(dest, src, length);
+		}
+		return ::memmove(dest, src, length);
 	}
-	char *WritableBegin()
+
+	static uint16_t HostToNetwork(uint16_t value)
 	{
-		return BufferBegin() + write_index_;
+		return htobe16(value);
+	}
+	static uint32_t HostToNetwork(uint32_t value)
+	{
+		return htobe32(value);
+	}
+	static uint64_t HostToNetwork(uint64_t value)
+	{
+		return htobe64(value);
+	}
+	static uint16_t NetworkToHost(uint16_t value)
+	{
+		return be16toh(value);
+	}
+	static uint32_t NetworkToHost(uint32_t value)
+	{
+		return be32toh(value);
+	}
+	static uint64_t NetworkToHost(uint64_t value)
+	{
+		return be64toh(value);
+	}
+	// `value` is already in network byte order.
+	template<typename T>
+	void AppendFixed(T value)
+	{
+		if(WritableByte() < static_cast<int>(sizeof value))
+		{
+			EnsureWritableByte(static_cast<int>(sizeof value));
+		}
+		::memcpy(WritableBegin(), &value, sizeof value);
+		write_index_ += static_cast<int>(sizeof value);
+	}
+	template<typename T>
+	void PrependFixed(T value)
+	{
+		assert(PrependableByte() >= static_cast<int>(sizeof value));
+		read_index_ -= static_cast<int>(sizeof value);
+		::memcpy(BufferBegin() + read_index_, &value, sizeof value);
+	}
+	template<typename T>
+	T PeekFixed() const
+	{
+		assert(ReadableByte() >= static_cast<int>(sizeof(T)));
+		T value;
+		::memcpy(&value, ReadableBegin(), sizeof value);
+		return value;
 	}
 
-	void EnsureWritableByte(int length);
-	void *MemoryCopy(void *dest, const void *src, size_t length);
+	// The bytes AllocateStorage(capacity) really gets in the current mode.
+	int RoundCapacity(int capacity) const;
+	// Set buffer_ to at least `capacity` bytes, and capacity_ to what it really has.
+	Buffer(int initial_size, SlabAllocator *allocator, bool ring);
+
+	void AllocateStorage(int capacity);
+	void DeallocateStorage(char *buffer, int capacity);
 
-	std::vector<char> buffer_;
+	SlabAllocator *allocator_; // Unused in ring mode.
+	bool ring_;
+	// Linear mode: prependable + readable + writable bytes. Ring mode: the size of
+	// one mapping; read_index_ < capacity_ and the mirror holds bytes past it.
+	char *buffer_;
+	int capacity_;
 	int read_index_;
 	int write_index_;
 };
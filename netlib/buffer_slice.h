@@ -0,0 +1,66 @@
+#ifndef NETLIB_NETLIB_BUFFER_SLICE_H_
+#define NETLIB_NETLIB_BUFFER_SLICE_H_
+
+#include <memory> // shared_ptr<>
+
+#include <netlib/buffer_view.h>
+#include <netlib/copyable.h>
+#include <netlib/slab_pool.h>
+
+namespace netlib
+{
+
+// Interface:
+// Ctor(), Ctor(SlabPool*, const BufferView&)
+// Getter: view, data, length, empty
+// SubSlice
+
+// Reference counted bytes that outlive the message callback, e.g. a request handed
+// to a ThreadPool. The bytes are copied once into a pooled Slab; copies and
+// SubSlice()s share that slab, which returns to its pool with the last of them.
+class BufferSlice: public Copyable
+{
+public:
+	BufferSlice(): offset_(0), length_(0) {}
+	BufferSlice(SlabPool *pool, const BufferView &view):
+		slab_(pool->Copy(view.data(), view.length())),
+		offset_(0),
+		length_(view.length())
+	{}
+
+	BufferView view() const
+	{
+		return slab_ ? BufferView(slab_->data() + offset_, length_) : BufferView();
+	}
+	const char *data() const
+	{
+		return view().data();
+	}
+	int length() const
+	{
+		return length_;
+	}
+	bool empty() const
+	{
+		return length_ == 0;
+	}
+
+	// Share the slab, see BufferView::SubView() for the arguments.
+	BufferSlice SubSlice(int offset, int length) const
+	{
+		BufferView sub_view = view().SubView(offset, length);
+		BufferSlice result(*this);
+		result.offset_ = offset_ + offset;
+		result.length_ = sub_view.length();
+		return result;
+	}
+
+private:
+	std::shared_ptr<Slab> slab_;
+	int offset_;
+	int length_;
+};
+
+}
+
+#endif // NETLIB_NETLIB_BUFFER_SLICE_H_
@@ -0,0 +1,116 @@
+#ifndef NETLIB_NETLIB_BUFFER_VIEW_H_
+#define NETLIB_NETLIB_BUFFER_VIEW_H_
+
+#include <assert.h> // assert()
+#include <string.h> // memchr(), memcmp()
+
+#include <string>
+
+#include <netlib/copyable.h>
+
+namespace netlib
+{
+
+// Interface:
+// Ctor(), Ctor(const char*, int), Ctor(const string&)
+// Getter: data, length, empty, begin, end, operator[]
+// SubView
+// RemovePrefix, RemoveSuffix
+// Find
+// ToString
+// operator==, !=
+
+// Non-owning view of bytes, usually a readable range of a Buffer. It is valid until
+// the viewed Buffer is written, retrieved past it or destructed, so it must not
+// outlive the message callback; copy it into a BufferSlice to keep it longer.
+class BufferView: public Copyable
+{
+public:
+	BufferView(): data_(nullptr), length_(0) {}
+	BufferView(const char *data, int length): data_(data), length_(length)
+	{
+		assert(length >= 0);
+	}
+	BufferView(const std::string &data): // Implicit: a string is a view of itself.
+		data_(data.data()),
+		length_(static_cast<int>(data.size()))
+	{}
+
+	const char *data() const
+	{
+		return data_;
+	}
+	int length() const
+	{
+		return length_;
+	}
+	bool empty() const
+	{
+		return length_ == 0;
+	}
+	const char *begin() const
+	{
+		return data_;
+	}
+	const char *end() const
+	{
+		return data_ + length_;
+	}
+	char operator[](int index) const
+	{
+		assert(0 <= index && index < length_);
+		return data_[index];
+	}
+
+	// [offset, offset + length) of this view, clipped to its end.
+	BufferView SubView(int offset, int length) const
+	{
+		assert(0 <= offset && offset <= length_ && length >= 0);
+		return BufferView(data_ + offset, (length < length_ - offset) ? length : length_ - offset);
+	}
+	BufferView SubView(int offset) const
+	{
+		return SubView(offset, length_ - offset);
+	}
+	void RemovePrefix(int length)
+	{
+		assert(0 <= length && length <= length_);
+		data_ += length;
+		length_ -= length;
+	}
+	void RemoveSuffix(int length)
+	{
+		assert(0 <= length && length <= length_);
+		length_ -= length;
+	}
+
+	// Index of the first `byte`, or -1.
+	int Find(char byte) const
+	{
+		const void *found = (length_ > 0) ? ::memchr(data_, byte, length_) : nullptr;
+		return (found == nullptr) ? -1 : static_cast<int>(static_cast<const char*>(found) - data_);
+	}
+
+	std::string ToString() const
+	{
+		return std::string(data_, length_);
+	}
+
+	bool operator==(const BufferView &rhs) const
+	{
+		return length_ == rhs.length_ &&
+		       (length_ == 0 || ::memcmp(data_, rhs.data_, length_) == 0);
+	}
+	bool operator!=(const BufferView &rhs) const
+	{
+		return !(*this == rhs);
+	}
+
+private:
+	const char *data_;
+	int length_;
+};
+
+}
+
+#endif // NETLIB_NETLIB_BUFFER_VIEW_H_
@@ -0,0 +1,132 @@
+#include <netlib/chain_buffer.h>
+
+#include <assert.h> // assert()
+#include <errno.h> // errno
+#include <limits.h> // IOV_MAX
+#include <string.h> // memcpy()
+#include <sys/uio.h> // writev()
+
+#include <algorithm> // min()
+
+#include <netlib/slab_allocator.h>
+
+using std::string;
+using netlib::ChainBuffer;
+using netlib::SlabAllocator;
+
+ChainBuffer::ChainBuffer(SlabAllocator *allocator):
+	allocator_(allocator),
+	readable_byte_(0)
+{}
+
+ChainBuffer::~ChainBuffer()
+{
+	RetrieveAll();
+}
+
+void ChainBuffer::Append(const string &data)
+{
+	Append(data.data(), static_cast<int>(data.size()));
+}
+void ChainBuffer::Append(const char *data, int length)
+{
+	assert(length >= 0);
+	readable_byte_ += length;
+	while(length > 0)
+	{
+		if(block_deque_.empty() == true ||
+		        block_deque_.back().write_index == block_deque_.back().capacity)
+		{
+			Block block = {allocator_->Allocate(kBlockSize), 0, 0, kBlockSize, nullptr};
+			block_deque_.push_back(block);
+		}
+		Block &last = block_deque_.back();
+		int copy_byte = std::min(length, last.capacity - last.write_index);
+		::memcpy(last.data + last.write_index, data, copy_byte);
+		last.write_index += copy_byte;
+		data += copy_byte;
+		length -= copy_byte;
+	}
+}
+
+void ChainBuffer::AppendBlock(const std::shared_ptr<void> &owner,
+                              const char *data,
+                              int length)
+{
+	assert(owner && length >= 0);
+	if(length > 0)
+	{
+		// Never written through: Append() sees it full and takes a new block.
+		Block block = {const_cast<char*>(data), 0, length, length, owner};
+		block_deque_.push_back(block);
+		readable_byte_ += length;
+	}
+}
+
+void ChainBuffer::Retrieve(int length)
+{
+	assert(0 <= length && length <= readable_byte_);
+	if(length == readable_byte_)
+	{
+		RetrieveAll();
+		return;
+	}
+	readable_byte_ -= length;
+	while(length > 0)
+	{
+		Block &first = block_deque_.front();
+		int block_readable_byte = first.write_index - first.read_index;
+		if(length < block_readable_byte)
+		{
+			first.read_index += length;
+			break;
+		}
+		length -= block_readable_byte;
+		if(!first.owner)
+		{
+			allocator_->Deallocate(first.data, kBlockSize);
+		}
+		block_deque_.pop_front();
+	}
+}
+void ChainBuffer::RetrieveAll()
+{
+	for(BlockDeque::iterator it = block_deque_.begin(); it != block_deque_.end(); ++it)
+	{
+		if(!it->owner)
+		{
+			allocator_->Deallocate(it->data, kBlockSize);
+		}
+	}
+	block_deque_.clear(); // Release the owners of appended blocks.
+	readable_byte_ = 0;
+}
+
+int ChainBuffer::WriteFd(int fd, int &saved_errno)
+{
+	static const int kMaxIovecNumber = IOV_MAX;
+	struct iovec vec[kMaxIovecNumber];
+	int iovec_number = PeekIovec(vec, kMaxIovecNumber);
+	int write_byte = static_cast<int>(::writev(fd, vec, iovec_number));
+	if(write_byte > 0)
+	{
+		Retrieve(write_byte);
+	}
+	else if(write_byte < 0)
+	{
+		saved_errno = errno;
+	}
+	return write_byte;
+}
+int ChainBuffer::PeekIovec(struct iovec *vec, int max_number) const
+{
+	int iovec_number = 0;
+	for(BlockDeque::const_iterator it = block_deque_.begin();
+	        it != block_deque_.end() && iovec_number < max_number;
+	        ++it, ++iovec_number)
+	{
+		vec[iovec_number].iov_base = it->data + it->read_index;
+		vec[iovec_number].iov_len = it->write_index - it->read_index;
+	}
+	return iovec_number;
+}
@@ -0,0 +1,81 @@
+#ifndef NETLIB_NETLIB_CHAIN_BUFFER_H_
+#define NETLIB_NETLIB_CHAIN_BUFFER_H_
+
+#include <deque>
+#include <memory> // shared_ptr<>
+#include <string>
+
+#include <netlib/non_copyable.h>
+
+struct iovec;
+
+namespace netlib
+{
+
+class SlabAllocator;
+
+// Interface:
+// Ctor
+// Dtor -> +RetrieveAll
+// Getter: ReadableByte, BlockNumber
+// Append(const string&) -> Append(const char*, int)
+// AppendBlock
+// Retrieve -> +RetrieveAll
+// WriteFd -> +PeekIovec, +Retrieve
+// PeekIovec
+
+// Segmented output buffer: a list of fixed-size blocks taken from a SlabAllocator.
+// Append() fills the last block and then takes new ones, so queued bytes are never
+// moved or reallocated however much is queued; WriteFd() flushes up to IOV_MAX
+// blocks with one writev().
+class ChainBuffer: public NonCopyable
+{
+public:
+	static const int kBlockSize = 4 * 1024; // 4KB, one size class of SlabAllocator.
+
+	explicit ChainBuffer(SlabAllocator *allocator);
+	~ChainBuffer();
+
+	int ReadableByte() const
+	{
+		return readable_byte_;
+	}
+	int BlockNumber() const
+	{
+		return static_cast<int>(block_deque_.size());
+	}
+
+	void Append(const std::string &data);
+	void Append(const char *data, int length);
+	// Queue [data, data + length) as a read-only block that `owner` keeps alive until
+	// the block is retrieved.
+	void AppendBlock(const std::shared_ptr<void> &owner, const char *data, int length);
+	void Retrieve(int length);
+	void RetrieveAll(); // Return all blocks to the allocator.
+
+	// Write as much as the socket accepts and retrieve the written bytes.
+	int WriteFd(int fd, int &saved_errno);
+	// Point `vec` at the readable bytes of the first blocks, at most `max_number` of
+	// them, and return how many are filled. For writes done elsewhere, e.g. by an
+	// io_uring request, which then Retrieve() what they wrote.
+	int PeekIovec(struct iovec *vec, int max_number) const;
+
+private:
+	struct Block
+	{
+		char *data;
+		int read_index;
+		int write_index;
+		int capacity; // write_index == capacity: Append() must take a new block.
+		std::shared_ptr<void> owner; // Null for blocks from allocator_.
+	};
+	using BlockDeque = std::deque<Block>;
+
+	SlabAllocator *allocator_;
+	BlockDeque block_deque_;
+	int readable_byte_;
+};
+
+}
+
+#endif // NETLIB_NETLIB_CHAIN_BUFFER_H_
@@ -1,5 +1,7 @@
 #include <netlib/channel.h>
 
+#include <assert.h> // assert()
+
 #include <netlib/event_loop.h> // EventLoop
 #include <netlib/logging.h> // Log
 
@@ -10,7 +12,7 @@ using netlib::Channel;
 
 Channel::Channel(EventLoop *loop, int file_descriptor):
 	owner_loop_(loop),
-	state_in_epoller_(-1), // Epoller::kRaw.
+	state_in_epoller_(-1), // Poller::kRaw.
 	fd_(file_descriptor),
 	requested_event_(kNoneEvent),
 	returned_event_(kNoneEvent),
@@ -55,6 +57,18 @@ void Channel::set_requested_event(RequestedEventType type)
 	}
 	AddOrUpdateChannel();
 }
+void Channel::set_edge_triggered(bool on)
+{
+	if(on == true)
+	{
+		requested_event_ = kReadEvent | kWriteEvent | kEdgeTriggered;
+	}
+	else
+	{
+		requested_event_ &= ~(kWriteEvent | kEdgeTriggered);
+	}
+	AddOrUpdateChannel();
+}
 void Channel::AddOrUpdateChannel()
 {
 	owner_loop_->AddOrUpdateChannel(this);
@@ -165,7 +179,7 @@ string Channel::ReturnedEventToString() const
 }
 string Channel::EventToString(int fd, int event)
 {
-	char buffer[32];
+	char buffer[48];
 	char *ptr = buffer, *buffer_end = buffer + sizeof buffer;
 	ptr += snprintf(ptr, buffer_end - ptr, "%d: ", fd);
 	if(event & EPOLLIN)
@@ -192,5 +206,9 @@ string Channel::EventToString(int fd, int event)
 	{
 		ptr += snprintf(ptr, buffer_end - ptr, "%s", "ERR ");
 	}
+	if(event & EPOLLET)
+	{
+		ptr += snprintf(ptr, buffer_end - ptr, "%s", "ET ");
+	}
 	return buffer;
 }
@@ -16,8 +16,8 @@ class EventLoop;
 // Interface:
 // Ctor
 // Dtor
-// Getter: owner_loop, fd, requested_event, state_in_epoller
-// Setter:	set_requested_event -> -AddOrUpdateChannel
+// Getter: owner_loop, fd, requested_event, returned_event, state_in_epoller
+// Setter:	set_requested_event/set_edge_triggered -> -AddOrUpdateChannel
 //				set_returned_event, set_state_in_epoller, set_tie, set_event_callback
 // IsRequested
 // HandleEvent -> -HandleEventWithGuard
@@ -63,6 +63,10 @@ public:
 	{
 		return requested_event_;
 	}
+	int returned_event() const
+	{
+		return returned_event_;
+	}
 
 	// Setter
 	void set_state_in_epoller(int new_state)
@@ -70,6 +74,10 @@ public:
 		state_in_epoller_ = new_state;
 	}
 	void set_requested_event(RequestedEventType type);
+	// Request read and write events edge-triggered, in one epoll_ctl: the owner must
+	// then read and write until EAGAIN, and never switches WRITE_EVENT on or off.
+	// Turning it off keeps the read event only.
+	void set_edge_triggered(bool on);
 	void set_returned_event(int returned_event)
 	{
 		returned_event_ = returned_event;
@@ -94,6 +102,7 @@ private:
 	static const int kWriteEvent = EPOLLOUT;
 	static const int kCloseEvent = EPOLLHUP;
 	static const int kErrorEvent = EPOLLERR;
+	static const int kEdgeTriggered = EPOLLET;
 
 	EventLoop *owner_loop_;
 	int state_in_epoller_;
@@ -1,6 +1,10 @@
 #ifndef NETLIB_NETLIB_CONDITION_H_
 #define NETLIB_NETLIB_CONDITION_H_
 
+#include <errno.h> // ETIMEDOUT
+#include <stdint.h> // int64_t
+#include <time.h> // clock_gettime()
+
 #include <netlib/mutex.h> // MutexLock class.
 
 namespace netlib
@@ -12,6 +16,7 @@ namespace netlib
 // Ctor
 // Dtor
 // Wait
+// WaitForSecond
 // Signal
 // Broadcast
 class Condition: public NonCopyable
@@ -38,6 +43,23 @@ public:
 		MutexLock::UnassignHolderGuard guard(mutex_); // mutex_.holder_ = 0;
 		assert(pthread_cond_wait(&condition_, mutex_.get_pthread_mutex_t()) == 0);
 	}
+	// Wait() for at most `second`. Return true if timed out.
+	bool WaitForSecond(double second)
+	{
+		const int64_t kNanosecondPerSecond = 1000 * 1000 * 1000;
+		struct timespec absolute_time;
+		::clock_gettime(CLOCK_REALTIME, &absolute_time);
+		int64_t nanosecond = absolute_time.tv_nsec +
+		                     static_cast<int64_t>(second * static_cast<double>(kNanosecondPerSecond));
+		absolute_time.tv_sec += static_cast<time_t>(nanosecond / kNanosecondPerSecond);
+		absolute_time.tv_nsec = static_cast<long>(nanosecond % kNanosecondPerSecond);
+
+		mutex_.AssertLockedByThisThread();
+		MutexLock::UnassignHolderGuard guard(mutex_);
+		return pthread_cond_timedwait(&condition_,
+		                              mutex_.get_pthread_mutex_t(),
+		                              &absolute_time) == ETIMEDOUT;
+	}
 	void Signal()
 	{
 		assert(pthread_cond_signal(&condition_) == 0);
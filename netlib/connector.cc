@@ -1,5 +1,6 @@
 #include <netlib/connector.h>
 
+#include <assert.h> // assert()
 #include <unistd.h> // close()
 
 #include <netlib/channel.h>
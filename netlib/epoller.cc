@@ -3,7 +3,11 @@
 #include <assert.h> // assert()
 #include <strings.h> // bzero()
 #include <sys/epoll.h> // epoll()
-#include <unistd.h> // close()
+#include <sys/syscall.h> // SYS_epoll_pwait2
+#include <unistd.h> // close(), syscall()
+#include <errno.h> // errno, ENOSYS
+#include <limits.h> // INT_MAX
+#include <time.h> // timespec
 
 #include <netlib/channel.h>
 #include <netlib/event_loop.h>
@@ -13,9 +17,12 @@ using netlib::Epoller;
 using netlib::TimeStamp;
 
 Epoller::Epoller(EventLoop *owner_loop):
+	Poller(owner_loop),
 	epoll_fd_(CreateEpollFd()),
 	active_event_vector_(kInitialActiveEventVectorSize),
-	owner_loop_(owner_loop)
+	channel_table_(kInitialChannelTableSize, nullptr),
+	channel_number_(0),
+	precise_timeout_(false)
 {}
 int Epoller::CreateEpollFd()
 {
@@ -32,15 +39,64 @@ Epoller::~Epoller()
 	::close(epoll_fd_);
 }
 
-TimeStamp Epoller::EpollWait(int timeout, ChannelVector &active_channel)
+namespace
+{
+
+// Through syscall(): the glibc wrapper only exists since 2.35.
+int EpollPwait2(int epoll_fd,
+                struct epoll_event *event,
+                int max_event_number,
+                const struct timespec *timeout)
+{
+#if defined(SYS_epoll_pwait2)
+	return static_cast<int>(::syscall(SYS_epoll_pwait2,
+	                                  epoll_fd,
+	                                  event,
+	                                  max_event_number,
+	                                  timeout,
+	                                  nullptr,
+	                                  0));
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+}
+
+TimeStamp Epoller::Poll(int64_t timeout, ChannelVector &active_channel)
 {
 	AssertInLoopThread();
-	LOG_TRACE("total added channel number = %lu", channel_set_.size());
+	LOG_TRACE("total added channel number = %d", channel_number_);
 	int max_event_number = static_cast<int>(active_event_vector_.size());
-	int event_number = ::epoll_wait(epoll_fd_,
-	                                active_event_vector_.data(),
-	                                max_event_number,
-	                                timeout);
+	int event_number = -1;
+	bool waited = false;
+	if(timeout >= 0 && precise_timeout_ == true)
+	{
+		struct timespec ts;
+		ts.tv_sec = static_cast<time_t>(timeout / TimeStamp::kMicrosecondPerSecond);
+		ts.tv_nsec = static_cast<long>(timeout % TimeStamp::kMicrosecondPerSecond * 1000);
+		event_number = EpollPwait2(epoll_fd_,
+		                           active_event_vector_.data(),
+		                           max_event_number,
+		                           &ts);
+		waited = true;
+		if(event_number < 0 && errno == ENOSYS)
+		{
+			LOG_WARN("epoll_pwait2() is not supported, use millisecond epoll_wait().");
+			precise_timeout_ = false;
+			waited = false;
+		}
+	}
+	if(waited == false)
+	{
+		// Round up: waking before the first timer expires would only spin.
+		int64_t millisecond = (timeout < 0) ? -1 : (timeout + 999) / 1000;
+		event_number = ::epoll_wait(epoll_fd_,
+		                            active_event_vector_.data(),
+		                            max_event_number,
+		                            (millisecond < INT_MAX) ? static_cast<int>(millisecond) : INT_MAX);
+	}
 	TimeStamp epoll_return_time(TimeStamp::Now());
 	int saved_errno = errno; // NOTE: Must handle error.
 	if(event_number > 0)
@@ -72,26 +128,18 @@ TimeStamp Epoller::EpollWait(int timeout, ChannelVector &active_channel)
 	}
 	return epoll_return_time;
 }
-void Epoller::AssertInLoopThread() const // Must be in IO thread.
-{
-	owner_loop_->AssertInLoopThread();
-}
-
-namespace
-{
-const int kRaw = -1; // Not in channel_set_.
-const int kAdded = 1; // In channel_set_ and Added into epoll's RB-Tree.
-const int kDeleted = 0; // In channel_set_ and Deleted from epoll's RB-Tree.
+// kRaw: not in channel_table_.
+// kAdded: in channel_table_ and Added into epoll's RB-Tree.
+// kDeleted: in channel_table_ and Deleted from epoll's RB-Tree.
 // kRaw ->
-// 1.	kAdded. AOUC() {channel_set_.insert() -> ADD}
+// 1.	kAdded. AOUC() {channel_table_[fd] = channel -> ADD}
 // kAdded ->
-// 1.	kRaw. RC() {DEL -> channel_set_.erase()}
+// 1.	kRaw. RC() {DEL -> channel_table_[fd] = nullptr}
 // 2.	kAdded. AOUC() {if(IsRequested(NoneEvent) == false) MOD}
 // 3.	kDeleted. AOUC() {if(IR(NE) == true) DEL}
 // kDeleted ->
-// 1.	kRaw. RC() {channel_set_.erase()}
+// 1.	kRaw. RC() {channel_table_[fd] = nullptr}
 // 2.	kAdded. AOUC() {ADD}
-}
 void Epoller::AddOrUpdateChannel(Channel *channel)
 {
 	AssertInLoopThread();
@@ -101,16 +149,15 @@ void Epoller::AddOrUpdateChannel(Channel *channel)
 	switch(channel_state)
 	{
 	case kRaw:
-		assert(channel_set_.find(channel) == channel_set_.end());
-		channel_set_.insert(channel);
-	// NO `break;` to avoid duplicate codes!
+		InsertChannel(channel);
+	// Fall through - no `break;` to avoid duplicate codes.
 	case kDeleted:
-		assert(channel_set_.find(channel) != channel_set_.end());
+		assert(HasChannel(channel) == true);
 		EpollCtl(EPOLL_CTL_ADD, channel);
 		channel->set_state_in_epoller(kAdded);
 		break;
 	case kAdded:
-		assert(channel_set_.find(channel) != channel_set_.end());
+		assert(HasChannel(channel) == true);
 		if(channel->IsRequested(Channel::NONE_EVENT) == true)
 		{
 			EpollCtl(EPOLL_CTL_DEL, channel);
@@ -134,6 +181,7 @@ void Epoller::EpollCtl(int operation, Channel *channel)
 	int fd = channel->fd();
 	LOG_TRACE("epoll_ctl operation = %s, fd = %d, requested_event = {%s}",
 	          OperationToCString(operation), fd, channel->RequestedEventToString().c_str());
+	++control_number_;
 	if(::epoll_ctl(epoll_fd_, operation, fd, &event) == -1)
 	{
 		LOG_FATAL("epoll_ctl(): FATAL. operation = %s fd = %d",
@@ -165,12 +213,30 @@ void Epoller::RemoveChannel(Channel *channel)
 	{
 		EpollCtl(EPOLL_CTL_DEL, channel);
 	}
-	assert(channel_set_.erase(channel) == 1);
+	assert(HasChannel(channel) == true);
+	channel_table_[channel->fd()] = nullptr;
+	--channel_number_;
 	channel->set_state_in_epoller(kRaw);
 }
+void Epoller::InsertChannel(Channel *channel)
+{
+	int fd = channel->fd();
+	assert(fd >= 0);
+	int size = static_cast<int>(channel_table_.size());
+	if(fd >= size)
+	{
+		channel_table_.resize((fd < size * 2) ? size * 2 : fd + 1, nullptr);
+	}
+	assert(channel_table_[fd] == nullptr);
+	channel_table_[fd] = channel;
+	++channel_number_;
+}
 
 bool Epoller::HasChannel(Channel *channel) const
 {
 	AssertInLoopThread();
-	return channel_set_.find(channel) != channel_set_.end();
+	int fd = channel->fd();
+	return fd >= 0 &&
+	       fd < static_cast<int>(channel_table_.size()) &&
+	       channel_table_[fd] == channel;
 }
@@ -1,10 +1,11 @@
 #ifndef NETLIB_NETLIB_EPOLLER_H_
 #define NETLIB_NETLIB_EPOLLER_H_
 
-#include <set>
+#include <stdint.h> // int64_t
+
 #include <vector>
 
-#include <netlib/non_copyable.h>
+#include <netlib/poller.h>
 #include <netlib/time_stamp.h>
 
 struct epoll_event; // Forward declaration, don't need include <sys/epoll.h>
@@ -12,45 +13,52 @@ struct epoll_event; // Forward declaration, don't need include <sys/epoll.h>
 namespace netlib
 {
 
-class EventLoop;
-class Channel;
-
 // Interface:
 // Ctor -> -CreateEpollFd
 // Dtor
-// EpollWait -> -AssertInLoopThread
-// AddOrUpdateChannel -> -AssertInLoopThread -> -EpollCtl
+// Setter: precise_timeout
+// Poll -> -AssertInLoopThread
+// AddOrUpdateChannel -> -AssertInLoopThread -> -InsertChannel -> -EpollCtl
 //			-EpollCtl -> -OperationToCString
 // RemoveChannel -> -AssertInLoopThread -> -EpollCtl.
 // HasChannel -> -AssertInLoopThread.
 
-class Epoller: public NonCopyable
+class Epoller: public Poller
 {
 public:
-	using ChannelVector = std::vector<Channel*>;
+	explicit Epoller(EventLoop *owner_loop);
+	~Epoller() override;
 
-	Epoller(EventLoop *owner_loop);
-	~Epoller();
+	// Wait with microsecond precision through epoll_pwait2(), instead of rounding the
+	// timeout up to milliseconds for epoll_wait(). Turned off again if the kernel
+	// lacks epoll_pwait2()(before Linux 5.11).
+	void set_precise_timeout(bool on) override
+	{
+		precise_timeout_ = on;
+	}
 
-	TimeStamp EpollWait(int timeout_in_millisecond, ChannelVector &active_channel);
-	void AddOrUpdateChannel(Channel *channel);
-	void RemoveChannel(Channel *channel);
-	bool HasChannel(Channel *channel) const;
+	TimeStamp Poll(int64_t timeout_in_microsecond, ChannelVector &active_channel) override;
+	void AddOrUpdateChannel(Channel *channel) override;
+	void RemoveChannel(Channel *channel) override;
+	bool HasChannel(Channel *channel) const override;
 
 private:
 	using EpollEventVector = std::vector<struct epoll_event>;
-	using ChannelSet = std::set<Channel*>;
+	// Indexed by fd: the kernel hands out the lowest free fd, so the table stays dense.
+	using ChannelTable = std::vector<Channel*>;
 
 	int CreateEpollFd();
-	void AssertInLoopThread() const;
+	void InsertChannel(Channel *channel);
 	void EpollCtl(int operation, Channel *channel);
 	static const char *OperationToCString(int operation);
 
 	int epoll_fd_;
 	EpollEventVector active_event_vector_;
 	static const int kInitialActiveEventVectorSize = 16;
-	EventLoop *owner_loop_;
-	ChannelSet channel_set_;
+	static const int kInitialChannelTableSize = 64;
+	ChannelTable channel_table_;
+	int channel_number_; // Number of non-null entries in channel_table_.
+	bool precise_timeout_;
 };
 
 }
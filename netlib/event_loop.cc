@@ -7,18 +7,45 @@
 #include <signal.h> // signal()
 
 #include <netlib/channel.h>
+#include <netlib/idle_connection_ring.h>
+#include <netlib/io_uring_poller.h>
 #include <netlib/logging.h>
-#include <netlib/epoller.h>
+#include <netlib/poller.h>
+#include <netlib/slab_allocator.h>
+#include <netlib/slab_pool.h>
 #include <netlib/thread.h>
 #include <netlib/timer_queue.h>
 
 using std::bind;
 using netlib::EventLoop;
+using netlib::EventLoopMetrics;
+using netlib::IdleConnectionRing;
+using netlib::IoUringPoller;
+using netlib::Logger;
 using netlib::Thread;
 using netlib::TimerId;
 using netlib::TimerCallback;
 using netlib::TimeStamp;
 
+namespace
+{
+
+// Counters have a single writer, the loop thread: a plain load and store is enough,
+// with no locked instruction on the hot path.
+void AddTo(std::atomic<int64_t> &counter, int64_t value)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+void MaxTo(std::atomic<int64_t> &counter, int64_t value)
+{
+	if(value > counter.load(std::memory_order_relaxed))
+	{
+		counter.store(value, std::memory_order_relaxed);
+	}
+}
+
+}
+
 struct IgnoreSigPipe
 {
 	IgnoreSigPipe()
@@ -29,17 +56,39 @@ struct IgnoreSigPipe
 IgnoreSigPipe ignore_sig_pipe_object;
 
 __thread EventLoop *t_loop_in_this_thread = nullptr;
-EventLoop::EventLoop():
+EventLoop::EventLoop(const EventLoopOption &option):
 	looping_(false),
 	quit_(false),
 	thread_id_(Thread::ThreadId()),
-	epoller_(new Epoller(this)),
+	option_(option),
+	slab_allocator_(new SlabAllocator(this)),
+	slab_pool_(new SlabPool()),
+	idle_connection_ring_(),
+	poller_(Poller::NewPoller(this, option)),
+	io_uring_poller_(dynamic_cast<IoUringPoller*>(poller_.get())),
 	epoll_return_time_(),
-	timer_queue_(new TimerQueue(this)),
+	timer_queue_(new TimerQueue(this, option_)),
 	event_fd_(CreateEventFd()),
 	event_fd_channel_(new Channel(this, event_fd_)),
-	mutex_(),
-	doing_task_callback_(false)
+	task_queue_(),
+	doing_task_callback_(false),
+	wakeup_pending_(false),
+	wakeup_write_number_(0),
+	saved_wakeup_number_(0),
+	extra_read_buffer_(kExtraReadBufferSize),
+	iteration_number_(0),
+	event_number_(0),
+	max_event_number_(0),
+	io_microsecond_(0),
+	timer_microsecond_(0),
+	task_microsecond_(0),
+	task_number_(0),
+	max_task_number_(0),
+	slowest_callback_microsecond_(0),
+	busy_poll_spin_microsecond_(0),
+	busy_poll_work_microsecond_(0),
+	dispatch_start_microsecond_(0),
+	dispatch_fd_(kTaskDispatch)
 {
 	LOG_DEBUG("EventLoop created %p in thread %d", this, thread_id_);
 	// One loop per thread: every thread can have only one EventLoop object.
@@ -52,6 +101,8 @@ EventLoop::EventLoop():
 	event_fd_channel_->set_event_callback(Channel::READ_CALLBACK,
 	                                      bind(&EventLoop::HandleRead, this));
 	event_fd_channel_->set_requested_event(Channel::READ_EVENT);
+	poller_->set_precise_timeout(option_.timer_mode == EventLoopOption::EPOLL_TIMEOUT &&
+	                             option_.precise_timeout == true);
 }
 int EventLoop::CreateEventFd()
 {
@@ -93,7 +144,7 @@ void EventLoop::AssertInLoopThread()
 	}
 }
 
-void EventLoop::RunInLoop(const TaskCallback &task_callback)
+void EventLoop::RunInLoop(TaskCallback &&task_callback)
 {
 	if(IsInLoopThread() == true)
 	{
@@ -101,15 +152,12 @@ void EventLoop::RunInLoop(const TaskCallback &task_callback)
 	}
 	else
 	{
-		QueueInLoop(task_callback);
+		QueueInLoop(std::move(task_callback));
 	}
 }
-void EventLoop::QueueInLoop(const TaskCallback &task_callback)
+void EventLoop::QueueInLoop(TaskCallback &&task_callback)
 {
-	{
-		MutexLockGuard lock(mutex_);
-		task_callback_vector_.push_back(task_callback);
-	}
+	task_queue_.Push(std::move(task_callback));
 	if(IsInLoopThread() == false || doing_task_callback_ == true)
 	{
 		Wakeup();
@@ -117,6 +165,13 @@ void EventLoop::QueueInLoop(const TaskCallback &task_callback)
 }
 void EventLoop::Wakeup()
 {
+	// Release: the loop that clears the flag sees the task queued before this call.
+	if(wakeup_pending_.exchange(true, std::memory_order_acq_rel) == true)
+	{
+		saved_wakeup_number_.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	wakeup_write_number_.fetch_add(1, std::memory_order_relaxed);
 	uint64_t one = 1;
 	int write_byte = static_cast<int>(::write(event_fd_, &one, sizeof one));
 	if(write_byte != sizeof one)
@@ -125,44 +180,61 @@ void EventLoop::Wakeup()
 	}
 }
 
-TimerId EventLoop::RunAt(const TimerCallback &callback, const TimeStamp &time)
+TimerId EventLoop::RunAt(TimerCallback &&callback, const TimeStamp &time, double slack)
 {
-	return timer_queue_->AddTimer(callback, time, 0.0);
+	return timer_queue_->AddTimer(std::move(callback), time, 0.0, slack);
 }
-TimerId EventLoop::RunAfter(const TimerCallback &callback, double delay)
+TimerId EventLoop::RunAfter(TimerCallback &&callback, double delay, double slack)
 {
-	return timer_queue_->AddTimer(callback,
+	return timer_queue_->AddTimer(std::move(callback),
 	                              AddTime(TimeStamp::Now(), delay),
-	                              0.0);
+	                              0.0,
+	                              slack);
 }
-TimerId EventLoop::RunEvery(const TimerCallback &callback, double interval)
+TimerId EventLoop::RunEvery(TimerCallback &&callback, double interval, double slack)
 {
-	return timer_queue_->AddTimer(callback,
+	return timer_queue_->AddTimer(std::move(callback),
 	                              AddTime(TimeStamp::Now(), interval),
-	                              interval);
+	                              interval,
+	                              slack);
 }
 void EventLoop::CancelTimer(const TimerId &timer_id)
 {
 	timer_queue_->CancelTimer(timer_id);
 }
 
+IdleConnectionRing *EventLoop::idle_connection_ring()
+{
+	AssertInLoopThread();
+	if(!idle_connection_ring_)
+	{
+		idle_connection_ring_.reset(
+		    new IdleConnectionRing(this, option_.idle_timeout_tick_microsecond));
+	}
+	return idle_connection_ring_.get();
+}
+
 void EventLoop::AddOrUpdateChannel(Channel *channel)
 {
 	assert(channel->owner_loop() == this);
 	AssertInLoopThread();
-	epoller_->AddOrUpdateChannel(channel);
+	poller_->AddOrUpdateChannel(channel);
 }
 void EventLoop::RemoveChannel(Channel *channel)
 {
 	assert(channel->owner_loop() == this);
 	AssertInLoopThread();
-	epoller_->RemoveChannel(channel);
+	poller_->RemoveChannel(channel);
+}
+int64_t EventLoop::poller_control_number() const
+{
+	return poller_->control_number();
 }
 bool EventLoop::HasChannel(Channel *channel)
 {
 	assert(channel->owner_loop() == this);
 	AssertInLoopThread();
-	return epoller_->HasChannel(channel);
+	return poller_->HasChannel(channel);
 }
 
 void EventLoop::Loop()
@@ -172,18 +244,85 @@ void EventLoop::Loop()
 	LOG_TRACE("EventLoop %p start looping.", this);
 
 	looping_ = true;
+	const bool timer_fd_mode = (option_.timer_mode == EventLoopOption::TIMER_FD);
+	const int64_t spin_budget = option_.busy_poll_microsecond;
+	int64_t spin_deadline = 0; // Poll without blocking until then.
 	while(quit_ == false)
 	{
 		active_channel_vector_.clear();
-		epoll_return_time_ = epoller_->EpollWait(-1, active_channel_vector_);
-		PrintActiveChannel();
+		// EPOLL_TIMEOUT: sleep no longer than until the first timer expires. A timer
+		// added meanwhile comes through QueueInLoop(), whose wakeup ends the wait.
+		int64_t timeout = timer_fd_mode ? -1 : timer_queue_->TimeoutInMicrosecond(TimeStamp::Now());
+		int64_t poll_start = 0;
+		bool spinning = false;
+		if(spin_budget > 0)
+		{
+			poll_start = TimeStamp::Now().microsecond();
+			spinning = (poll_start < spin_deadline);
+		}
+		epoll_return_time_ = poller_->Poll(spinning ? 0 : timeout, active_channel_vector_);
+		if(Logger::TRACE >= Logger::log_level()) // Don't build the strings for nothing.
+		{
+			PrintActiveChannel();
+		}
+		// One clock read per callback: each one ends where the next starts.
+		int64_t slowest = 0;
+		int64_t start = epoll_return_time_.microsecond(), end = start;
 		for(ChannelVector::iterator it = active_channel_vector_.begin();
 		        it != active_channel_vector_.end();
 		        ++it)
 		{
+			BeginDispatch((*it)->fd(), end);
 			(*it)->HandleEvent(epoll_return_time_);
+			int64_t now = TimeStamp::Now().microsecond();
+			slowest = (now - end > slowest) ? now - end : slowest;
+			end = now;
+		}
+		if(io_uring_poller_ != nullptr)
+		{
+			BeginDispatch(kCompletionDispatch, end);
+			io_uring_poller_->RunCompletion(epoll_return_time_);
+			int64_t now = TimeStamp::Now().microsecond();
+			slowest = (now - end > slowest) ? now - end : slowest;
+			end = now;
+		}
+		int64_t io_end = end;
+		if(timeout >= 0)
+		{
+			BeginDispatch(kTimerDispatch, end);
+			timer_queue_->RunExpiredTimer(TimeStamp(end));
+			end = TimeStamp::Now().microsecond();
+			slowest = (end - io_end > slowest) ? end - io_end : slowest;
+		}
+		int64_t timer_end = end;
+		BeginDispatch(kTaskDispatch, end);
+		int task_number = DoTaskCallback();
+		end = TimeStamp::Now().microsecond();
+		dispatch_start_microsecond_.store(0, std::memory_order_relaxed);
+		slowest = (end - timer_end > slowest) ? end - timer_end : slowest;
+
+		int event_number = static_cast<int>(active_channel_vector_.size());
+		AddTo(iteration_number_, 1);
+		AddTo(event_number_, event_number);
+		MaxTo(max_event_number_, event_number);
+		AddTo(io_microsecond_, io_end - start);
+		AddTo(timer_microsecond_, timer_end - io_end);
+		AddTo(task_microsecond_, end - timer_end);
+		AddTo(task_number_, task_number);
+		MaxTo(max_task_number_, task_number);
+		MaxTo(slowest_callback_microsecond_, slowest);
+		if(spin_budget > 0)
+		{
+			if(event_number > 0 || task_number > 0)
+			{
+				AddTo(busy_poll_work_microsecond_, end - start);
+				spin_deadline = end + spin_budget; // Busy: more is likely to come soon.
+			}
+			else if(spinning == true)
+			{
+				AddTo(busy_poll_spin_microsecond_, end - poll_start);
+			}
 		}
-		DoTaskCallback();
 	}
 	looping_ = false;
 
@@ -198,21 +337,36 @@ void EventLoop::PrintActiveChannel() const
 		LOG_TRACE("{%s}", (*it)->ReturnedEventToString().c_str());
 	}
 }
-void EventLoop::DoTaskCallback()
+int EventLoop::DoTaskCallback()
 {
 	doing_task_callback_ = true;
-	TaskCallbackVector local_task_callback_vector;
-	{
-		MutexLockGuard lock(mutex_);
-		local_task_callback_vector.swap(task_callback_vector_);
-	}
-	for(TaskCallbackVector::iterator it = local_task_callback_vector.begin();
-	        it != local_task_callback_vector.end();
-	        ++it)
-	{
-		(*it)();
-	}
+	// Clear before taking the tasks: a task queued after this is either taken below
+	// or followed by a new write. Acquire pairs with the release in Wakeup().
+	wakeup_pending_.exchange(false, std::memory_order_acquire);
+	int task_number = task_queue_.RunAll();
 	doing_task_callback_ = false;
+	return task_number;
+}
+
+EventLoopMetrics EventLoop::Metrics() const
+{
+	EventLoopMetrics metrics;
+	metrics.time = TimeStamp::Now();
+	metrics.iteration_number = iteration_number_.load(std::memory_order_relaxed);
+	metrics.event_number = event_number_.load(std::memory_order_relaxed);
+	metrics.max_event_number = max_event_number_.load(std::memory_order_relaxed);
+	metrics.io_microsecond = io_microsecond_.load(std::memory_order_relaxed);
+	metrics.timer_microsecond = timer_microsecond_.load(std::memory_order_relaxed);
+	metrics.task_microsecond = task_microsecond_.load(std::memory_order_relaxed);
+	metrics.task_number = task_number_.load(std::memory_order_relaxed);
+	metrics.max_task_number = max_task_number_.load(std::memory_order_relaxed);
+	metrics.slowest_callback_microsecond =
+	    slowest_callback_microsecond_.load(std::memory_order_relaxed);
+	metrics.busy_poll_spin_microsecond = busy_poll_spin_microsecond_.load(std::memory_order_relaxed);
+	metrics.busy_poll_work_microsecond = busy_poll_work_microsecond_.load(std::memory_order_relaxed);
+	metrics.wakeup_write_number = wakeup_write_number();
+	metrics.saved_wakeup_number = saved_wakeup_number();
+	return metrics;
 }
 
 void EventLoop::Quit()
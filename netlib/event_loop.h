@@ -1,11 +1,17 @@
 #ifndef NETLIB_NETLIB_EVENTLOOP_H_
 #define NETLIB_NETLIB_EVENTLOOP_H_
 
+#include <stdint.h> // int64_t
+
+#include <atomic>
 #include <vector> // vector<>
 
+#include <netlib/event_loop_metrics.h>
+#include <netlib/event_loop_option.h>
 #include <netlib/function.h>
-#include <netlib/mutex.h>
+#include <netlib/mpsc_task_queue.h>
 #include <netlib/non_copyable.h>
+#include <netlib/thread.h>
 #include <netlib/timer_id.h>
 #include <netlib/time_stamp.h>
 
@@ -13,7 +19,11 @@ namespace netlib
 {
 
 class Channel;
-class Epoller;
+class IdleConnectionRing;
+class IoUringPoller;
+class Poller;
+class SlabAllocator;
+class SlabPool;
 class TimerQueue;
 
 // Interface:
@@ -32,13 +42,22 @@ class TimerQueue;
 // HasChannel -> +AssertInLoopThread.
 // Loop -> +AssertInLoopThread -> -PrintActiveChannel -> -DoTaskCallback
 // Quit -> -Wakeup
+// Metrics
+// Getter: option, thread_id, slab_allocator, slab_pool, idle_connection_ring,
+//			io_uring_poller, extra_read_buffer,
+//			wakeup_write_number, saved_wakeup_number, poller_control_number,
+//			iteration_number, dispatch_start_microsecond, dispatch_fd
 
 class EventLoop: public NonCopyable
 {
 public:
-	using TaskCallbackVector = std::vector<TaskCallback>;
+	static const int kExtraReadBufferSize = 64 * 1024; // 64KB
+	// dispatch_fd() when the loop thread is not in a channel callback.
+	static const int kTimerDispatch = -1; // Timers run after the wait(EPOLL_TIMEOUT).
+	static const int kTaskDispatch = -2; // Queued tasks.
+	static const int kCompletionDispatch = -3; // IoUringPoller's request callbacks.
 
-	EventLoop();
+	explicit EventLoop(const EventLoopOption &option = EventLoopOption());
 	~EventLoop(); // Force outline dtor, for unique_ptr members.
 	void AssertInLoopThread();
 	bool IsInLoopThread() const
@@ -46,12 +65,17 @@ public:
 		return thread_id_ == Thread::ThreadId();
 	}
 
-	void RunInLoop(const TaskCallback&);
-	void QueueInLoop(const TaskCallback&);
+	// Tasks and timer callbacks are moved in: pass a temporary(a lambda, a bind()) or
+	// std::move() one; any other callable is copied into a new Task first.
+	void RunInLoop(TaskCallback &&task_callback);
+	void QueueInLoop(TaskCallback &&task_callback);
 
-	TimerId RunAt(const TimerCallback &callback, const TimeStamp &time_stamp);
-	TimerId RunAfter(const TimerCallback &callback, double delay);
-	TimerId RunEvery(const TimerCallback &callback, double interval);
+	// `slack` seconds of lateness allowed: timers due within each other's slack run in
+	// the same wakeup, e.g. thousands of heartbeats. RunEvery() keeps to the multiples
+	// of `interval` from its first run, whatever the delays.
+	TimerId RunAt(TimerCallback &&callback, const TimeStamp &time_stamp, double slack = 0.0);
+	TimerId RunAfter(TimerCallback &&callback, double delay, double slack = 0.0);
+	TimerId RunEvery(TimerCallback &&callback, double interval, double slack = 0.0);
 	void CancelTimer(const TimerId &timer_id);
 
 	void AddOrUpdateChannel(Channel *channel);
@@ -61,6 +85,66 @@ public:
 	void Loop();
 	void Quit();
 
+	const EventLoopOption &option() const
+	{
+		return option_;
+	}
+	int thread_id() const
+	{
+		return thread_id_;
+	}
+	SlabAllocator *slab_allocator()
+	{
+		return slab_allocator_.get();
+	}
+	SlabPool *slab_pool()
+	{
+		return slab_pool_.get();
+	}
+	// Created by the first connection with an idle timeout. Call in the loop thread.
+	IdleConnectionRing *idle_connection_ring();
+	// The poller if it is an IoUringPoller, whose requests the connections and
+	// acceptors of this loop then use instead of readiness. Else nullptr.
+	IoUringPoller *io_uring_poller()
+	{
+		return io_uring_poller_;
+	}
+	// Overflow space of Buffer::ReadFd() shared by all connections of this loop.
+	char *extra_read_buffer()
+	{
+		return extra_read_buffer_.data();
+	}
+	// Wakeup()s that wrote event_fd_, and those skipped because one was pending.
+	int64_t wakeup_write_number() const
+	{
+		return wakeup_write_number_.load(std::memory_order_relaxed);
+	}
+	int64_t saved_wakeup_number() const
+	{
+		return saved_wakeup_number_.load(std::memory_order_relaxed);
+	}
+	// Registration changes sent to the poller's kernel object, see
+	// Poller::control_number(). Read in the loop thread.
+	int64_t poller_control_number() const;
+	// Snapshot of the loop's counters. Safe to call from any thread.
+	EventLoopMetrics Metrics() const;
+	// What the loop thread is doing, for LoopWatchdog. Any thread. The start time of
+	// the callback being run, 0 if the loop is waiting; and the fd of its channel or
+	// kTimerDispatch/kTaskDispatch/kCompletionDispatch. The two are stored apart: read
+	// the start again to check that the fd belongs to it.
+	int64_t iteration_number() const
+	{
+		return iteration_number_.load(std::memory_order_relaxed);
+	}
+	int64_t dispatch_start_microsecond() const
+	{
+		return dispatch_start_microsecond_.load(std::memory_order_acquire);
+	}
+	int dispatch_fd() const
+	{
+		return dispatch_fd_.load(std::memory_order_relaxed);
+	}
+
 private:
 	using ChannelVector = std::vector<Channel*>;
 
@@ -68,20 +152,52 @@ private:
 	void HandleRead();
 	void Wakeup();
 	void PrintActiveChannel() const;
-	void DoTaskCallback();
+	int DoTaskCallback(); // Return the number of tasks run.
+	void BeginDispatch(int fd, int64_t start_microsecond)
+	{
+		// fd first: a reader that sees this start sees this fd, or a later one.
+		dispatch_fd_.store(fd, std::memory_order_relaxed);
+		dispatch_start_microsecond_.store(start_microsecond, std::memory_order_release);
+	}
 
 	bool looping_; // FIXME: Atomic.
 	bool quit_; // FIXME: Atomic.
 	const int thread_id_; // TID of thread that creates this EventLoop object.
-	std::unique_ptr<Epoller> epoller_;
+	const EventLoopOption option_;
+	// Pools are declared first so that they are destructed last: pending tasks and
+	// timers may hold connections and slabs that return memory to them.
+	std::unique_ptr<SlabAllocator> slab_allocator_; // Storage of connections' buffers.
+	std::unique_ptr<SlabPool> slab_pool_; // Payloads sent from other threads.
+	std::unique_ptr<IdleConnectionRing> idle_connection_ring_; // Links connections.
+	std::unique_ptr<Poller> poller_;
+	IoUringPoller *io_uring_poller_; // poller_, or nullptr if it is an Epoller.
 	ChannelVector active_channel_vector_;
 	TimeStamp epoll_return_time_;
 	std::unique_ptr<TimerQueue> timer_queue_;
 	int event_fd_;
 	std::unique_ptr<Channel> event_fd_channel_;
-	MutexLock mutex_;
-	TaskCallbackVector task_callback_vector_; // Guarded by mutex_.
+	MpscTaskQueue task_queue_; // Pushed by any thread, run by the loop thread.
 	bool doing_task_callback_; // FIXME: Atomic.
+	// Set by the Wakeup() that writes event_fd_, cleared by DoTaskCallback() before
+	// it runs the tasks: at most one write per loop cycle however many are queued.
+	std::atomic<bool> wakeup_pending_;
+	std::atomic<int64_t> wakeup_write_number_;
+	std::atomic<int64_t> saved_wakeup_number_;
+	std::vector<char> extra_read_buffer_;
+	// Counters of Metrics(): written by the loop thread only, read by any thread.
+	std::atomic<int64_t> iteration_number_;
+	std::atomic<int64_t> event_number_;
+	std::atomic<int64_t> max_event_number_;
+	std::atomic<int64_t> io_microsecond_;
+	std::atomic<int64_t> timer_microsecond_;
+	std::atomic<int64_t> task_microsecond_;
+	std::atomic<int64_t> task_number_;
+	std::atomic<int64_t> max_task_number_;
+	std::atomic<int64_t> slowest_callback_microsecond_;
+	std::atomic<int64_t> busy_poll_spin_microsecond_;
+	std::atomic<int64_t> busy_poll_work_microsecond_;
+	std::atomic<int64_t> dispatch_start_microsecond_;
+	std::atomic<int> dispatch_fd_;
 };
 
 }
@@ -0,0 +1,73 @@
+#ifndef NETLIB_NETLIB_EVENT_LOOP_METRICS_H_
+#define NETLIB_NETLIB_EVENT_LOOP_METRICS_H_
+
+#include <stdint.h> // int64_t
+
+#include <netlib/copyable.h>
+#include <netlib/time_stamp.h>
+
+namespace netlib
+{
+
+// Interface:
+// Ctor
+// Saturation
+
+// A snapshot of the counters of one EventLoop, see EventLoop::Metrics(). Each field
+// is read on its own, so fields may be a loop iteration apart from each other.
+// Counters only grow: a stats timer diffs two snapshots to get rates.
+struct EventLoopMetrics: public Copyable
+{
+	EventLoopMetrics():
+		time(),
+		iteration_number(0),
+		event_number(0),
+		max_event_number(0),
+		io_microsecond(0),
+		timer_microsecond(0),
+		task_microsecond(0),
+		task_number(0),
+		max_task_number(0),
+		slowest_callback_microsecond(0),
+		busy_poll_spin_microsecond(0),
+		busy_poll_work_microsecond(0),
+		wakeup_write_number(0),
+		saved_wakeup_number(0)
+	{}
+
+	// Fraction of the wall time between two snapshots the loop spent in callbacks:
+	// 0 is idle, near 1 is saturated.
+	static double Saturation(const EventLoopMetrics &before, const EventLoopMetrics &after)
+	{
+		int64_t wall = after.time.microsecond() - before.time.microsecond();
+		int64_t busy = (after.io_microsecond - before.io_microsecond) +
+		               (after.timer_microsecond - before.timer_microsecond) +
+		               (after.task_microsecond - before.task_microsecond);
+		return (wall > 0) ? static_cast<double>(busy) / static_cast<double>(wall) : 0.0;
+	}
+
+	TimeStamp time; // When the snapshot was taken.
+	int64_t iteration_number; // Loop iterations, i.e. Poll() calls.
+	int64_t event_number; // Active channels returned by all Poll()s.
+	int64_t max_event_number; // Most active channels returned by one Poll().
+	// Time in channel callbacks, in timers run after the wait(EPOLL_TIMEOUT mode; with
+	// TIMER_FD they run from the timerfd channel and count as IO), and in queued tasks.
+	int64_t io_microsecond;
+	int64_t timer_microsecond;
+	int64_t task_microsecond;
+	int64_t task_number; // Queued tasks run.
+	int64_t max_task_number; // High-water mark of the task queue: most run in one pass.
+	// Longest single channel callback, timer pass or task pass.
+	int64_t slowest_callback_microsecond;
+	// With EventLoopOption::busy_poll_microsecond only: time spent in zero-timeout polls
+	// that found nothing, and time spent on the work that followed a wakeup.
+	int64_t busy_poll_spin_microsecond;
+	int64_t busy_poll_work_microsecond;
+	// Wakeup()s that wrote the eventfd, and those skipped because one was pending.
+	int64_t wakeup_write_number;
+	int64_t saved_wakeup_number;
+};
+
+}
+
+#endif // NETLIB_NETLIB_EVENT_LOOP_METRICS_H_
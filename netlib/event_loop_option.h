@@ -0,0 +1,62 @@
+#ifndef NETLIB_NETLIB_EVENT_LOOP_OPTION_H_
+#define NETLIB_NETLIB_EVENT_LOOP_OPTION_H_
+
+namespace netlib
+{
+
+// Knobs of one EventLoop, fixed when it is constructed. EventLoopThread,
+// EventLoopThreadPool and TcpServer pass one down to the loops they create.
+struct EventLoopOption
+{
+	enum PollerType
+	{
+		EPOLL, // Epoller.
+		// IoUringPoller: io_uring poll requests for channels, recv/writev/accept requests
+		// for TcpConnection and Acceptor. Falls back to EPOLL if unavailable.
+		IO_URING
+	};
+	enum TimerMode
+	{
+		TIMER_FD, // A timerfd re-armed by timerfd_settime() whenever the first timer changes.
+		EPOLL_TIMEOUT // The poller's wait sleeps until the first timer; timers run after IO.
+	};
+	enum TimerStore
+	{
+		TIMER_SET, // A set ordered by expiration: exact, O(log n) add and cancel.
+		TIMING_WHEEL // A hierarchical timing wheel: O(1) add and cancel, tick precision.
+	};
+
+	EventLoopOption():
+		poller_type(EPOLL),
+		timer_mode(TIMER_FD),
+		timer_store(TIMER_SET),
+		timing_wheel_tick_microsecond(1000),
+		idle_timeout_tick_microsecond(1000 * 1000),
+		precise_timeout(false),
+		busy_poll_microsecond(0),
+		socket_busy_poll_microsecond(0)
+	{}
+
+	PollerType poller_type;
+	TimerMode timer_mode;
+	TimerStore timer_store;
+	// TIMING_WHEEL only: timers fire at the first tick at or after their expiration.
+	int timing_wheel_tick_microsecond;
+	// Granularity of idle connection timeouts(TcpConnection::set_idle_timeout()):
+	// connections close up to one tick after their timeout.
+	int idle_timeout_tick_microsecond;
+	// EPOLL_TIMEOUT only: wait with microsecond precision through epoll_pwait2()
+	// instead of rounding up to milliseconds. Falls back if the kernel lacks it.
+	bool precise_timeout;
+	// Busy polling for latency-critical loops: after any work, keep polling with a zero
+	// timeout for this long before blocking again. It burns the CPU of the loop thread
+	// to save the scheduler wakeup per message. 0: always block.
+	int busy_poll_microsecond;
+	// SO_BUSY_POLL and SO_PREFER_BUSY_POLL on the loop's TCP connections, so reads poll
+	// the device queue too. Values above net.core.busy_read need CAP_NET_ADMIN. 0: off.
+	int socket_busy_poll_microsecond;
+};
+
+}
+
+#endif // NETLIB_NETLIB_EVENT_LOOP_OPTION_H_
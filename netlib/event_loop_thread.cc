@@ -6,7 +6,8 @@ using std::bind;
 using netlib::EventLoopThread;
 using netlib::EventLoop;
 
-EventLoopThread::EventLoopThread():
+EventLoopThread::EventLoopThread(const EventLoopOption &option):
+	option_(option),
 	loop_(nullptr),
 	thread_(bind(&EventLoopThread::ThreadMainFunction, this)),
 	mutex_(),
@@ -14,7 +15,7 @@ EventLoopThread::EventLoopThread():
 {}
 void EventLoopThread::ThreadMainFunction()
 {
-	EventLoop loop;
+	EventLoop loop(option_);
 	{
 		MutexLockGuard lock(mutex_);
 		loop_ = &loop;
@@ -2,6 +2,7 @@
 #define NETLIB_NETLIB_EVENT_LOOP_THREAD_H_
 
 #include <netlib/condition.h>
+#include <netlib/event_loop_option.h>
 #include <netlib/mutex.h>
 #include <netlib/non_copyable.h>
 #include <netlib/thread.h>
@@ -21,13 +22,14 @@ class EventLoop;
 class EventLoopThread: public NonCopyable
 {
 public:
-	EventLoopThread();
+	explicit EventLoopThread(const EventLoopOption &option = EventLoopOption());
 	~EventLoopThread();
 	EventLoop *StartLoop();
 
 private:
 	void ThreadMainFunction();
 
+	const EventLoopOption option_;
 	EventLoop *loop_;
 	Thread thread_;
 	MutexLock mutex_;
@@ -11,6 +11,7 @@ EventLoopThreadPool::EventLoopThreadPool(EventLoop *main_loop,
 	main_loop_(main_loop),
 	loop_number_(loop_number),
 	loop_pool_(loop_number_),
+	loop_option_(),
 	started_(false),
 	next_loop_index_(0)
 {}
@@ -23,7 +24,7 @@ void EventLoopThreadPool::Start()
 	started_ = true;
 	for(int index = 0; index < loop_number_; ++index)
 	{
-		EventLoopThread *thread = new EventLoopThread();
+		EventLoopThread *thread = new EventLoopThread(loop_option_);
 		loop_pool_[index] = thread->StartLoop();
 	}
 }
@@ -41,3 +42,8 @@ EventLoop *EventLoopThreadPool::GetNextLoop()
 	}
 	return next_loop;
 }
+std::vector<EventLoop*> EventLoopThreadPool::GetAllLoops() const
+{
+	assert(started_ == true);
+	return (loop_number_ > 0) ? loop_pool_ : std::vector<EventLoop*>(1, main_loop_);
+}
@@ -1,9 +1,12 @@
 #ifndef NETLIB_NETLIB_EVENT_LOOP_THREAD_POOL_H_
 #define NETLIB_NETLIB_EVENT_LOOP_THREAD_POOL_H_
 
+#include <assert.h>
+
 #include <vector>
 #include <functional>
 
+#include <netlib/event_loop_option.h>
 #include <netlib/non_copyable.h>
 #include <netlib/function.h>
 
@@ -15,20 +18,30 @@ class EventLoopThread;
 
 // Interface:
 // Ctor
+// set_loop_option
 // Start
 // GetNextLoop
+// GetAllLoops
 
 class EventLoopThreadPool: public NonCopyable
 {
 public:
 	explicit EventLoopThreadPool(EventLoop *main_loop, const int loop_number = 0);
+	void set_loop_option(const EventLoopOption &option)
+	{
+		assert(started_ == false);
+		loop_option_ = option;
+	}
 	void Start();
 	EventLoop *GetNextLoop();
+	// The IO loops, or the main loop if there are none. Valid after Start().
+	std::vector<EventLoop*> GetAllLoops() const;
 
 private:
 	EventLoop *main_loop_;
 	const int loop_number_;
 	std::vector<EventLoop*> loop_pool_;
+	EventLoopOption loop_option_; // Used by every EventLoopThread in the pool.
 	bool started_;
 	int next_loop_index_;
 };
@@ -3,6 +3,7 @@
 
 #include <functional> // function<>, bind<>
 #include <memory> // shared_ptr<>
+#include <netlib/task.h>
 #include <netlib/time_stamp.h>
 
 namespace netlib
@@ -11,7 +12,7 @@ namespace netlib
 class Buffer;
 class TcpConnection;
 
-using TimerCallback = std::function<void()>;
+using TimerCallback = Task;
 using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
 using ConnectionCallback = std::function<void(const TcpConnectionPtr&)>;
 using MessageCallback = std::function<void(const TcpConnectionPtr&,
@@ -21,7 +22,7 @@ using WriteCompleteCallback = std::function<void(const TcpConnectionPtr&)>;
 using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr&, int)>;
 using CloseCallback = std::function<void(const TcpConnectionPtr&)>;
 using EventCallback = std::function<void(const TimeStamp&)>;
-using TaskCallback = std::function<void()>;
+using TaskCallback = Task;
 
 }
 
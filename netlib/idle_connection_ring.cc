@@ -0,0 +1,141 @@
+#include <netlib/idle_connection_ring.h>
+
+#include <assert.h> // assert()
+#include <string.h> // memset()
+
+#include <netlib/event_loop.h>
+#include <netlib/logging.h>
+#include <netlib/tcp_connection.h>
+
+using std::bind;
+using netlib::IdleConnectionRing;
+using netlib::TcpConnection;
+
+IdleConnectionRing::IdleConnectionRing(EventLoop *owner_loop, int64_t tick_microsecond):
+	owner_loop_(owner_loop),
+	tick_microsecond_(tick_microsecond),
+	current_tick_(0),
+	connection_number_(0),
+	ticking_(false),
+	timer_id_(nullptr, 0)
+{
+	assert(tick_microsecond_ > 0);
+	memset(bucket_, 0, sizeof bucket_);
+}
+IdleConnectionRing::~IdleConnectionRing()
+{
+	// The timer goes with the TimerQueue, which is destructed before.
+	for(int bucket = 0; bucket < kBucketNumber; ++bucket)
+	{
+		while(bucket_[bucket] != nullptr)
+		{
+			TcpConnection *connection = bucket_[bucket];
+			Unlink(connection);
+			connection->idle_ring_ = nullptr;
+		}
+	}
+}
+
+void IdleConnectionRing::Add(TcpConnection *connection)
+{
+	owner_loop_->AssertInLoopThread();
+	assert(connection->idle_ring_ == nullptr);
+	int64_t timeout_microsecond =
+	    static_cast<int64_t>(connection->idle_timeout_second_ * 1000000.0);
+	int64_t timeout_tick = (timeout_microsecond + tick_microsecond_ - 1) / tick_microsecond_;
+	connection->idle_ring_ = this;
+	connection->idle_timeout_tick_ = (timeout_tick > 0) ? timeout_tick : 1;
+	connection->idle_touch_tick_ = current_tick_;
+	// Touched during tick T, it has been idle for a whole timeout at T + timeout + 1.
+	Link(connection, current_tick_ + connection->idle_timeout_tick_ + 1);
+	++connection_number_;
+	if(ticking_ == false)
+	{
+		ticking_ = true;
+		timer_id_ = owner_loop_->RunEvery(bind(&IdleConnectionRing::Tick, this),
+		                                  static_cast<double>(tick_microsecond_) / 1000000.0);
+	}
+}
+void IdleConnectionRing::Remove(TcpConnection *connection)
+{
+	owner_loop_->AssertInLoopThread();
+	assert(connection->idle_ring_ == this);
+	Unlink(connection);
+	connection->idle_ring_ = nullptr;
+	--connection_number_;
+	// An empty ring stops ticking at its next tick.
+}
+
+void IdleConnectionRing::Tick()
+{
+	++current_tick_;
+	TcpConnection **head = &bucket_[current_tick_ % kBucketNumber];
+	while(*head != nullptr)
+	{
+		TcpConnection *connection = *head;
+		Unlink(connection);
+		int64_t deadline_tick =
+		    connection->idle_touch_tick_ + connection->idle_timeout_tick_ + 1;
+		if(deadline_tick > current_tick_) // Touched since it was linked.
+		{
+			Link(connection, deadline_tick); // Never into this bucket again.
+		}
+		else
+		{
+			connection->idle_ring_ = nullptr;
+			--connection_number_;
+			// Held until it is closed: Shutdown() and ForceClose() may close others.
+			expired_connection_vector_.push_back(connection->shared_from_this());
+		}
+	}
+	for(size_t index = 0; index < expired_connection_vector_.size(); ++index)
+	{
+		const TcpConnectionPtr &connection = expired_connection_vector_[index];
+		LOG_DEBUG("IdleConnectionRing::Tick() [%s] idle for %lld ticks, %s",
+		          connection->name().c_str(),
+		          static_cast<long long>(current_tick_ - connection->idle_touch_tick_),
+		          connection->idle_shutdown_ ? "shutdown" : "force close");
+		if(connection->idle_shutdown_ == true)
+		{
+			connection->Shutdown();
+		}
+		else
+		{
+			connection->ForceClose();
+		}
+	}
+	expired_connection_vector_.clear();
+	if(connection_number_ == 0)
+	{
+		owner_loop_->CancelTimer(timer_id_);
+		ticking_ = false;
+	}
+}
+
+void IdleConnectionRing::Link(TcpConnection *connection, int64_t deadline_tick)
+{
+	int64_t distance = deadline_tick - current_tick_;
+	assert(distance > 0);
+	if(distance >= kBucketNumber) // Beyond the ring: checked again a turn later.
+	{
+		distance = kBucketNumber - 1;
+	}
+	TcpConnection *&head = bucket_[(current_tick_ + distance) % kBucketNumber];
+	connection->idle_next_ = head;
+	if(head != nullptr)
+	{
+		head->idle_pprev_ = &connection->idle_next_;
+	}
+	head = connection;
+	connection->idle_pprev_ = &head;
+}
+void IdleConnectionRing::Unlink(TcpConnection *connection)
+{
+	*connection->idle_pprev_ = connection->idle_next_;
+	if(connection->idle_next_ != nullptr)
+	{
+		connection->idle_next_->idle_pprev_ = connection->idle_pprev_;
+	}
+	connection->idle_next_ = nullptr;
+	connection->idle_pprev_ = nullptr;
+}
@@ -0,0 +1,75 @@
+#ifndef NETLIB_NETLIB_IDLE_CONNECTION_RING_H_
+#define NETLIB_NETLIB_IDLE_CONNECTION_RING_H_
+
+#include <stdint.h> // int64_t
+
+#include <vector>
+
+#include <netlib/function.h>
+#include <netlib/non_copyable.h>
+#include <netlib/timer_id.h>
+
+namespace netlib
+{
+
+class EventLoop;
+class TcpConnection;
+
+// Interface:
+// Ctor
+// Dtor
+// Add -> -Link
+// Remove -> -Unlink
+// Getter: current_tick, size
+// -Tick -> -Unlink -> -Link
+
+// Idle connection timeouts of one EventLoop(TcpConnection::set_idle_timeout()): a ring
+// of kBucketNumber buckets, one per tick, turned by a RunEvery() timer that only runs
+// while the ring holds connections. Buckets are intrusive lists through the
+// connections, so the ring holds no reference: a connection leaves it when it closes
+// or destructs. A message only stores current_tick() in its connection, no list is
+// touched; when the bucket of a connection comes round, it is expired if idle
+// since, else moved to the bucket of its new deadline. So each connection costs the
+// ring O(1) per timeout, however many messages it gets, and nothing is allocated.
+//
+// Connections are closed after being idle for between their timeout and one tick more.
+class IdleConnectionRing: public NonCopyable
+{
+public:
+	IdleConnectionRing(EventLoop *owner_loop, int64_t tick_microsecond);
+	~IdleConnectionRing(); // Unlink the connections still in the ring.
+
+	void Add(TcpConnection *connection);
+	void Remove(TcpConnection *connection);
+
+	// Ticks since the ring was created.
+	int64_t current_tick() const
+	{
+		return current_tick_;
+	}
+	int size() const
+	{
+		return connection_number_;
+	}
+
+private:
+	static const int kBucketNumber = 256;
+
+	void Tick();
+	// Into the bucket of `deadline_tick`, or the farthest one, to be checked again then.
+	void Link(TcpConnection *connection, int64_t deadline_tick);
+	void Unlink(TcpConnection *connection);
+
+	EventLoop *owner_loop_;
+	const int64_t tick_microsecond_;
+	int64_t current_tick_;
+	int connection_number_;
+	TcpConnection *bucket_[kBucketNumber];
+	bool ticking_; // Whether timer_id_ is running.
+	TimerId timer_id_;
+	std::vector<TcpConnectionPtr> expired_connection_vector_; // Reused by Tick().
+};
+
+}
+
+#endif // NETLIB_NETLIB_IDLE_CONNECTION_RING_H_
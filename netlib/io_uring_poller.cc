@@ -0,0 +1,609 @@
+#include <netlib/io_uring_poller.h>
+
+#include <assert.h> // assert()
+#include <errno.h> // errno, ETIME, EINTR
+#include <linux/io_uring.h> // io_uring_*, IORING_*
+#include <string.h> // memset()
+#include <poll.h> // POLLIN
+#include <sys/epoll.h> // EPOLLET, EPOLLERR
+#include <sys/eventfd.h> // eventfd()
+#include <sys/mman.h> // mmap(), munmap()
+#include <sys/socket.h> // SOCK_NONBLOCK, SOCK_CLOEXEC
+#include <sys/syscall.h> // __NR_io_uring_setup, __NR_io_uring_enter
+#include <unistd.h> // close(), syscall()
+
+#include <netlib/channel.h>
+#include <netlib/logging.h>
+
+using netlib::IoUringPoller;
+using netlib::TimeStamp;
+
+namespace
+{
+
+// Generations wrap within 30 bits, so that the high bits of user_data tell the three
+// kinds of requests apart.
+const uint32_t kGenerationMask = 0x3fffffff;
+// user_data of a poll request: its fd in the low half, the generation in the high half.
+uint64_t UserData(int fd, uint32_t generation)
+{
+	return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+// user_data of a recv/writev/accept request: the same, with its index instead of an fd.
+const uint64_t kRequestTag = 1ULL << 63;
+uint64_t RequestUserData(int index, uint32_t generation)
+{
+	return kRequestTag | UserData(index, generation);
+}
+// user_data of POLL_REMOVE/ASYNC_CANCEL requests and of the probe, whose completions
+// are ignored.
+const uint64_t kCancelUserData = UINT64_MAX;
+
+}
+
+IoUringPoller::IoUringPoller(EventLoop *owner_loop):
+	Poller(owner_loop),
+	ring_fd_(-1),
+	ring_(nullptr),
+	ring_size_(0),
+	sqe_array_(nullptr),
+	sqe_array_size_(0),
+	sq_head_(nullptr),
+	sq_tail_(nullptr),
+	sq_mask_(0),
+	sq_entry_number_(0),
+	sq_local_tail_(0),
+	cq_head_(nullptr),
+	cq_tail_(nullptr),
+	cq_mask_(0),
+	cqe_array_(nullptr),
+	entry_table_(kInitialEntryTableSize, Entry()),
+	channel_number_(0),
+	poll_round_(0),
+	multishot_poll_(false),
+	pending_request_number_(0)
+{
+	SetupRing();
+}
+void IoUringPoller::SetupRing()
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof params);
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = kCompletionQueueSize;
+	int ring_fd = static_cast<int>(::syscall(__NR_io_uring_setup, kSubmissionQueueSize, &params));
+	if(ring_fd < 0)
+	{
+		LOG_WARN("io_uring_setup(): WARN");
+		return;
+	}
+	// One mmap() for both rings(5.4), completions kept on overflow(5.5), timeout given
+	// to io_uring_enter()(5.11).
+	const unsigned kRequiredFeature =
+	    IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+	if((params.features & kRequiredFeature) != kRequiredFeature)
+	{
+		LOG_WARN("io_uring lacks features %#x.", kRequiredFeature & ~params.features);
+		::close(ring_fd);
+		return;
+	}
+	size_t sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	size_t cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	ring_size_ = (sq_ring_size > cq_ring_size) ? sq_ring_size : cq_ring_size;
+	ring_ = ::mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	               ring_fd, IORING_OFF_SQ_RING);
+	if(ring_ == MAP_FAILED)
+	{
+		LOG_WARN("mmap(IORING_OFF_SQ_RING): WARN");
+		ring_ = nullptr;
+		::close(ring_fd);
+		return;
+	}
+	sqe_array_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+	void *sqe_array = ::mmap(nullptr, sqe_array_size_, PROT_READ | PROT_WRITE,
+	                         MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+	if(sqe_array == MAP_FAILED)
+	{
+		LOG_WARN("mmap(IORING_OFF_SQES): WARN");
+		::munmap(ring_, ring_size_);
+		ring_ = nullptr;
+		::close(ring_fd);
+		return;
+	}
+	sqe_array_ = static_cast<struct io_uring_sqe*>(sqe_array);
+
+	char *ring = static_cast<char*>(ring_);
+	sq_head_ = reinterpret_cast<unsigned*>(ring + params.sq_off.head);
+	sq_tail_ = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+	sq_mask_ = *reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+	sq_entry_number_ = params.sq_entries;
+	sq_local_tail_ = *sq_tail_;
+	// Entry i of the submission ring always holds sqe_array_[i].
+	unsigned *sq_array = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+	for(unsigned index = 0; index < params.sq_entries; ++index)
+	{
+		sq_array[index] = index;
+	}
+	cq_head_ = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+	cq_tail_ = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+	cq_mask_ = *reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+	cqe_array_ = reinterpret_cast<struct io_uring_cqe*>(ring + params.cq_off.cqes);
+	ring_fd_ = ring_fd;
+	multishot_poll_ = ProbeMultishotPoll();
+	if(multishot_poll_ == false)
+	{
+		LOG_WARN("io_uring lacks multishot poll(5.13), EPOLLET channels get one-shot polls.");
+	}
+}
+// 5.11 and 5.12 reject IORING_POLL_ADD_MULTI with -EINVAL when the request is
+// submitted; later kernels keep a poll on an empty eventfd pending.
+bool IoUringPoller::ProbeMultishotPoll()
+{
+	int event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(event_fd < 0)
+	{
+		LOG_WARN("eventfd(): WARN");
+		return false;
+	}
+	const uint64_t kProbeUserData = kCancelUserData - 1;
+	struct io_uring_sqe *sqe = GetSqe();
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = event_fd;
+	sqe->poll32_events = POLLIN;
+	sqe->len = IORING_POLL_ADD_MULTI;
+	sqe->user_data = kProbeUserData;
+	Enter(0, 0, nullptr, 0);
+	bool supported = true;
+	unsigned head = *cq_head_;
+	for(unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE); head != tail; ++head)
+	{
+		const struct io_uring_cqe &cqe = cqe_array_[head & cq_mask_];
+		supported = supported && (cqe.user_data != kProbeUserData || cqe.res >= 0);
+	}
+	__atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+	if(supported == true) // Its completion is dropped in a later Poll().
+	{
+		sqe = GetSqe();
+		sqe->opcode = IORING_OP_POLL_REMOVE;
+		sqe->fd = -1;
+		sqe->addr = kProbeUserData;
+		sqe->user_data = kCancelUserData;
+	}
+	::close(event_fd); // The poll request holds the file until it is removed.
+	return supported;
+}
+
+IoUringPoller::~IoUringPoller()
+{
+	if(ring_fd_ >= 0)
+	{
+		DrainRequest();
+		// Drop the callbacks here, while the poller is whole: they may hold the last
+		// reference to connections, whose channels check that they are removed.
+		request_deque_.clear();
+		::munmap(sqe_array_, sqe_array_size_);
+		::munmap(ring_, ring_size_);
+		::close(ring_fd_); // Cancels the polls still in flight.
+	}
+}
+// The kernel may still write into the memory of pending requests, e.g. the input
+// buffer of a connection: wait until it is done with all of them.
+void IoUringPoller::DrainRequest()
+{
+	int waiting_number = pending_request_number_ - static_cast<int>(completion_vector_.size());
+	for(int index = 0; index < static_cast<int>(request_deque_.size()); ++index)
+	{
+		if(request_deque_[index].pending == true)
+		{
+			struct io_uring_sqe *sqe = GetSqe();
+			sqe->opcode = IORING_OP_ASYNC_CANCEL;
+			sqe->fd = -1;
+			sqe->addr = RequestUserData(index, request_deque_[index].generation);
+			sqe->user_data = kCancelUserData;
+		}
+	}
+	completion_vector_.clear();
+	while(waiting_number > 0)
+	{
+		if(Enter(1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+		{
+			LOG_ERROR("io_uring_enter(): ERROR");
+			return;
+		}
+		unsigned head = *cq_head_;
+		for(unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE); head != tail; ++head)
+		{
+			uint64_t user_data = cqe_array_[head & cq_mask_].user_data;
+			if((user_data & kRequestTag) != 0 && user_data < kCancelUserData - 1)
+			{
+				--waiting_number;
+			}
+		}
+		__atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+	}
+}
+
+struct io_uring_sqe *IoUringPoller::GetSqe()
+{
+	unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+	if(sq_local_tail_ - head == sq_entry_number_) // Full: hand the batch over first.
+	{
+		Enter(0, 0, nullptr, 0);
+		head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+		if(sq_local_tail_ - head == sq_entry_number_)
+		{
+			LOG_FATAL("io_uring submission queue is full.");
+		}
+	}
+	struct io_uring_sqe *sqe = &sqe_array_[sq_local_tail_ & sq_mask_];
+	++sq_local_tail_;
+	memset(sqe, 0, sizeof *sqe);
+	return sqe;
+}
+int IoUringPoller::Enter(unsigned wait_number,
+                         unsigned flags,
+                         void *argument,
+                         size_t argument_size)
+{
+	unsigned submit_number = sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+	__atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+	return static_cast<int>(::syscall(__NR_io_uring_enter,
+	                                  ring_fd_,
+	                                  submit_number,
+	                                  wait_number,
+	                                  flags,
+	                                  argument,
+	                                  argument_size));
+}
+
+TimeStamp IoUringPoller::Poll(int64_t timeout, ChannelVector &active_channel)
+{
+	AssertInLoopThread();
+	LOG_TRACE("total added channel number = %d", channel_number_);
+	++poll_round_;
+	ArmPendingChannel();
+
+	int result = 0;
+	if(*cq_head_ == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE))
+	{
+		// Submit the batch and wait in the same system call.
+		struct __kernel_timespec ts;
+		struct io_uring_getevents_arg argument;
+		memset(&argument, 0, sizeof argument);
+		if(timeout >= 0)
+		{
+			ts.tv_sec = timeout / TimeStamp::kMicrosecondPerSecond;
+			ts.tv_nsec = timeout % TimeStamp::kMicrosecondPerSecond * 1000;
+			argument.ts = reinterpret_cast<uint64_t>(&ts);
+		}
+		result = Enter(1,
+		               IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+		               &argument,
+		               sizeof argument);
+	}
+	else if(sq_local_tail_ != __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE))
+	{
+		result = Enter(0, 0, nullptr, 0); // Completions are ready: submit only.
+	}
+	TimeStamp poll_return_time(TimeStamp::Now());
+	if(result < 0 && errno != ETIME && errno != EINTR)
+	{
+		LOG_ERROR("io_uring_enter(): ERROR");
+	}
+
+	unsigned head = *cq_head_; // Only this thread moves the head.
+	unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+	LOG_TRACE("%u completions.", tail - head);
+	for(; head != tail; ++head)
+	{
+		HandleCompletion(&cqe_array_[head & cq_mask_], active_channel);
+	}
+	__atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+	return poll_return_time;
+}
+void IoUringPoller::HandleCompletion(const struct io_uring_cqe *cqe,
+                                     ChannelVector &active_channel)
+{
+	if(cqe->user_data >= kCancelUserData - 1)
+	{
+		return;
+	}
+	if((cqe->user_data & kRequestTag) != 0) // Its callback runs in RunCompletion().
+	{
+		Completion completion = {static_cast<int>(cqe->user_data & UINT32_MAX), cqe->res};
+		completion_vector_.push_back(completion);
+		return;
+	}
+	int fd = static_cast<int>(cqe->user_data & UINT32_MAX);
+	uint32_t generation = static_cast<uint32_t>(cqe->user_data >> 32);
+	Entry &entry = entry_table_[fd];
+	if(entry.channel == nullptr || entry.generation != generation)
+	{
+		return; // From a canceled request.
+	}
+	int event = cqe->res;
+	if((cqe->flags & IORING_CQE_F_MORE) == 0) // The request is done.
+	{
+		entry.armed = false;
+		if(event >= 0)
+		{
+			ScheduleArm(fd);
+		}
+	}
+	if(event < 0)
+	{
+		// Re-arming would fail again in every Poll(): leave the channel unarmed until
+		// it is updated, and report the error to it once.
+		errno = -event;
+		LOG_ERROR("io_uring poll fd = %d: ERROR", fd);
+		event = EPOLLERR;
+	}
+	else if(event == 0)
+	{
+		return;
+	}
+	// A multishot poll may complete more than once before the channel gets to run.
+	if(entry.active_round == poll_round_)
+	{
+		entry.channel->set_returned_event(entry.channel->returned_event() | event);
+	}
+	else
+	{
+		entry.active_round = poll_round_;
+		entry.channel->set_returned_event(event);
+		active_channel.push_back(entry.channel);
+	}
+}
+
+// Same states as in Epoller, but a kAdded channel may be waiting to be re-armed:
+// kRaw ->
+// 1.	kAdded. AOUC() {entry_table_[fd] = channel -> arm}
+// kAdded ->
+// 1.	kRaw. RC() {cancel -> entry_table_[fd].channel = nullptr}
+// 2.	kAdded. AOUC() {if(IsRequested(NoneEvent) == false) cancel -> arm}
+// 3.	kDeleted. AOUC() {if(IR(NE) == true) cancel}
+// kDeleted ->
+// 1.	kRaw. RC() {entry_table_[fd].channel = nullptr}
+// 2.	kAdded. AOUC() {arm}
+// "arm" only schedules a poll request, queued at the start of the next Poll().
+void IoUringPoller::AddOrUpdateChannel(Channel *channel)
+{
+	AssertInLoopThread();
+	int fd = channel->fd(), channel_state = channel->state_in_epoller();
+	LOG_TRACE("channel_fd = %d, requested_event = %d, channel_state = %d",
+	          fd, channel->requested_event(), channel_state);
+	switch(channel_state)
+	{
+	case kRaw:
+		InsertChannel(channel);
+	// Fall through - no `break;` to avoid duplicate codes.
+	case kDeleted:
+		assert(HasChannel(channel) == true);
+		channel->set_state_in_epoller(kAdded);
+		ScheduleArm(fd);
+		break;
+	case kAdded:
+	{
+		assert(HasChannel(channel) == true);
+		Entry &entry = entry_table_[fd];
+		if(channel->IsRequested(Channel::NONE_EVENT) == true)
+		{
+			Cancel(entry, fd);
+			channel->set_state_in_epoller(kDeleted);
+		}
+		else if(entry.armed == false || entry.armed_event != channel->requested_event())
+		{
+			Cancel(entry, fd);
+			ScheduleArm(fd);
+		}
+		break;
+	}
+	default:
+		LOG_FATAL("Unknown channel_state!");
+	}
+}
+void IoUringPoller::InsertChannel(Channel *channel)
+{
+	int fd = channel->fd();
+	assert(fd >= 0);
+	int size = static_cast<int>(entry_table_.size());
+	if(fd >= size)
+	{
+		entry_table_.resize((fd < size * 2) ? size * 2 : fd + 1, Entry());
+	}
+	assert(entry_table_[fd].channel == nullptr);
+	// Keep the generation: completions for the previous channel on this fd stay stale.
+	entry_table_[fd].channel = channel;
+	++channel_number_;
+}
+void IoUringPoller::ScheduleArm(int fd)
+{
+	if(entry_table_[fd].arm_pending == false)
+	{
+		entry_table_[fd].arm_pending = true;
+		arm_fd_vector_.push_back(fd);
+	}
+}
+void IoUringPoller::ArmPendingChannel()
+{
+	for(size_t index = 0; index < arm_fd_vector_.size(); ++index)
+	{
+		int fd = arm_fd_vector_[index];
+		Entry &entry = entry_table_[fd];
+		entry.arm_pending = false;
+		if(entry.channel != nullptr &&
+		        entry.armed == false &&
+		        entry.channel->state_in_epoller() == kAdded)
+		{
+			PrepPollAdd(fd, entry);
+		}
+	}
+	arm_fd_vector_.clear();
+}
+void IoUringPoller::PrepPollAdd(int fd, Entry &entry)
+{
+	int event = entry.channel->requested_event();
+	struct io_uring_sqe *sqe = GetSqe();
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	// Poll masks share the EPOLL* bits. NOTE: Must be half-word swapped on big-endian.
+	sqe->poll32_events = static_cast<uint32_t>(event & ~EPOLLET);
+	if((event & EPOLLET) != 0 && multishot_poll_ == true)
+	{
+		sqe->len = IORING_POLL_ADD_MULTI; // Completes on each wakeup, like EPOLLET.
+	}
+	sqe->user_data = UserData(fd, entry.generation);
+	entry.armed = true;
+	entry.armed_event = event;
+	++control_number_;
+}
+void IoUringPoller::Cancel(Entry &entry, int fd)
+{
+	if(entry.armed == true)
+	{
+		struct io_uring_sqe *sqe = GetSqe();
+		sqe->opcode = IORING_OP_POLL_REMOVE;
+		sqe->fd = -1;
+		sqe->addr = UserData(fd, entry.generation);
+		sqe->user_data = kCancelUserData;
+		entry.armed = false;
+		++control_number_;
+	}
+	entry.generation = (entry.generation + 1) & kGenerationMask;
+}
+
+void IoUringPoller::RemoveChannel(Channel *channel)
+{
+	AssertInLoopThread();
+	assert(channel->IsRequested(Channel::NONE_EVENT) == true);
+	assert(HasChannel(channel) == true);
+
+	int fd = channel->fd();
+	Entry &entry = entry_table_[fd];
+	Cancel(entry, fd);
+	entry.channel = nullptr;
+	--channel_number_;
+	channel->set_state_in_epoller(kRaw);
+}
+
+bool IoUringPoller::HasChannel(Channel *channel) const
+{
+	AssertInLoopThread();
+	int fd = channel->fd();
+	return fd >= 0 &&
+	       fd < static_cast<int>(entry_table_.size()) &&
+	       entry_table_[fd].channel == channel;
+}
+
+uint64_t IoUringPoller::SubmitRecv(int fd,
+                                   void *data,
+                                   int length,
+                                   CompletionCallback &&callback)
+{
+	AssertInLoopThread();
+	int index = 0;
+	struct io_uring_sqe *sqe = NewRequest(IORING_OP_RECV, fd, index);
+	sqe->addr = reinterpret_cast<uint64_t>(data);
+	sqe->len = static_cast<uint32_t>(length);
+	request_deque_[index].callback = std::move(callback);
+	return sqe->user_data;
+}
+uint64_t IoUringPoller::SubmitWritev(int fd,
+                                     const struct iovec *vec,
+                                     int iovec_number,
+                                     CompletionCallback &&callback)
+{
+	AssertInLoopThread();
+	int index = 0;
+	struct io_uring_sqe *sqe = NewRequest(IORING_OP_WRITEV, fd, index);
+	Request &request = request_deque_[index];
+	request.iovec_vector.assign(vec, vec + iovec_number);
+	sqe->addr = reinterpret_cast<uint64_t>(request.iovec_vector.data());
+	sqe->len = static_cast<uint32_t>(iovec_number);
+	request.callback = std::move(callback);
+	return sqe->user_data;
+}
+uint64_t IoUringPoller::SubmitAccept(int fd, AcceptCallback &&callback)
+{
+	AssertInLoopThread();
+	int index = 0;
+	struct io_uring_sqe *sqe = NewRequest(IORING_OP_ACCEPT, fd, index);
+	Request &request = request_deque_[index];
+	memset(&request.address, 0, sizeof request.address);
+	request.address_length = sizeof request.address;
+	sqe->addr = reinterpret_cast<uint64_t>(&request.address);
+	sqe->addr2 = reinterpret_cast<uint64_t>(&request.address_length);
+	sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+	request.accept_callback = std::move(callback);
+	return sqe->user_data;
+}
+struct io_uring_sqe *IoUringPoller::NewRequest(int opcode, int fd, int &index)
+{
+	if(free_request_vector_.empty() == true)
+	{
+		index = static_cast<int>(request_deque_.size());
+		request_deque_.push_back(Request());
+	}
+	else
+	{
+		index = free_request_vector_.back();
+		free_request_vector_.pop_back();
+	}
+	Request &request = request_deque_[index];
+	request.pending = true;
+	++pending_request_number_;
+	struct io_uring_sqe *sqe = GetSqe();
+	sqe->opcode = static_cast<uint8_t>(opcode);
+	sqe->fd = fd;
+	sqe->user_data = RequestUserData(index, request.generation);
+	return sqe;
+}
+
+void IoUringPoller::CancelRequest(uint64_t request_id)
+{
+	AssertInLoopThread();
+	int index = static_cast<int>(request_id & UINT32_MAX);
+	const Request &request = request_deque_[index];
+	if(request.pending == false || RequestUserData(index, request.generation) != request_id)
+	{
+		return; // Its callback has run.
+	}
+	// If it completes first, the cancel fails with -ENOENT, which is ignored as well.
+	struct io_uring_sqe *sqe = GetSqe();
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = request_id;
+	sqe->user_data = kCancelUserData;
+}
+
+int IoUringPoller::RunCompletion(const TimeStamp &receive_time)
+{
+	AssertInLoopThread();
+	// Callbacks may submit requests, which reuse the ones freed here, but only Poll()
+	// adds completions.
+	int completion_number = static_cast<int>(completion_vector_.size());
+	for(int completed = 0; completed < completion_number; ++completed)
+	{
+		const Completion &completion = completion_vector_[completed];
+		Request &request = request_deque_[completion.index];
+		CompletionCallback callback;
+		AcceptCallback accept_callback;
+		callback.swap(request.callback);
+		accept_callback.swap(request.accept_callback);
+		SocketAddress address(request.address);
+		request.pending = false;
+		request.generation = (request.generation + 1) & kGenerationMask;
+		--pending_request_number_;
+		free_request_vector_.push_back(completion.index);
+		if(accept_callback)
+		{
+			accept_callback(completion.result, address);
+		}
+		else
+		{
+			callback(completion.result, receive_time);
+		}
+	}
+	completion_vector_.clear();
+	return completion_number;
+}
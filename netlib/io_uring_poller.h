@@ -0,0 +1,173 @@
+#ifndef NETLIB_NETLIB_IO_URING_POLLER_H_
+#define NETLIB_NETLIB_IO_URING_POLLER_H_
+
+#include <netinet/in.h> // struct sockaddr_in
+#include <stdint.h> // int64_t, uint32_t, uint64_t
+#include <sys/socket.h> // socklen_t
+#include <sys/uio.h> // struct iovec
+
+#include <deque>
+#include <functional> // function<>
+#include <vector>
+
+#include <netlib/poller.h>
+#include <netlib/socket_address.h>
+#include <netlib/time_stamp.h>
+
+struct io_uring_sqe; // Forward declaration, don't need include <linux/io_uring.h>
+struct io_uring_cqe;
+
+namespace netlib
+{
+
+// Interface:
+// Ctor -> -SetupRing -> -ProbeMultishotPoll -> -GetSqe -> -Enter
+// Dtor
+// Valid
+// Setter: precise_timeout
+// Poll -> -AssertInLoopThread -> -ArmPendingChannel -> -Enter -> -HandleCompletion
+//			-ArmPendingChannel -> -PrepPollAdd -> -GetSqe
+//			-GetSqe -> -Enter
+// AddOrUpdateChannel -> -AssertInLoopThread -> -InsertChannel -> -ScheduleArm -> -Cancel
+//			-Cancel -> -GetSqe
+// RemoveChannel -> -AssertInLoopThread -> -Cancel
+// HasChannel -> -AssertInLoopThread
+// SubmitRecv/SubmitWritev/SubmitAccept -> -AssertInLoopThread -> -NewRequest -> -GetSqe
+// CancelRequest -> -AssertInLoopThread -> -GetSqe
+// RunCompletion -> -AssertInLoopThread
+
+// Readiness through io_uring poll requests, talking to the kernel with raw syscalls.
+// Every registration change only fills a submission queue entry; all of them go to
+// the kernel with the wait, in the single io_uring_enter() of each Poll(). Polls are
+// one-shot and re-armed after they complete(level-triggered, as epoll by default),
+// except for EPOLLET channels which get one multishot poll if the kernel has it(5.13).
+// A poll that fails is not re-armed: its channel gets EPOLLERR once.
+// TcpConnection and Acceptor of its loop skip readiness altogether: they submit
+// recv/writev/accept requests, batched into the same io_uring_enter(), and get the
+// results through callbacks that EventLoop runs after the channels of each Poll().
+class IoUringPoller: public Poller
+{
+public:
+	explicit IoUringPoller(EventLoop *owner_loop);
+	~IoUringPoller() override;
+
+	// False if io_uring could not be set up: disabled, or a kernel before 5.11.
+	bool Valid() const
+	{
+		return ring_fd_ >= 0;
+	}
+	void set_precise_timeout(bool on) override
+	{} // Always precise: io_uring_enter() takes a timespec.
+
+	TimeStamp Poll(int64_t timeout_in_microsecond, ChannelVector &active_channel) override;
+	void AddOrUpdateChannel(Channel *channel) override;
+	// The cancel goes out with the next Poll(): the poll request holds the file till
+	// then, so a socket closed right after is only really closed(FIN sent) by then.
+	void RemoveChannel(Channel *channel) override;
+	bool HasChannel(Channel *channel) const override;
+
+	// Result of a request: the return value of the system call, or -errno.
+	using CompletionCallback = std::function<void(int, const TimeStamp&)>;
+	// accept4() result and the peer's address.
+	using AcceptCallback = std::function<void(int, const SocketAddress&)>;
+	// Queue a request that goes to the kernel with the next Poll(); return its id.
+	// `data` and the memory `vec` points to must stay valid until the callback runs:
+	// the callback should own them. The iovec array itself is copied. The callback
+	// runs exactly once, with -ECANCELED if canceled in time, except when the poller
+	// is destructed first: pending callbacks are then dropped without running.
+	uint64_t SubmitRecv(int fd, void *data, int length, CompletionCallback &&callback);
+	uint64_t SubmitWritev(int fd,
+	                      const struct iovec *vec,
+	                      int iovec_number,
+	                      CompletionCallback &&callback);
+	// The accepted socket is nonblocking and close-on-exec.
+	uint64_t SubmitAccept(int fd, AcceptCallback &&callback);
+	// Ask the kernel to cancel the request, if it has not completed yet.
+	void CancelRequest(uint64_t request_id);
+	// Run the callbacks of the requests the last Poll() reaped; return their number.
+	int RunCompletion(const TimeStamp &receive_time);
+
+private:
+	struct Entry // Per fd.
+	{
+		Channel *channel;
+		// Part of each request's user_data, bumped when a request is canceled: its
+		// completion, still on the way, is then told apart and dropped.
+		uint32_t generation;
+		bool armed; // A poll request is in flight.
+		bool arm_pending; // In arm_fd_vector_.
+		int armed_event; // Events of the request in flight.
+		int64_t active_round; // Last Poll() that returned channel, to merge completions.
+	};
+	using EntryTable = std::vector<Entry>; // Indexed by fd.
+	struct Request // Per recv/writev/accept, reused once completed.
+	{
+		uint32_t generation; // Part of its user_data, bumped when it completes.
+		bool pending; // Submitted, and its callback not yet run.
+		CompletionCallback callback;
+		AcceptCallback accept_callback;
+		// Read by the kernel until completion: the iovec array of writev and the
+		// address accept4() fills.
+		std::vector<struct iovec> iovec_vector;
+		struct sockaddr_in address;
+		socklen_t address_length;
+	};
+	// A deque: requests don't move when more are added.
+	using RequestDeque = std::deque<Request>;
+	struct Completion
+	{
+		int index; // In request_deque_.
+		int result;
+	};
+
+	void SetupRing();
+	// Whether IORING_POLL_ADD_MULTI is accepted.
+	bool ProbeMultishotPoll();
+	void InsertChannel(Channel *channel);
+	void ScheduleArm(int fd);
+	void ArmPendingChannel();
+	void PrepPollAdd(int fd, Entry &entry);
+	void Cancel(Entry &entry, int fd);
+	struct io_uring_sqe *GetSqe();
+	// Publish the filled entries and submit them with one io_uring_enter().
+	int Enter(unsigned wait_number, unsigned flags, void *argument, size_t argument_size);
+	void HandleCompletion(const struct io_uring_cqe *cqe, ChannelVector &active_channel);
+	// Take a free request, fill its entry with `opcode` and `fd`.
+	struct io_uring_sqe *NewRequest(int opcode, int fd, int &index);
+	// Cancel all pending requests and wait for their completions.
+	void DrainRequest();
+
+	static const unsigned kSubmissionQueueSize = 256;
+	static const unsigned kCompletionQueueSize = 4096;
+	static const int kInitialEntryTableSize = 64;
+
+	int ring_fd_;
+	// Submission and completion rings, mapped from ring_fd_.
+	void *ring_;
+	size_t ring_size_;
+	struct io_uring_sqe *sqe_array_;
+	size_t sqe_array_size_;
+	unsigned *sq_head_;
+	unsigned *sq_tail_;
+	unsigned sq_mask_;
+	unsigned sq_entry_number_;
+	unsigned sq_local_tail_; // Entries up to it are filled, but not yet published.
+	unsigned *cq_head_;
+	unsigned *cq_tail_;
+	unsigned cq_mask_;
+	struct io_uring_cqe *cqe_array_;
+
+	EntryTable entry_table_;
+	std::vector<int> arm_fd_vector_;
+	int channel_number_;
+	int64_t poll_round_;
+	bool multishot_poll_;
+	RequestDeque request_deque_;
+	std::vector<int> free_request_vector_;
+	int pending_request_number_;
+	std::vector<Completion> completion_vector_; // Reaped by Poll(), for RunCompletion().
+};
+
+}
+
+#endif // NETLIB_NETLIB_IO_URING_POLLER_H_
@@ -0,0 +1,215 @@
+#include <netlib/loop_watchdog.h>
+
+#include <assert.h> // assert()
+#include <errno.h> // errno
+#include <execinfo.h> // backtrace(), backtrace_symbols()
+#include <signal.h> // sigaction(), SIGRTMIN
+#include <stdlib.h> // free()
+#include <string.h> // memset()
+#include <sys/syscall.h> // SYS_tgkill
+#include <unistd.h> // getpid(), syscall(), usleep()
+
+#include <atomic>
+
+#include <netlib/event_loop.h>
+#include <netlib/logging.h>
+#include <netlib/time_stamp.h>
+
+using std::string;
+using netlib::EventLoop;
+using netlib::LoopWatchdog;
+using netlib::MutexLock;
+using netlib::MutexLockGuard;
+using netlib::TimeStamp;
+
+namespace
+{
+
+// One capture at a time in the whole process: the frames live here.
+const int kMaxFrameNumber = 64;
+void *g_frame_array[kMaxFrameNumber];
+std::atomic<int> g_frame_number(-1); // -1 till the handler has run.
+MutexLock g_capture_mutex;
+
+void BacktraceSignalHandler(int)
+{
+	int saved_errno = errno;
+	// Release: the watchdog that sees the number sees the frames.
+	g_frame_number.store(::backtrace(g_frame_array, kMaxFrameNumber), std::memory_order_release);
+	errno = saved_errno;
+}
+void InstallBacktraceHandler()
+{
+	static bool installed = false; // Under g_capture_mutex.
+	if(installed == false)
+	{
+		// backtrace() loads libgcc on its first call, which is not safe in a handler.
+		void *frame;
+		::backtrace(&frame, 1);
+		struct sigaction action;
+		memset(&action, 0, sizeof action);
+		action.sa_handler = BacktraceSignalHandler;
+		action.sa_flags = SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		if(::sigaction(SIGRTMIN, &action, nullptr) < 0)
+		{
+			LOG_ERROR("sigaction(SIGRTMIN): ERROR");
+		}
+		installed = true;
+	}
+}
+
+}
+
+LoopWatchdog::LoopWatchdog(double threshold_second, bool capture_backtrace):
+	threshold_microsecond_(static_cast<int64_t>(threshold_second * TimeStamp::kMicrosecondPerSecond)),
+	capture_backtrace_(capture_backtrace),
+	stall_callback_(DefaultStallCallback),
+	running_(false),
+	stall_number_(0),
+	loop_start_map_(),
+	mutex_(),
+	condition_(mutex_),
+	thread_(std::bind(&LoopWatchdog::ThreadMainFunction, this))
+{
+	assert(threshold_microsecond_ > 0);
+}
+LoopWatchdog::~LoopWatchdog()
+{
+	Stop();
+}
+
+void LoopWatchdog::Register(EventLoop *loop)
+{
+	MutexLockGuard lock(mutex_);
+	loop_start_map_[loop] = 0;
+}
+void LoopWatchdog::Unregister(EventLoop *loop)
+{
+	// Waits for a check in progress: the loop is not used after this returns.
+	MutexLockGuard lock(mutex_);
+	loop_start_map_.erase(loop);
+}
+
+void LoopWatchdog::Start()
+{
+	if(capture_backtrace_ == true)
+	{
+		MutexLockGuard lock(g_capture_mutex);
+		InstallBacktraceHandler();
+	}
+	{
+		MutexLockGuard lock(mutex_);
+		assert(running_ == false);
+		running_ = true;
+	}
+	thread_.Start();
+}
+void LoopWatchdog::Stop()
+{
+	{
+		MutexLockGuard lock(mutex_);
+		if(running_ == false)
+		{
+			return;
+		}
+		running_ = false;
+		condition_.Signal();
+	}
+	thread_.Join();
+}
+
+void LoopWatchdog::ThreadMainFunction()
+{
+	double interval = static_cast<double>(threshold_microsecond_) / 2 / TimeStamp::kMicrosecondPerSecond;
+	MutexLockGuard lock(mutex_);
+	while(running_ == true)
+	{
+		condition_.WaitForSecond(interval);
+		int64_t now = TimeStamp::Now().microsecond();
+		for(LoopStartMap::iterator it = loop_start_map_.begin();
+		        running_ == true && it != loop_start_map_.end();
+		        ++it)
+		{
+			CheckLoop(it->first, it->second, now);
+		}
+	}
+}
+// Called with mutex_ held, so that the loop can't be unregistered and destructed.
+void LoopWatchdog::CheckLoop(EventLoop *loop, int64_t &reported_start, int64_t now)
+{
+	int64_t start = loop->dispatch_start_microsecond();
+	if(start == 0 || start == reported_start || now - start < threshold_microsecond_)
+	{
+		return;
+	}
+	int fd = loop->dispatch_fd();
+	if(loop->dispatch_start_microsecond() != start)
+	{
+		return; // Moved on meanwhile.
+	}
+	string backtrace;
+	if(capture_backtrace_ == true)
+	{
+		backtrace = CaptureBacktrace(loop->thread_id());
+		if(loop->dispatch_start_microsecond() != start)
+		{
+			backtrace.clear(); // The stack is from the callback after.
+		}
+	}
+	reported_start = start;
+	++stall_number_;
+	stall_callback_(loop,
+	                fd,
+	                static_cast<double>(now - start) / TimeStamp::kMicrosecondPerSecond,
+	                backtrace);
+}
+string LoopWatchdog::CaptureBacktrace(int thread_id)
+{
+	MutexLockGuard lock(g_capture_mutex);
+	g_frame_number.store(-1, std::memory_order_relaxed);
+	if(::syscall(SYS_tgkill, ::getpid(), thread_id, SIGRTMIN) < 0)
+	{
+		LOG_ERROR("tgkill(%d): ERROR", thread_id);
+		return string();
+	}
+	int frame_number = -1;
+	for(int wait = 0; wait < 100; ++wait) // At most 100ms.
+	{
+		frame_number = g_frame_number.load(std::memory_order_acquire);
+		if(frame_number >= 0)
+		{
+			break;
+		}
+		::usleep(1000);
+	}
+	if(frame_number < 0)
+	{
+		// Too late: the handler may still write g_frame_array, the next capture resets.
+		return string();
+	}
+	string backtrace;
+	char **symbol_array = ::backtrace_symbols(g_frame_array, frame_number);
+	if(symbol_array != nullptr)
+	{
+		// Frame 0 is the handler, frame 1 the signal trampoline.
+		for(int index = 2; index < frame_number; ++index)
+		{
+			backtrace.append(symbol_array[index]).push_back('\n');
+		}
+		::free(symbol_array);
+	}
+	return backtrace;
+}
+
+void LoopWatchdog::DefaultStallCallback(EventLoop *loop,
+                                        int fd,
+                                        double second,
+                                        const string &backtrace)
+{
+	const char *kind = (fd == EventLoop::kTimerDispatch) ? "timers" :
+	                   (fd == EventLoop::kTaskDispatch) ? "tasks" :
+	                   (fd == EventLoop::kCompletionDispatch) ? "completions" : "channel";
+	LOG_WARN("EventLoop %p of thread %d is stuck in %s fd = %d for %.3fs\n%s",
+	         loop, loop->thread_id(), kind, fd, second, backtrace.c_str());
+}
@@ -0,0 +1,91 @@
+#ifndef NETLIB_NETLIB_LOOP_WATCHDOG_H_
+#define NETLIB_NETLIB_LOOP_WATCHDOG_H_
+
+#include <stdint.h> // int64_t
+
+#include <functional> // function<>
+#include <map>
+#include <string>
+
+#include <netlib/condition.h>
+#include <netlib/mutex.h>
+#include <netlib/non_copyable.h>
+#include <netlib/thread.h>
+
+namespace netlib
+{
+
+class EventLoop;
+
+// Interface:
+// Ctor
+// Dtor -> +Stop
+// Setter: stall_callback
+// Register
+// Unregister
+// Start -> -ThreadMainFunction -> -CheckLoop -> -CaptureBacktrace -> -DefaultStallCallback
+// Stop
+// Getter: stall_number
+
+// Reports EventLoops stuck in one callback: a blocking call or a long computation in
+// an IO thread stalls every other connection of that loop. A thread of its own looks
+// at each registered loop every threshold / 2, through EventLoop::dispatch_*(), which
+// cost the loop thread two atomic stores per callback. A stall is reported once, with
+// the loop, the fd of the channel(or timer/task) and the backtrace of the loop thread.
+//
+// The backtrace comes from a signal(SIGRTMIN) the watchdog sends to the loop thread,
+// whose handler records the stack. A blocking system call of the stuck callback that
+// gets the signal fails with EINTR unless the kernel restarts it(SA_RESTART).
+class LoopWatchdog: public NonCopyable
+{
+public:
+	// loop, fd of EventLoop::dispatch_fd(), second stuck so far, backtrace(may be empty).
+	using StallCallback = std::function<void(EventLoop*, int, double, const std::string&)>;
+
+	explicit LoopWatchdog(double threshold_second, bool capture_backtrace = true);
+	~LoopWatchdog();
+
+	// Default: LOG_WARN the stall and the backtrace.
+	void set_stall_callback(const StallCallback &callback)
+	{
+		stall_callback_ = callback;
+	}
+	// Any thread. Unregister a loop before it is destructed.
+	void Register(EventLoop *loop);
+	void Unregister(EventLoop *loop);
+
+	void Start();
+	void Stop(); // Join the thread; it can't be started again.
+
+	int64_t stall_number() const
+	{
+		MutexLockGuard lock(mutex_);
+		return stall_number_;
+	}
+
+private:
+	// Start time of the stalled callback last reported, per loop.
+	using LoopStartMap = std::map<EventLoop*, int64_t>;
+
+	void ThreadMainFunction();
+	void CheckLoop(EventLoop *loop, int64_t &reported_start, int64_t now);
+	std::string CaptureBacktrace(int thread_id);
+	static void DefaultStallCallback(EventLoop *loop,
+	                                 int fd,
+	                                 double second,
+	                                 const std::string &backtrace);
+
+	const int64_t threshold_microsecond_;
+	const bool capture_backtrace_;
+	StallCallback stall_callback_;
+	bool running_; // Guarded by mutex_.
+	int64_t stall_number_; // Guarded by mutex_.
+	LoopStartMap loop_start_map_; // Guarded by mutex_.
+	mutable MutexLock mutex_;
+	Condition condition_; // Signaled by Stop().
+	Thread thread_;
+};
+
+}
+
+#endif // NETLIB_NETLIB_LOOP_WATCHDOG_H_
@@ -0,0 +1,96 @@
+#include <netlib/mpsc_task_queue.h>
+
+using netlib::MpscTaskQueue;
+
+thread_local MpscTaskQueue::NodeCache MpscTaskQueue::t_node_cache_;
+
+MpscTaskQueue::NodeCache::~NodeCache()
+{
+	DeleteList(head);
+}
+
+MpscTaskQueue::MpscTaskQueue():
+	head_(nullptr),
+	free_head_(nullptr)
+{}
+
+MpscTaskQueue::~MpscTaskQueue()
+{
+	DeleteList(head_.exchange(nullptr, std::memory_order_acquire));
+	DeleteList(free_head_.exchange(nullptr, std::memory_order_acquire));
+}
+
+void MpscTaskQueue::DeleteList(Node *head)
+{
+	while(head != nullptr)
+	{
+		Node *next = head->next;
+		delete head;
+		head = next;
+	}
+}
+
+void MpscTaskQueue::Push(TaskCallback &&task)
+{
+	Node *node = t_node_cache_.head;
+	if(node == nullptr)
+	{
+		// Acquire: see the `next` links and the reset tasks RunAll() released.
+		node = free_head_.exchange(nullptr, std::memory_order_acquire);
+	}
+	if(node != nullptr)
+	{
+		t_node_cache_.head = node->next;
+		node->task = std::move(task);
+	}
+	else
+	{
+		node = new Node(std::move(task));
+	}
+	node->next = head_.load(std::memory_order_relaxed);
+	// Release: the consumer that takes `node` sees its task fully constructed.
+	while(head_.compare_exchange_weak(node->next,
+	                                  node,
+	                                  std::memory_order_release,
+	                                  std::memory_order_relaxed) == false)
+	{}
+}
+
+MpscTaskQueue::Node *MpscTaskQueue::Reverse(Node *head)
+{
+	Node *reversed = nullptr;
+	while(head != nullptr)
+	{
+		Node *next = head->next;
+		head->next = reversed;
+		reversed = head;
+		head = next;
+	}
+	return reversed;
+}
+
+int MpscTaskQueue::RunAll()
+{
+	// No ABA problem: only this thread removes nodes, and it takes all of them.
+	Node *first = Reverse(head_.exchange(nullptr, std::memory_order_acquire));
+	Node *last = nullptr;
+	int task_number = 0;
+	for(Node *node = first; node != nullptr; node = node->next)
+	{
+		node->task();
+		node->task.Reset(); // Release what the task holds now, not when it is reused.
+		last = node;
+		++task_number;
+	}
+	if(first != nullptr)
+	{
+		// Splice the batch with one compare-and-swap; producers only exchange() it.
+		last->next = free_head_.load(std::memory_order_relaxed);
+		while(free_head_.compare_exchange_weak(last->next,
+		                                       first,
+		                                       std::memory_order_release,
+		                                       std::memory_order_relaxed) == false)
+		{}
+	}
+	return task_number;
+}
@@ -0,0 +1,68 @@
+#ifndef NETLIB_NETLIB_MPSC_TASK_QUEUE_H_
+#define NETLIB_NETLIB_MPSC_TASK_QUEUE_H_
+
+#include <atomic>
+
+#include <netlib/function.h>
+#include <netlib/non_copyable.h>
+
+namespace netlib
+{
+
+// Interface:
+// Ctor
+// Dtor -> -DeleteList
+// Push
+// RunAll -> -Reverse
+
+// Lock-free multi-producer/single-consumer queue of tasks: a Treiber stack of
+// recycled nodes. Push() links a node with one compare-and-swap on head_ from any
+// thread. RunAll() must be called by one thread at a time: it exchange()s the whole
+// stack out and reverses it, so the batch runs in push order, like the old swap of a
+// vector under a mutex, and tasks pushed meanwhile wait for the next RunAll().
+// Nodes are not freed after their task runs: RunAll() splices the batch onto
+// free_head_, and a producer whose thread cache is empty exchange()s that whole list
+// into it. Only whole lists ever leave free_head_, so there is no ABA problem, and
+// in the steady state Push() allocates nothing.
+class MpscTaskQueue: public NonCopyable
+{
+public:
+	MpscTaskQueue();
+	~MpscTaskQueue(); // Destruct the tasks that never ran.
+
+	void Push(TaskCallback &&task);
+	// Return the number of tasks run.
+	int RunAll();
+	bool empty() const
+	{
+		return head_.load(std::memory_order_acquire) == nullptr;
+	}
+
+private:
+	struct Node
+	{
+		explicit Node(TaskCallback &&task_arg): task(std::move(task_arg)), next(nullptr) {}
+		TaskCallback task;
+		Node *next;
+	};
+
+	// Nodes the current thread took from some queue's free_head_. Any queue's node
+	// fits any queue; the thread frees what is left when it exits.
+	struct NodeCache
+	{
+		~NodeCache();
+		Node *head = nullptr;
+	};
+
+	static Node *Reverse(Node *head);
+	static void DeleteList(Node *head);
+
+	static thread_local NodeCache t_node_cache_;
+
+	std::atomic<Node*> head_; // The latest pushed node.
+	std::atomic<Node*> free_head_; // Nodes whose task has run; pushed by RunAll().
+};
+
+}
+
+#endif // NETLIB_NETLIB_MPSC_TASK_QUEUE_H_
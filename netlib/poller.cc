@@ -0,0 +1,38 @@
+#include <netlib/poller.h>
+
+#include <netlib/epoller.h>
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_option.h>
+#include <netlib/io_uring_poller.h>
+#include <netlib/logging.h>
+
+using netlib::EventLoop;
+using netlib::EventLoopOption;
+using netlib::Poller;
+
+Poller *Poller::NewPoller(EventLoop *owner_loop, const EventLoopOption &option)
+{
+	if(option.poller_type == EventLoopOption::IO_URING)
+	{
+		IoUringPoller *poller = new IoUringPoller(owner_loop);
+		if(poller->Valid() == true)
+		{
+			return poller;
+		}
+		delete poller;
+		LOG_WARN("io_uring is unavailable, use epoll instead.");
+	}
+	return new Epoller(owner_loop);
+}
+
+Poller::Poller(EventLoop *owner_loop):
+	owner_loop_(owner_loop),
+	control_number_(0)
+{}
+Poller::~Poller()
+{}
+
+void Poller::AssertInLoopThread() const // Must be in IO thread.
+{
+	owner_loop_->AssertInLoopThread();
+}
@@ -0,0 +1,68 @@
+#ifndef NETLIB_NETLIB_POLLER_H_
+#define NETLIB_NETLIB_POLLER_H_
+
+#include <stdint.h> // int64_t
+
+#include <vector>
+
+#include <netlib/non_copyable.h>
+#include <netlib/time_stamp.h>
+
+namespace netlib
+{
+
+class Channel;
+class EventLoop;
+struct EventLoopOption;
+
+// Interface:
+// NewPoller
+// Dtor
+// Getter: control_number
+// Setter: precise_timeout
+// Poll
+// AddOrUpdateChannel
+// RemoveChannel
+// HasChannel
+
+// IO multiplexing backend of one EventLoop: Epoller or IoUringPoller.
+class Poller: public NonCopyable
+{
+public:
+	using ChannelVector = std::vector<Channel*>;
+
+	// The backend option.poller_type asks for, or Epoller if it can't be set up.
+	static Poller *NewPoller(EventLoop *owner_loop, const EventLoopOption &option);
+	virtual ~Poller();
+
+	// Registration changes sent to the kernel: epoll_ctl() calls, or poll requests
+	// queued to io_uring. Read in the loop thread.
+	int64_t control_number() const
+	{
+		return control_number_;
+	}
+	// Wait with microsecond precision rather than rounding up to milliseconds.
+	virtual void set_precise_timeout(bool on) = 0;
+
+	// Negative timeout: wait until any event happens.
+	virtual TimeStamp Poll(int64_t timeout_in_microsecond, ChannelVector &active_channel) = 0;
+	virtual void AddOrUpdateChannel(Channel *channel) = 0;
+	virtual void RemoveChannel(Channel *channel) = 0;
+	virtual bool HasChannel(Channel *channel) const = 0;
+
+protected:
+	explicit Poller(EventLoop *owner_loop);
+	void AssertInLoopThread() const;
+
+	// Channel::state_in_epoller().
+	static const int kRaw = -1; // Not registered.
+	static const int kAdded = 1; // Registered and watched by the kernel.
+	static const int kDeleted = 0; // Registered, but not watched: requests NONE_EVENT.
+
+	EventLoop *owner_loop_;
+	int64_t control_number_;
+};
+
+}
+
+#endif // NETLIB_NETLIB_POLLER_H_
@@ -0,0 +1,88 @@
+#include <netlib/slab_allocator.h>
+
+#include <assert.h> // assert()
+#include <stdlib.h> // malloc(), free()
+
+#include <netlib/event_loop.h>
+#include <netlib/logging.h>
+
+using netlib::SlabAllocator;
+
+SlabAllocator::SlabAllocator(EventLoop *owner_loop):
+	owner_loop_(owner_loop),
+	hit_number_(0),
+	miss_number_(0),
+	cached_byte_(0)
+{}
+
+SlabAllocator::~SlabAllocator()
+{
+	for(int index = 0; index < kSizeClassNumber; ++index)
+	{
+		for(FreeList::iterator it = free_list_[index].begin();
+		        it != free_list_[index].end();
+		        ++it)
+		{
+			::free(*it);
+		}
+	}
+}
+
+int SlabAllocator::SizeClass(int size)
+{
+	if(size > kMaxSize)
+	{
+		return -1;
+	}
+	int index = 0;
+	for(int class_size = kMinSize; class_size < size; class_size <<= 1)
+	{
+		++index;
+	}
+	return index;
+}
+int SlabAllocator::RoundUp(int size)
+{
+	assert(size >= 0);
+	int index = SizeClass(size);
+	return (index < 0) ? size : (kMinSize << index);
+}
+
+char *SlabAllocator::Allocate(int size)
+{
+	int index = SizeClass(size);
+	if(index >= 0 && owner_loop_->IsInLoopThread() == true)
+	{
+		FreeList &free_list = free_list_[index];
+		if(free_list.empty() == false)
+		{
+			++hit_number_;
+			cached_byte_ -= kMinSize << index;
+			char *data = free_list.back();
+			free_list.pop_back();
+			return data;
+		}
+		++miss_number_;
+	}
+	char *data = static_cast<char*>(::malloc(RoundUp(size)));
+	if(data == nullptr)
+	{
+		LOG_FATAL("SlabAllocator::Allocate(): malloc FATAL");
+	}
+	return data;
+}
+void SlabAllocator::Deallocate(char *data, int size)
+{
+	int index = SizeClass(size);
+	if(index >= 0 && owner_loop_->IsInLoopThread() == true &&
+	        static_cast<int64_t>(free_list_[index].size() + 1) * (kMinSize << index) <=
+	        kMaxCachedBytePerClass)
+	{
+		free_list_[index].push_back(data);
+		cached_byte_ += kMinSize << index;
+	}
+	else
+	{
+		::free(data);
+	}
+}
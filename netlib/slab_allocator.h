@@ -0,0 +1,74 @@
+#ifndef NETLIB_NETLIB_SLAB_ALLOCATOR_H_
+#define NETLIB_NETLIB_SLAB_ALLOCATOR_H_
+
+#include <stdint.h> // int64_t
+
+#include <vector>
+
+#include <netlib/non_copyable.h>
+
+namespace netlib
+{
+
+class EventLoop;
+
+// Interface:
+// Ctor
+// Dtor
+// RoundUp
+// Allocate -> +RoundUp -> -SizeClass
+// Deallocate -> +RoundUp -> -SizeClass
+// Getter: hit_number, miss_number, cached_byte
+
+// Size-class cache of the memory behind connections' Buffer and ChainBuffer, one per
+// EventLoop. Requests are rounded up to a power of 2 in [kMinSize, kMaxSize]; larger
+// ones are exact and never cached. Only the owner loop's thread touches the free
+// lists and counters, so there is no lock: memory allocated or released in any other
+// thread goes straight to malloc()/free(), which is safe because every chunk is
+// malloc()ed with its rounded size.
+class SlabAllocator: public NonCopyable
+{
+public:
+	static const int kMinSize = 64;
+	static const int kMaxSize = 64 * 1024; // 64KB
+	static const int kSizeClassNumber = 11; // 64B, 128B, ..., 64KB.
+	static const int kMaxCachedBytePerClass = 4 * 1024 * 1024; // 4MB
+
+	explicit SlabAllocator(EventLoop *owner_loop);
+	~SlabAllocator();
+
+	// The size that Allocate(size) really returns: callers use all of it.
+	static int RoundUp(int size);
+	char *Allocate(int size);
+	// `size` is the one passed to Allocate(), or its RoundUp().
+	void Deallocate(char *data, int size);
+
+	// Allocate() in the loop thread served from / missed the free lists.
+	int64_t hit_number() const
+	{
+		return hit_number_;
+	}
+	int64_t miss_number() const
+	{
+		return miss_number_;
+	}
+	int64_t cached_byte() const
+	{
+		return cached_byte_;
+	}
+
+private:
+	using FreeList = std::vector<char*>;
+
+	static int SizeClass(int size); // -1 for size > kMaxSize.
+
+	EventLoop *owner_loop_;
+	FreeList free_list_[kSizeClassNumber];
+	int64_t hit_number_;
+	int64_t miss_number_;
+	int64_t cached_byte_;
+};
+
+}
+
+#endif // NETLIB_NETLIB_SLAB_ALLOCATOR_H_
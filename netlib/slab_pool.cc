@@ -0,0 +1,154 @@
+#include <netlib/slab_pool.h>
+
+#include <stdlib.h> // malloc(), free()
+#include <string.h> // memcpy()
+
+#include <netlib/logging.h>
+
+using std::shared_ptr;
+using netlib::Slab;
+using netlib::SlabPool;
+
+Slab::Slab(int capacity):
+	shared_(nullptr),
+	next_(nullptr),
+	data_(static_cast<char*>(::malloc(capacity))),
+	capacity_(capacity),
+	length_(0)
+{
+	if(data_ == nullptr)
+	{
+		LOG_FATAL("Slab::Slab(): malloc FATAL");
+	}
+}
+Slab::~Slab()
+{
+	::free(data_);
+}
+
+thread_local SlabPool::ThreadCache SlabPool::t_cache_;
+
+SlabPool::Shared::Shared():
+	reference_number(1) // The pool's.
+{
+	for(int index = 0; index < kSizeClassNumber; ++index)
+	{
+		free_head[index].store(nullptr, std::memory_order_relaxed);
+		free_number[index].store(0, std::memory_order_relaxed);
+	}
+}
+SlabPool::Shared::~Shared()
+{
+	for(int index = 0; index < kSizeClassNumber; ++index)
+	{
+		DeleteList(free_head[index].load(std::memory_order_relaxed));
+	}
+}
+SlabPool::ThreadCache::~ThreadCache()
+{
+	for(int index = 0; index < kSizeClassNumber; ++index)
+	{
+		DeleteList(head[index]);
+	}
+}
+
+SlabPool::SlabPool():
+	shared_(new Shared())
+{}
+SlabPool::~SlabPool()
+{
+	Release(shared_);
+}
+
+void SlabPool::DeleteList(Slab *head)
+{
+	while(head != nullptr)
+	{
+		Slab *next = head->next_;
+		delete head;
+		head = next;
+	}
+}
+
+int SlabPool::SizeClass(int length)
+{
+	int size_class = 0;
+	for(int size = kMinSlabSize; size < length; size *= 4)
+	{
+		++size_class;
+	}
+	return (size_class < kSizeClassNumber) ? size_class : -1;
+}
+
+shared_ptr<Slab> SlabPool::Copy(const void *data, int length)
+{
+	Slab *slab = nullptr;
+	int size_class = SizeClass(length);
+	if(size_class >= 0)
+	{
+		Slab *&head = t_cache_.head[size_class];
+		if(head == nullptr)
+		{
+			// Acquire: see the `next_` links Recycle() released.
+			head = shared_->free_head[size_class].exchange(nullptr, std::memory_order_acquire);
+			int taken_number = 0;
+			for(Slab *node = head; node != nullptr; node = node->next_)
+			{
+				++taken_number;
+			}
+			shared_->free_number[size_class].fetch_sub(taken_number, std::memory_order_relaxed);
+		}
+		if(head != nullptr)
+		{
+			slab = head;
+			head = slab->next_;
+		}
+		else
+		{
+			slab = new Slab(kMinSlabSize << (2 * size_class));
+		}
+	}
+	else
+	{
+		slab = new Slab(length); // Too large to be worth caching.
+	}
+	shared_->reference_number.fetch_add(1, std::memory_order_relaxed);
+	slab->shared_ = shared_;
+	::memcpy(slab->data_, data, length);
+	slab->length_ = length;
+	return shared_ptr<Slab>(slab, &SlabPool::Recycle);
+}
+
+void SlabPool::Recycle(Slab *slab)
+{
+	Shared *shared = slab->shared_;
+	slab->shared_ = nullptr;
+	int size_class = SizeClass(slab->capacity_);
+	// Several threads may pass the check at once: the bound is only approximate.
+	if(size_class >= 0 &&
+	        shared->free_number[size_class].load(std::memory_order_relaxed) < kMaxFreeSlabNumber)
+	{
+		shared->free_number[size_class].fetch_add(1, std::memory_order_relaxed);
+		std::atomic<Slab*> &free_head = shared->free_head[size_class];
+		slab->next_ = free_head.load(std::memory_order_relaxed);
+		while(free_head.compare_exchange_weak(slab->next_,
+		                                      slab,
+		                                      std::memory_order_release,
+		                                      std::memory_order_relaxed) == false)
+		{}
+	}
+	else
+	{
+		delete slab;
+	}
+	Release(shared);
+}
+
+void SlabPool::Release(Shared *shared)
+{
+	// Acq_rel: the last one sees every slab the others pushed before deleting them.
+	if(shared->reference_number.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		delete shared;
+	}
+}
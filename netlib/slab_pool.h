@@ -0,0 +1,111 @@
+#ifndef NETLIB_NETLIB_SLAB_POOL_H_
+#define NETLIB_NETLIB_SLAB_POOL_H_
+
+#include <atomic>
+#include <memory> // shared_ptr<>
+
+#include <netlib/non_copyable.h>
+
+namespace netlib
+{
+
+class Slab;
+
+// Interface:
+// Ctor
+// Dtor -> -Release
+//			-Shared::Dtor, -ThreadCache::Dtor -> -DeleteList
+// Copy -> -SizeClass
+//			-Recycle -> -SizeClass -> -Release
+
+// Pool of reference counted Slabs, one per EventLoop, used to hand bytes from any
+// thread to the loop: the caller copies into a slab once, then only the shared_ptr
+// travels. The last owner returns the slab to the pool from whatever thread it runs
+// in, so there is no lock on either side:
+// 1.	Recycle() pushes the slab onto its size class's free list with one
+//		compare-and-swap.
+// 2.	Copy() takes a slab from the calling thread's cache and, when that is empty,
+//		exchange()s the pool's whole free list into it. Only whole lists ever leave a
+//		free list, so there is no ABA problem.
+// The free lists live in a Shared block that every handed out slab holds a
+// reference to, so a slab may outlive the pool, e.g. in a task of a destructed loop.
+class SlabPool: public NonCopyable
+{
+	friend class Slab;
+public:
+	static const int kMinSlabSize = 256; // Size classes: 256B, 1KB, 4KB, 16KB, 64KB.
+	static const int kSizeClassNumber = 5;
+	// Per size class, in the pool's free list and in each thread's cache.
+	static const int kMaxFreeSlabNumber = 64;
+
+	SlabPool();
+	~SlabPool();
+
+	std::shared_ptr<Slab> Copy(const void *data, int length);
+
+private:
+	// Referenced by the pool and by every slab it handed out; deleted by the last.
+	struct Shared
+	{
+		Shared();
+		~Shared(); // Delete the free slabs.
+
+		std::atomic<int> reference_number;
+		std::atomic<Slab*> free_head[kSizeClassNumber];
+		std::atomic<int> free_number[kSizeClassNumber]; // An upper bound, not exact.
+	};
+	// Free slabs the current thread took from some pool. A free slab belongs to no
+	// pool, so any pool's fits any pool; the thread deletes what is left at exit.
+	struct ThreadCache
+	{
+		~ThreadCache();
+		Slab *head[kSizeClassNumber] = {};
+	};
+
+	static int SizeClass(int length); // -1 if larger than the largest class.
+	static void Recycle(Slab *slab);
+	static void Release(Shared *shared);
+	static void DeleteList(Slab *head);
+
+	static thread_local ThreadCache t_cache_;
+
+	Shared *shared_;
+};
+
+// Interface:
+// Ctor
+// Dtor
+// Getter: data, capacity, length
+
+// A byte array whose capacity is one of SlabPool's size classes.
+class Slab: public NonCopyable
+{
+	friend class SlabPool;
+public:
+	explicit Slab(int capacity);
+	~Slab();
+
+	const char *data() const
+	{
+		return data_;
+	}
+	int capacity() const
+	{
+		return capacity_;
+	}
+	int length() const
+	{
+		return length_;
+	}
+
+private:
+	SlabPool::Shared *shared_; // While handed out; nullptr while free.
+	Slab *next_; // While free.
+	char *data_;
+	const int capacity_;
+	int length_; // Bytes copied in by SlabPool::Copy().
+};
+
+}
+
+#endif // NETLIB_NETLIB_SLAB_POOL_H_
@@ -72,6 +72,7 @@ int Socket::Accept(SocketAddress &peer_address)
 		case ENOMEM:
 		case ENOTSOCK:
 			LOG_FATAL("accept(): FATAL");
+			break;
 		default:
 			LOG_FATAL("accept(): Unknown");
 		}
@@ -145,3 +146,34 @@ void Socket::SetTcpNoDelay(bool on)
 		LOG_ERROR("SetTcpNoDelay error");
 	}
 }
+void Socket::SetBusyPoll(int microsecond)
+{
+#ifdef SO_BUSY_POLL
+	int ret = ::setsockopt(socket_,
+	                       SOL_SOCKET,
+	                       SO_BUSY_POLL,
+	                       &microsecond,
+	                       sizeof microsecond);
+	if(ret == -1 && microsecond > 0)
+	{
+		LOG_WARN("setsockopt(SO_BUSY_POLL): WARN");
+	}
+#ifdef SO_PREFER_BUSY_POLL
+	int option_value = (microsecond > 0) ? 1 : 0;
+	ret = ::setsockopt(socket_,
+	                   SOL_SOCKET,
+	                   SO_PREFER_BUSY_POLL,
+	                   &option_value,
+	                   sizeof option_value);
+	if(ret == -1 && microsecond > 0)
+	{
+		LOG_WARN("setsockopt(SO_PREFER_BUSY_POLL): WARN");
+	}
+#endif
+#else
+	if(microsecond > 0)
+	{
+		LOG_INFO("SO_BUSY_POLL is not supported.");
+	}
+#endif
+}
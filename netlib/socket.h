@@ -20,6 +20,7 @@ class SocketAddress;
 // SetReusePort
 // SetTcpKeepAlive
 // SetTcpNoDelay
+// SetBusyPoll
 
 class Socket: public NonCopyable
 {
@@ -41,6 +42,8 @@ public:
 	void SetReusePort(bool on);
 	void SetTcpKeepAlive(bool on);
 	void SetTcpNoDelay(bool on);
+	// SO_BUSY_POLL for `microsecond`(0: off), with SO_PREFER_BUSY_POLL where supported.
+	void SetBusyPoll(int microsecond);
 
 private:
 	const int socket_;
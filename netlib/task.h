@@ -0,0 +1,181 @@
+#ifndef NETLIB_NETLIB_TASK_H_
+#define NETLIB_NETLIB_TASK_H_
+
+#include <assert.h> // assert()
+#include <stddef.h> // size_t
+
+#include <cstddef> // max_align_t, nullptr_t
+#include <new> // placement new
+#include <type_traits> // aligned_storage<>, decay<>, enable_if<>, is_same<>
+#include <utility> // forward<>(), move()
+
+namespace netlib
+{
+
+// Interface:
+// Ctor(), Ctor(nullptr), Ctor(Function&&) -> -Construct
+// Move ctor, move assignment -> +Reset
+// Dtor -> +Reset
+// operator()
+// operator bool
+// Reset
+// IsInline
+
+// A move-only std::function<void()>. A callable of up to kInlineSize bytes, that moves
+// without throwing, lives inside the Task: e.g. std::bind() of a member function with
+// two shared_ptr, which std::function(16 bytes inline in libstdc++) puts on the heap.
+// Larger ones go to the heap. A Task is moved, never copied, so the shared_ptr it
+// holds are handed over without touching their atomic reference counts.
+class Task
+{
+public:
+	static const size_t kInlineSize = 48;
+
+	Task(): operation_(nullptr) {}
+	Task(std::nullptr_t): operation_(nullptr) {}
+	template<typename Function,
+	         typename = typename std::enable_if<
+	             std::is_same<typename std::decay<Function>::type, Task>::value == false>::type>
+	Task(Function &&function): operation_(nullptr)
+	{
+		using Type = typename std::decay<Function>::type;
+		Construct<Type>(std::forward<Function>(function),
+		                std::integral_constant<bool, IsInline<Type>()>());
+	}
+	Task(Task &&rhs) noexcept: operation_(rhs.operation_)
+	{
+		if(operation_ != nullptr)
+		{
+			operation_->move(&storage_, &rhs.storage_);
+			rhs.operation_ = nullptr;
+		}
+	}
+	Task &operator=(Task &&rhs) noexcept
+	{
+		if(this != &rhs)
+		{
+			Reset();
+			if(rhs.operation_ != nullptr)
+			{
+				rhs.operation_->move(&storage_, &rhs.storage_);
+				operation_ = rhs.operation_;
+				rhs.operation_ = nullptr;
+			}
+		}
+		return *this;
+	}
+	Task(const Task&) = delete;
+	Task &operator=(const Task&) = delete;
+	~Task()
+	{
+		Reset();
+	}
+
+	// Const like std::function: the callable itself is called as non-const.
+	void operator()() const
+	{
+		assert(operation_ != nullptr);
+		operation_->invoke(&storage_);
+	}
+	explicit operator bool() const
+	{
+		return operation_ != nullptr;
+	}
+	void Reset()
+	{
+		if(operation_ != nullptr)
+		{
+			operation_->destroy(&storage_);
+			operation_ = nullptr;
+		}
+	}
+
+	// Whether a callable of type `Type` is stored without allocating.
+	template<typename Type>
+	static constexpr bool IsInline()
+	{
+		return sizeof(Type) <= kInlineSize &&
+		       alignof(Type) <= alignof(std::max_align_t) &&
+		       std::is_nothrow_move_constructible<Type>::value;
+	}
+
+private:
+	using Storage = typename std::aligned_storage<kInlineSize, alignof(std::max_align_t)>::type;
+	// What a Task does with the callable in its storage, one table per callable type.
+	struct Operation
+	{
+		void (*invoke)(void *storage);
+		void (*move)(void *to, void *from); // Move-construct `to`, destruct `from`.
+		void (*destroy)(void *storage);
+	};
+	template<typename Type>
+	struct InlineOperation // The callable is in the storage.
+	{
+		static void Invoke(void *storage)
+		{
+			(*static_cast<Type*>(storage))();
+		}
+		static void Move(void *to, void *from)
+		{
+			::new(to) Type(std::move(*static_cast<Type*>(from)));
+			static_cast<Type*>(from)->~Type();
+		}
+		static void Destroy(void *storage)
+		{
+			static_cast<Type*>(storage)->~Type();
+		}
+		static const Operation kOperation;
+	};
+	template<typename Type>
+	struct HeapOperation // The storage holds a pointer to the callable.
+	{
+		static void Invoke(void *storage)
+		{
+			(**static_cast<Type**>(storage))();
+		}
+		static void Move(void *to, void *from)
+		{
+			*static_cast<Type**>(to) = *static_cast<Type**>(from);
+		}
+		static void Destroy(void *storage)
+		{
+			delete *static_cast<Type**>(storage);
+		}
+		static const Operation kOperation;
+	};
+
+	template<typename Type, typename Function>
+	void Construct(Function &&function, std::true_type) // Inline.
+	{
+		::new(&storage_) Type(std::forward<Function>(function));
+		operation_ = &InlineOperation<Type>::kOperation;
+	}
+	template<typename Type, typename Function>
+	void Construct(Function &&function, std::false_type) // Heap.
+	{
+		*reinterpret_cast<Type**>(&storage_) = new Type(std::forward<Function>(function));
+		operation_ = &HeapOperation<Type>::kOperation;
+	}
+
+	mutable Storage storage_;
+	const Operation *operation_; // nullptr if empty.
+};
+
+template<typename Type>
+const Task::Operation Task::InlineOperation<Type>::kOperation =
+{
+	&Task::InlineOperation<Type>::Invoke,
+	&Task::InlineOperation<Type>::Move,
+	&Task::InlineOperation<Type>::Destroy
+};
+template<typename Type>
+const Task::Operation Task::HeapOperation<Type>::kOperation =
+{
+	&Task::HeapOperation<Type>::Invoke,
+	&Task::HeapOperation<Type>::Move,
+	&Task::HeapOperation<Type>::Destroy
+};
+
+}
+
+#endif // NETLIB_NETLIB_TASK_H_
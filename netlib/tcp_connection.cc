@@ -1,16 +1,22 @@
 #include <netlib/tcp_connection.h>
 
+#include <sys/ioctl.h> // ioctl(), FIONREAD
+#include <sys/uio.h> // struct iovec
 #include <unistd.h> // write()
 
 #include <netlib/channel.h>
 #include <netlib/event_loop.h>
+#include <netlib/idle_connection_ring.h>
+#include <netlib/io_uring_poller.h>
 #include <netlib/logging.h>
+#include <netlib/slab_pool.h>
 #include <netlib/socket.h>
 #include <netlib/socket_operation.h>
 
 using std::string;
 using std::bind;
 using std::placeholders::_1;
+using std::placeholders::_2;
 using netlib::TcpConnection;
 
 void netlib::DefaultConnectionCallback(const TcpConnectionPtr &connection_ptr)
@@ -35,12 +41,30 @@ TcpConnection::TcpConnection(EventLoop *event_loop,
 	loop_(event_loop),
 	name_(string_name),
 	state_(CONNECTING),
+	io_uring_(loop_->io_uring_poller()),
 	context_(nullptr),
 	socket_(new Socket(socket)),
 	channel_(new Channel(loop_, socket)),
 	client_address_(client),
 	server_address_(server),
-	high_water_mark_(kInitialHighWaterMark)
+	input_buffer_(Buffer::kOneKilobyte, loop_->slab_allocator()),
+	output_buffer_(loop_->slab_allocator()),
+	high_water_mark_(kInitialHighWaterMark),
+	read_size_(kMinReadSize),
+	idle_shrink_pending_(false),
+	fionread_sizing_(false),
+	edge_triggered_(false),
+	idle_timeout_second_(0.0),
+	idle_shutdown_(false),
+	idle_ring_(nullptr),
+	idle_next_(nullptr),
+	idle_pprev_(nullptr),
+	idle_touch_tick_(0),
+	idle_timeout_tick_(0),
+	recv_pending_(false),
+	recv_request_(0),
+	send_pending_(false),
+	send_request_(0)
 {
 	LOG_DEBUG("TcpConnection::ctor[%s] at %p fd=%d", name_.c_str(), this, socket);
 
@@ -53,27 +77,230 @@ TcpConnection::TcpConnection(EventLoop *event_loop,
 	channel_->set_event_callback(Channel::ERROR_CALLBACK,
 	                             bind(&TcpConnection::HandleError, this));
 	socket_->SetTcpKeepAlive(true);
+	if(loop_->option().socket_busy_poll_microsecond > 0)
+	{
+		socket_->SetBusyPoll(loop_->option().socket_busy_poll_microsecond);
+	}
 }
 void TcpConnection::HandleRead(const TimeStamp &receive_time)
 {
 	loop_->AssertInLoopThread();
 
+	if(edge_triggered_ == false)
+	{
+		ReadOnce(receive_time);
+		return;
+	}
+	// No more event comes until the socket is drained, so read until EAGAIN.
+	for(int read_number = 0; read_number < kEdgeTriggeredReadBudget; ++read_number)
+	{
+		if(state_ == DISCONNECTED || ReadOnce(receive_time) == false)
+		{
+			return;
+		}
+	}
+	// Budget used up: let the other active channels run, then go on reading.
+	loop_->QueueInLoop(bind(&TcpConnection::HandleRead, shared_from_this(), receive_time));
+}
+bool TcpConnection::ReadOnce(const TimeStamp &receive_time)
+{
+	int expected_byte = read_size_, pending_byte = 0;
+	if(fionread_sizing_ == true &&
+	        ::ioctl(channel_->fd(), FIONREAD, &pending_byte) == 0 && pending_byte > 0)
+	{
+		expected_byte = pending_byte;
+	}
+	input_buffer_.EnsureWritableByte(expected_byte);
+	int offered_byte = input_buffer_.WritableByte() + EventLoop::kExtraReadBufferSize;
 	int saved_errno = 0;
-	int read_byte = input_buffer_.ReadFd(channel_->fd(), saved_errno);
+	int read_byte = input_buffer_.ReadFd(channel_->fd(),
+	                                     saved_errno,
+	                                     loop_->extra_read_buffer(),
+	                                     EventLoop::kExtraReadBufferSize);
 	if(read_byte > 0 && message_callback_)
 	{
-		message_callback_(shared_from_this(), &input_buffer_, receive_time);
+		HandleMessage(read_byte, receive_time);
+		// A short read drained the socket: skip the read that would get EAGAIN.
+		return read_byte == offered_byte;
 	}
 	else if(read_byte == 0)
 	{
 		HandleClose();
 	}
-	else
+	else if(edge_triggered_ == false || (saved_errno != EAGAIN && saved_errno != EWOULDBLOCK))
 	{
 		errno = saved_errno;
 		LOG_ERROR("TcpConnection::HandleRead()");
 		HandleError();
 	}
+	return false;
+}
+void TcpConnection::HandleMessage(int read_byte, const TimeStamp &receive_time)
+{
+	if(idle_ring_ != nullptr)
+	{
+		idle_touch_tick_ = idle_ring_->current_tick();
+	}
+	AdjustReadSize(read_byte);
+	last_read_time_ = receive_time;
+	message_callback_(shared_from_this(), &input_buffer_, receive_time);
+	if(idle_shrink_pending_ == false &&
+	        (read_size_ > kMinReadSize || input_buffer_.capacity() > 2 * kMinReadSize))
+	{
+		ScheduleIdleShrink(kIdleShrinkSecond);
+	}
+}
+void TcpConnection::AdjustReadSize(int read_byte)
+{
+	if(read_byte >= read_size_)
+	{
+		read_size_ = (read_size_ * 2 < kMaxReadSize) ? read_size_ * 2 : kMaxReadSize;
+	}
+	else if(read_byte < read_size_ / 2)
+	{
+		read_size_ = (read_size_ / 2 > kMinReadSize) ? read_size_ / 2 : kMinReadSize;
+	}
+}
+void TcpConnection::ScheduleIdleShrink(double delay)
+{
+	idle_shrink_pending_ = true;
+	// Weak: the timer must not keep a closed connection alive.
+	std::weak_ptr<TcpConnection> weak_connection(shared_from_this());
+	loop_->RunAfter([weak_connection]()
+	{
+		TcpConnectionPtr connection = weak_connection.lock();
+		if(connection)
+		{
+			connection->ShrinkIfIdle();
+		}
+	}, delay);
+}
+void TcpConnection::ShrinkIfIdle()
+{
+	idle_shrink_pending_ = false;
+	if(state_ == DISCONNECTED)
+	{
+		return;
+	}
+	double idle_second = TimeDifferenceInSecond(TimeStamp::Now(), last_read_time_);
+	if(idle_second < kIdleShrinkSecond) // Read since scheduled: check again later.
+	{
+		ScheduleIdleShrink(kIdleShrinkSecond - idle_second);
+		return;
+	}
+	read_size_ = kMinReadSize;
+	if(recv_pending_ == true) // The kernel may be filling it: shrink once canceled.
+	{
+		io_uring_->CancelRequest(recv_request_);
+		return;
+	}
+	input_buffer_.Shrink(kMinReadSize);
+}
+
+void TcpConnection::SubmitRecv()
+{
+	input_buffer_.EnsureWritableByte(read_size_);
+	recv_pending_ = true;
+	recv_request_ = io_uring_->SubmitRecv(channel_->fd(),
+	                                      input_buffer_.WritableBegin(),
+	                                      input_buffer_.WritableByte(),
+	                                      bind(&TcpConnection::HandleRecvCompletion,
+	                                           shared_from_this(), _1, _2));
+}
+void TcpConnection::HandleRecvCompletion(int result, const TimeStamp &receive_time)
+{
+	LOG_TRACE("fd = %d, result = %d, state = %s", channel_->fd(), result, StateToCString());
+	recv_pending_ = false;
+	if(state_ == DISCONNECTED) // Canceled by the close.
+	{
+		input_buffer_.DetachAllocator();
+		return;
+	}
+	if(result > 0)
+	{
+		input_buffer_.HasWritten(result);
+		if(message_callback_)
+		{
+			HandleMessage(result, receive_time);
+		}
+	}
+	else if(result == 0)
+	{
+		HandleClose();
+		return;
+	}
+	else if(result == -ECANCELED) // By ShrinkIfIdle().
+	{
+		input_buffer_.Shrink(kMinReadSize);
+	}
+	else
+	{
+		errno = -result;
+		LOG_ERROR("TcpConnection::HandleRecvCompletion()");
+		HandleError();
+		HandleClose(); // No EPOLLHUP follows to close it.
+		return;
+	}
+	if(state_ != DISCONNECTED)
+	{
+		SubmitRecv();
+	}
+}
+void TcpConnection::SubmitSend()
+{
+	struct iovec vec[kMaxSendIovecNumber];
+	int iovec_number = output_buffer_.PeekIovec(vec, kMaxSendIovecNumber);
+	send_pending_ = true;
+	send_request_ = io_uring_->SubmitWritev(channel_->fd(),
+	                                        vec,
+	                                        iovec_number,
+	                                        bind(&TcpConnection::HandleSendCompletion,
+	                                             shared_from_this(), _1));
+}
+void TcpConnection::HandleSendCompletion(int result)
+{
+	LOG_TRACE("fd = %d, result = %d, state = %s", channel_->fd(), result, StateToCString());
+	send_pending_ = false;
+	if(state_ == DISCONNECTED)
+	{
+		output_buffer_.RetrieveAll();
+		return;
+	}
+	if(result > 0)
+	{
+		output_buffer_.Retrieve(result);
+		if(output_buffer_.ReadableByte() > 0)
+		{
+			SubmitSend();
+			return;
+		}
+		if(write_complete_callback_)
+		{
+			loop_->QueueInLoop(bind(write_complete_callback_, shared_from_this()));
+		}
+		if(state_ == DISCONNECTING)
+		{
+			ShutdownInLoop();
+		}
+	}
+	else
+	{
+		// EPIPE, ECONNRESET: discard unsent data. The recv request sees the close.
+		errno = -result;
+		LOG_ERROR("TcpConnection::HandleSendCompletion()");
+		output_buffer_.RetrieveAll();
+	}
+}
+void TcpConnection::CancelPendingRequest()
+{
+	if(recv_pending_ == true)
+	{
+		io_uring_->CancelRequest(recv_request_);
+	}
+	if(send_pending_ == true)
+	{
+		io_uring_->CancelRequest(send_request_);
+	}
 }
 void TcpConnection::HandleClose()
 {
@@ -84,6 +311,11 @@ void TcpConnection::HandleClose()
 	       state_ == DISCONNECTING);
 	set_state(DISCONNECTED);
 	channel_->set_requested_event(Channel::NONE_EVENT);
+	CancelPendingRequest();
+	if(idle_ring_ != nullptr)
+	{
+		idle_ring_->Remove(this);
+	}
 	TcpConnectionPtr guard(shared_from_this());
 	connection_callback_(guard);
 	close_callback_(guard);
@@ -95,21 +327,41 @@ void TcpConnection::HandleError()
 	         name_.c_str(), error, ThreadSafeStrError(error));
 }
 
+bool TcpConnection::IsWriting()
+{
+	if(io_uring_ != nullptr) // A writev request is pending.
+	{
+		return output_buffer_.ReadableByte() > 0;
+	}
+	if(edge_triggered_ == true) // WRITE_EVENT stays requested until the connection closes.
+	{
+		return channel_->IsRequested(Channel::NONE_EVENT) == false &&
+		       output_buffer_.ReadableByte() > 0;
+	}
+	return channel_->IsRequested(Channel::WRITE_EVENT);
+}
+
 void TcpConnection::HandleWrite()
 {
 	loop_->AssertInLoopThread();
 
-	if(channel_->IsRequested(Channel::WRITE_EVENT) == true)
+	if(IsWriting() == true)
 	{
-		int write_byte = static_cast<int>(::write(channel_->fd(),
-		                                  output_buffer_.ReadableBegin(),
-		                                  output_buffer_.ReadableByte()));
+		int saved_errno = 0;
+		int write_byte = output_buffer_.WriteFd(channel_->fd(), saved_errno);
+		// Edge-triggered: flush until drained or EAGAIN, the next edge comes only then.
+		while(edge_triggered_ == true && write_byte > 0 && output_buffer_.ReadableByte() > 0)
+		{
+			write_byte = output_buffer_.WriteFd(channel_->fd(), saved_errno);
+		}
 		if(write_byte > 0)
 		{
-			output_buffer_.Retrieve(write_byte);
 			if(output_buffer_.ReadableByte() == 0)
 			{
-				channel_->set_requested_event(Channel::NOT_WRITE);
+				if(edge_triggered_ == false)
+				{
+					channel_->set_requested_event(Channel::NOT_WRITE);
+				}
 				if(write_complete_callback_)
 				{
 					loop_->QueueInLoop(bind(write_complete_callback_, shared_from_this()));
@@ -120,8 +372,9 @@ void TcpConnection::HandleWrite()
 				}
 			}
 		}
-		else
+		else if(edge_triggered_ == false || (saved_errno != EAGAIN && saved_errno != EWOULDBLOCK))
 		{
+			errno = saved_errno;
 			LOG_ERROR("TcpConnection::HandleWrite");
 		}
 	}
@@ -134,7 +387,7 @@ void TcpConnection::ShutdownInLoop()
 {
 	loop_->AssertInLoopThread();
 
-	if(channel_->IsRequested(Channel::WRITE_EVENT) == false)
+	if(IsWriting() == false)
 	{
 		socket_->ShutdownOnWrite();
 	}
@@ -148,6 +401,11 @@ TcpConnection::~TcpConnection()
 	          channel_->fd(),
 	          StateToCString());
 	assert(state_ == DISCONNECTED);
+	// Still in the ring only if destructed with its loop's pending tasks.
+	if(idle_ring_ != nullptr)
+	{
+		idle_ring_->Remove(this);
+	}
 }
 const char *TcpConnection::StateToCString() const
 {
@@ -170,6 +428,36 @@ void TcpConnection::SetTcpNoDelay(bool on)
 {
 	socket_->SetTcpNoDelay(on);
 }
+bool TcpConnection::SetRingInputBuffer(bool on)
+{
+	loop_->AssertInLoopThread();
+	if(recv_pending_ == true)
+	{
+		return input_buffer_.ring_mode() == on;
+	}
+	return input_buffer_.SetRingMode(on);
+}
+void TcpConnection::SetEdgeTriggered(bool on)
+{
+	loop_->AssertInLoopThread();
+	if(on == edge_triggered_)
+	{
+		return;
+	}
+	edge_triggered_ = on;
+	if(io_uring_ != nullptr)
+	{
+		return;
+	}
+	if(state_ == CONNECTED || state_ == DISCONNECTING) // Else ConnectEstablished() does it.
+	{
+		channel_->set_edge_triggered(on);
+		if(on == false && output_buffer_.ReadableByte() > 0)
+		{
+			channel_->set_requested_event(Channel::WRITE_EVENT);
+		}
+	}
+}
 
 void TcpConnection::ConnectEstablished()
 {
@@ -177,44 +465,105 @@ void TcpConnection::ConnectEstablished()
 	assert(state_ == CONNECTING);
 	set_state(CONNECTED);
 	channel_->set_tie(shared_from_this());
-	channel_->set_requested_event(Channel::READ_EVENT);
+	if(io_uring_ != nullptr)
+	{
+		// The channel stays unregistered: requests are submitted instead.
+	}
+	else if(edge_triggered_ == true)
+	{
+		channel_->set_edge_triggered(true);
+	}
+	else
+	{
+		channel_->set_requested_event(Channel::READ_EVENT);
+	}
 	connection_callback_(shared_from_this());
+	if(io_uring_ != nullptr && state_ != DISCONNECTED)
+	{
+		SubmitRecv();
+	}
+	if(idle_timeout_second_ > 0 && state_ == CONNECTED)
+	{
+		loop_->idle_connection_ring()->Add(this);
+	}
 }
 
 void TcpConnection::Send(const void *data, int length)
 {
 	if(state_ == CONNECTED)
 	{
-		loop_->RunInLoop(bind(&TcpConnection::SendInLoop,
-		                      this,
-		                      static_cast<const char*>(data),
-		                      length));
+		if(loop_->IsInLoopThread() == true)
+		{
+			SendInLoop(static_cast<const char*>(data), length);
+		}
+		else
+		{
+			// `data` may be gone before the loop runs the task: snapshot it.
+			loop_->QueueInLoop(bind(&TcpConnection::SendSlabInLoop,
+			                        shared_from_this(),
+			                        loop_->slab_pool()->Copy(data, length)));
+		}
 	}
 }
 void TcpConnection::Send(const string &message)
+{
+	Send(message.data(), static_cast<int>(message.size()));
+}
+void TcpConnection::Send(const BufferView &message)
+{
+	Send(message.data(), message.length());
+}
+void TcpConnection::Send(Buffer *buffer)
 {
 	if(state_ == CONNECTED)
 	{
-		// TODO: Use std::move(string&&) to avoid copy.
-		loop_->RunInLoop(bind(&TcpConnection::SendInLoop,
-		                      this,
-		                      message.data(),
-		                      static_cast<int>(message.size())));
+		if(loop_->IsInLoopThread() == true)
+		{
+			SendInLoop(buffer->ReadableBegin(), buffer->ReadableByte());
+			buffer->RetrieveAll();
+		}
+		else
+		{
+			Send(std::move(*buffer)); // Leave *buffer empty, as RetrieveAll() does.
+		}
 	}
 }
-void TcpConnection::Send(Buffer *buffer)
+void TcpConnection::Send(string &&message)
 {
 	if(state_ == CONNECTED)
 	{
-		// TODO: Use Buffer::Swap() to avoid copy.
-		loop_->RunInLoop(bind(&TcpConnection::SendInLoop,
-		                      this,
-		                      buffer->ReadableBegin(),
-		                      buffer->ReadableByte()));
-		buffer->RetrieveAll();
+		// Only the shared_ptr is copied along with the task.
+		std::shared_ptr<string> data(std::make_shared<string>(std::move(message)));
+		loop_->RunInLoop(bind(&TcpConnection::SendStringInLoop, shared_from_this(), data));
+	}
+}
+void TcpConnection::Send(Buffer &&buffer)
+{
+	if(state_ == CONNECTED)
+	{
+		std::shared_ptr<Buffer> data(std::make_shared<Buffer>(std::move(buffer)));
+		loop_->RunInLoop(bind(&TcpConnection::SendBufferInLoop, shared_from_this(), data));
 	}
 }
 void TcpConnection::SendInLoop(const char *data, int length)
+{
+	SendOrQueueInLoop(data, length, std::shared_ptr<void>());
+}
+void TcpConnection::SendSlabInLoop(const std::shared_ptr<Slab> &data)
+{
+	SendOrQueueInLoop(data->data(), data->length(), data);
+}
+void TcpConnection::SendStringInLoop(const std::shared_ptr<string> &data)
+{
+	SendOrQueueInLoop(data->data(), static_cast<int>(data->size()), data);
+}
+void TcpConnection::SendBufferInLoop(const std::shared_ptr<Buffer> &data)
+{
+	SendOrQueueInLoop(data->ReadableBegin(), data->ReadableByte(), data);
+}
+void TcpConnection::SendOrQueueInLoop(const char *data,
+                                      int length,
+                                      const std::shared_ptr<void> &owner)
 {
 	loop_->AssertInLoopThread();
 
@@ -225,7 +574,7 @@ void TcpConnection::SendInLoop(const char *data, int length)
 	}
 	int write_byte = 0, remaining_byte = length;
 	bool has_error = false;
-	if(output_buffer_.ReadableByte() == 0)
+	if(io_uring_ == nullptr && output_buffer_.ReadableByte() == 0)
 	{
 		write_byte = static_cast<int>(::write(channel_->fd(), data, length));
 		if(write_byte > 0)
@@ -262,8 +611,27 @@ void TcpConnection::SendInLoop(const char *data, int length)
 			                        shared_from_this(),
 			                        buffered_byte + remaining_byte));
 		}
-		output_buffer_.Append(data + write_byte, remaining_byte);
-		channel_->set_requested_event(Channel::WRITE_EVENT);
+		// Small tails behind queued data are cheaper to copy into the last block than
+		// to flush as one more iovec.
+		if(owner && (buffered_byte == 0 || remaining_byte >= ChainBuffer::kBlockSize))
+		{
+			output_buffer_.AppendBlock(owner, data + write_byte, remaining_byte);
+		}
+		else
+		{
+			output_buffer_.Append(data + write_byte, remaining_byte);
+		}
+		if(io_uring_ != nullptr)
+		{
+			if(send_pending_ == false)
+			{
+				SubmitSend();
+			}
+		}
+		else if(edge_triggered_ == false)
+		{
+			channel_->set_requested_event(Channel::WRITE_EVENT);
+		}
 	}
 	// if has_error = true: discard unsent data.
 }
@@ -303,7 +671,25 @@ void TcpConnection::ConnectDestroyed()
 		// Repeated as in HandleClose(): we may call ConnectDestroyed() directly.
 		set_state(DISCONNECTED);
 		channel_->set_requested_event(Channel::NONE_EVENT);
+		CancelPendingRequest();
+		if(idle_ring_ != nullptr)
+		{
+			idle_ring_->Remove(this);
+		}
 		connection_callback_(shared_from_this());
 	}
-	channel_->RemoveChannel();
+	if(io_uring_ == nullptr)
+	{
+		channel_->RemoveChannel();
+	}
+	// Recycle the buffers' memory in the loop thread, the dtor may run in any thread.
+	// The completion of a pending request does it for the buffer that it uses.
+	if(recv_pending_ == false)
+	{
+		input_buffer_.DetachAllocator();
+	}
+	if(send_pending_ == false)
+	{
+		output_buffer_.RetrieveAll();
+	}
 }
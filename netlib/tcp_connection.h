@@ -1,9 +1,12 @@
 #ifndef NETLIB_NETLIB_TCP_CONNECTION_H_
 #define NETLIB_NETLIB_TCP_CONNECTION_H_
 
+#include <stdint.h> // uint64_t
+
 #include <string>
 
 #include <netlib/buffer.h>
+#include <netlib/chain_buffer.h>
 #include <netlib/function.h>
 #include <netlib/non_copyable.h>
 #include <netlib/socket_address.h>
@@ -12,30 +15,51 @@ namespace netlib
 {
 
 class EventLoop;
+class IdleConnectionRing;
+class IoUringPoller;
 class Socket;
 class Channel;
+class Slab;
 
 // Interface:
 // Ctor -> -HandleRead -> -HandleWrite -> -HandleClose -> -HandleError
-//			-HandleRead -> -HandleClose -> -HandleError
-//			-HandleWrite -> -ShutdownInLoop
+//			-HandleRead -> -ReadOnce
+//			-ReadOnce -> -HandleMessage -> -HandleClose -> -HandleError
+//			-HandleMessage -> -AdjustReadSize -> -ScheduleIdleShrink
+//			-ScheduleIdleShrink -> -ShrinkIfIdle
+//			-HandleWrite -> -IsWriting -> -ShutdownInLoop
+//			-HandleClose -> -CancelPendingRequest
+// IO_URING loops:
+//			-SubmitRecv -> -HandleRecvCompletion -> -HandleMessage -> -HandleClose
+//			-SubmitSend -> -HandleSendCompletion -> -ShutdownInLoop
 // Dtor
-// Getter:	loop, name, context, client_address, server_address
+// Getter:	loop, name, context, client_address, server_address, read_size
 // Setter:	connection/message/write_complete/high_water_mark/close_callback
-//				context
+//				context, fionread_sizing, idle_timeout
 // Connected
 // SetTcpNoDelay
-// ConnectEstablished -> -set_state
-// Send(const void*, int)/(const string&)/(Buffer*) -> -SendInLoop
+// SetRingInputBuffer -> +AssertInLoopThread
+// SetEdgeTriggered -> +AssertInLoopThread
+// ConnectEstablished -> -set_state -> -SubmitRecv
+// Send(const void*, int)/(const string&)/(const BufferView&) -> -SendInLoop -> -SendOrQueueInLoop
+//			-SendSlabInLoop -> -SendOrQueueInLoop
+// Send(Buffer*) -> Send(Buffer&&)
+// Send(string&&) -> -SendStringInLoop -> -SendOrQueueInLoop
+// Send(Buffer&&) -> -SendBufferInLoop -> -SendOrQueueInLoop
 // Shutdown -> -ShutdownInLoop.
 // ForceClose -> -ForceCloseInLoop
 //			-ForceCloseInLoop -> -HandleClose
-// ConnectDestroyed
+// ConnectDestroyed -> -CancelPendingRequest
 
 // TCP connection, for both client and server usage.
+// In a loop whose poller is an IoUringPoller, the connection never registers its
+// channel: it keeps one recv request in flight into input_buffer_, and one writev
+// request for the queued output_buffer_ while there is any. Each request holds the
+// connection until its completion, so the kernel never writes into freed buffers.
 class TcpConnection: public NonCopyable,
 	public std::enable_shared_from_this<TcpConnection>
 {
+	friend class IdleConnectionRing;
 public:
 	// Construct with a connected socket.
 	TcpConnection(EventLoop *event_loop,
@@ -66,6 +90,11 @@ public:
 	{
 		return context_;
 	}
+	// The number of bytes the next read expects, adapted to recent reads.
+	int read_size() const
+	{
+		return read_size_;
+	}
 
 	// Setter.
 	void set_context(void *context_arg)
@@ -95,15 +124,50 @@ public:
 		high_water_mark_ = high_water_mark;
 	}
 
+	// Ask the socket how many bytes are pending(ioctl FIONREAD) before each read and
+	// make room for exactly that many. Costs one more syscall per read. Ignored by
+	// recv requests in IO_URING loops.
+	void set_fionread_sizing(bool on)
+	{
+		fionread_sizing_ = on;
+	}
+	// Close the connection once nothing has been read from it for `second`, through
+	// loop_'s IdleConnectionRing: ForceClose(), or Shutdown() if `shutdown` is true,
+	// which flushes the output first but leaves closing to the peer. Only valid before
+	// ConnectEstablished() or in the connection callback it calls. 0: never.
+	void set_idle_timeout(double second, bool shutdown = false)
+	{
+		idle_timeout_second_ = second;
+		idle_shutdown_ = shutdown;
+	}
+
 	bool Connected() const
 	{
 		return state_ == CONNECTED;
 	}
 	void SetTcpNoDelay(bool on);
+	// Keep input_buffer_ in ring mode(see Buffer::SetRingMode()), for streams that
+	// always leave a partial frame behind. Call in the loop thread, e.g. from the
+	// connection callback. Return false if the ring could not be mapped, or, in an
+	// IO_URING loop, if a recv request already fills the buffer.
+	bool SetRingInputBuffer(bool on);
+	// Register EPOLLIN|EPOLLOUT|EPOLLET once instead of switching EPOLLOUT on and off
+	// with epoll_ctl() each time output queues up and drains. Reads then loop until
+	// EAGAIN, at most kEdgeTriggeredReadBudget reads per event before yielding to the
+	// other channels. Call in the loop thread, e.g. from the connection callback.
+	// No effect in IO_URING loops, which don't wait for readiness.
+	void SetEdgeTriggered(bool on);
 	void ConnectEstablished();
+	// In the loop thread, write or queue the bytes right away. In other threads copy
+	// them once into a slab from loop_'s SlabPool, which is queued without a copy.
 	void Send(const void *data, int length);
 	void Send(const std::string &string_data);
-	void Send(Buffer *buffer_data); // TODO: Swap!
+	void Send(const BufferView &view_data);
+	void Send(Buffer *buffer_data);
+	// Take the caller's storage: the payload is neither copied into the task that
+	// crosses threads nor, when nothing is queued, into output_buffer_.
+	void Send(std::string &&string_data);
+	void Send(Buffer &&buffer_data);
 	void Shutdown();
 	void ForceClose();
 	void ConnectDestroyed();
@@ -123,24 +187,53 @@ private:
 	const char *StateToCString() const;
 
 	void HandleRead(const TimeStamp &receive_time);
+	// Read once; return true if the socket may hold more bytes.
+	bool ReadOnce(const TimeStamp &receive_time);
+	// Whether output_buffer_ is waiting for the socket to become writable.
+	bool IsWriting();
 	void HandleWrite();
 	void HandleClose();
 	void HandleError();
+	// `read_byte` more bytes in input_buffer_: run the message callback.
+	void HandleMessage(int read_byte, const TimeStamp &receive_time);
+	void AdjustReadSize(int read_byte);
+	// Call ShrinkIfIdle() after `delay` seconds unless the connection is gone.
+	void ScheduleIdleShrink(double delay);
+	// Back to kMinReadSize and a fitting input_buffer_ if nothing was read for
+	// kIdleShrinkSecond, else check again when that long has passed since the last read.
+	void ShrinkIfIdle();
+	// IO_URING loops only.
+	void SubmitRecv();
+	void HandleRecvCompletion(int result, const TimeStamp &receive_time);
+	void SubmitSend();
+	void HandleSendCompletion(int result);
+	// Their completions then find the connection DISCONNECTED and release the buffers.
+	void CancelPendingRequest();
 
 	void ShutdownInLoop();
 	void SendInLoop(const char *data, int length);
+	void SendSlabInLoop(const std::shared_ptr<Slab> &data);
+	void SendStringInLoop(const std::shared_ptr<std::string> &data);
+	void SendBufferInLoop(const std::shared_ptr<Buffer> &data);
+	// Write directly if nothing is queued, then queue the rest: as a block kept alive
+	// by `owner` when it is not null and worth a block of its own, else as a copy.
+	// IO_URING loops queue it all and submit a writev request unless one is pending.
+	void SendOrQueueInLoop(const char *data,
+	                       int length,
+	                       const std::shared_ptr<void> &owner);
 	void ForceCloseInLoop();
 
 	EventLoop *loop_;
 	const std::string name_;
 	State state_; // FIXME: Atomic.
+	IoUringPoller *io_uring_; // loop_->io_uring_poller(): nullptr unless IO_URING.
 	void *context_; // TODO: use struct encapsulate it.
 	std::unique_ptr<Socket> socket_; // connected_socket
 	std::unique_ptr<Channel> channel_;
 	const SocketAddress client_address_;
 	const SocketAddress server_address_;
-	Buffer input_buffer_;
-	Buffer output_buffer_;
+	Buffer input_buffer_; // Storage from loop_'s SlabAllocator.
+	ChainBuffer output_buffer_; // Blocks from loop_'s SlabAllocator, flushed by writev().
 	ConnectionCallback connection_callback_;
 	MessageCallback message_callback_;
 	WriteCompleteCallback write_complete_callback_;
@@ -148,6 +241,36 @@ private:
 	HighWaterMarkCallback high_water_mark_callback_;
 	int high_water_mark_;
 	static const int kInitialHighWaterMark = 64 * 1024 * 1024; // 64KB
+	// Writable bytes input_buffer_ keeps for the next read: doubled when a read fills
+	// it, halved when a read uses less than half. Reads beyond it overflow into the
+	// loop's extra_read_buffer(). After a read that leaves the connection above the
+	// minimum, a timer checks it once per kIdleShrinkSecond; when nothing has been read
+	// for that long, both are shrunk back, so idle connections keep little memory.
+	int read_size_;
+	bool idle_shrink_pending_; // Whether a ShrinkIfIdle() timer is running.
+	TimeStamp last_read_time_;
+	bool fionread_sizing_;
+	bool edge_triggered_;
+	double idle_timeout_second_;
+	bool idle_shutdown_;
+	// Owned by IdleConnectionRing: the ring the connection is in(nullptr if none),
+	// the links of its bucket list, and the ticks of the ring it was last read at
+	// and may stay idle for.
+	IdleConnectionRing *idle_ring_;
+	TcpConnection *idle_next_;
+	TcpConnection **idle_pprev_;
+	int64_t idle_touch_tick_;
+	int64_t idle_timeout_tick_;
+	// The pending requests of IO_URING loops.
+	bool recv_pending_;
+	uint64_t recv_request_;
+	bool send_pending_;
+	uint64_t send_request_;
+	static const int kEdgeTriggeredReadBudget = 16;
+	static const int kMaxSendIovecNumber = 64; // Blocks per writev request.
+	static const int kMinReadSize = 1024; // 1KB, same as Buffer's initial size.
+	static const int kMaxReadSize = 256 * 1024; // 256KB
+	static const int kIdleShrinkSecond = 2;
 };
 
 void DefaultConnectionCallback(const TcpConnectionPtr&);
@@ -11,6 +11,7 @@ using std::string;
 using std::bind;
 using std::placeholders::_1;
 using std::placeholders::_2;
+using netlib::EventLoop;
 using netlib::TcpServer;
 
 TcpServer::TcpServer(EventLoop *main_loop,
@@ -25,7 +26,9 @@ TcpServer::TcpServer(EventLoop *main_loop,
 	started_(false),
 	next_connection_id_(0),
 	connection_callback_(DefaultConnectionCallback),
-	message_callback_(DefaultMessageCallback)
+	message_callback_(DefaultMessageCallback),
+	idle_timeout_second_(0.0),
+	idle_shutdown_(false)
 {
 	acceptor_->set_new_connection_callback(
 	    bind(&TcpServer::HandleNewConnection, this, _1, _2));
@@ -56,6 +59,7 @@ void TcpServer::HandleNewConnection(int connected_socket,
 	connection_ptr->set_message_callback(message_callback_);
 	connection_ptr->set_write_complete_callback(write_complete_callback_);
 	connection_ptr->set_close_callback(bind(&TcpServer::RemoveConnection, this, _1));
+	connection_ptr->set_idle_timeout(idle_timeout_second_, idle_shutdown_);
 
 	connection_name_ptr_map_[connection_name] = connection_ptr;
 	sub_loop->RunInLoop(bind(&TcpConnection::ConnectEstablished, connection_ptr));
@@ -94,6 +98,17 @@ TcpServer::~TcpServer()
 	}
 }
 
+void TcpServer::set_loop_option(const EventLoopOption &option)
+{
+	assert(started_ == false);
+	loop_pool_->set_loop_option(option);
+}
+std::vector<EventLoop*> TcpServer::GetAllLoops() const
+{
+	assert(started_ == true);
+	return loop_pool_->GetAllLoops();
+}
+
 void TcpServer::Start()
 {
 	if(started_ == false)
@@ -3,7 +3,9 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
+#include <netlib/event_loop_option.h>
 #include <netlib/function.h>
 #include <netlib/non_copyable.h>
 #include <netlib/tcp_connection.h>
@@ -21,8 +23,9 @@ class SocketAddress;
 //			-HandleNewConnection -> -RemoveConnection
 //						-RemoveConnection -> -RemoveConnectionInLoop
 // Dtor.
-// Setter: connection_ptr, message, write_complete
+// Setter: connection_ptr, message, write_complete, loop_option, idle_timeout
 // Start.
+// GetAllLoops.
 
 class TcpServer: public NonCopyable
 {
@@ -45,8 +48,20 @@ public:
 	{
 		write_complete_callback_ = callback;
 	}
+	// Set the option of the IO loops, only valid before Start().
+	void set_loop_option(const EventLoopOption &option);
+	// Close connections idle for `second`, see TcpConnection::set_idle_timeout(). Applies
+	// to connections accepted afterwards. The tick is the IO loop's
+	// EventLoopOption::idle_timeout_tick_microsecond.
+	void set_idle_timeout(double second, bool shutdown = false)
+	{
+		idle_timeout_second_ = second;
+		idle_shutdown_ = shutdown;
+	}
 
 	void Start();
+	// The IO loops, e.g. to publish their Metrics(). Valid after Start().
+	std::vector<EventLoop*> GetAllLoops() const;
 
 private:
 	using ConnectionNamePtrMap = std::map<std::string, TcpConnectionPtr>;
@@ -66,6 +81,8 @@ private:
 	ConnectionCallback connection_callback_;
 	MessageCallback message_callback_;
 	WriteCompleteCallback write_complete_callback_;
+	double idle_timeout_second_; // 0: never.
+	bool idle_shutdown_;
 };
 
 }
@@ -5,11 +5,11 @@ using std::bind;
 using netlib::ThreadPool;
 
 ThreadPool::ThreadPool(const int thread_number,
-                       const ThreadTask &initial_task,
+                       ThreadTask &&initial_task,
                        const int max_queue_size):
 	thread_number_(thread_number),
 	thread_pool_(thread_number_),
-	initial_task_(initial_task),
+	initial_task_(std::move(initial_task)),
 	running_(false),
 	mutex_(),
 	max_queue_size_(max_queue_size),
@@ -96,14 +96,14 @@ ThreadPool::ThreadTask ThreadPool::GetAndRemoveTask()
 	ThreadTask task;
 	if(running_ == true)
 	{
-		task = task_queue_.front();
+		task = std::move(task_queue_.front());
 		task_queue_.pop_front();
 		not_full_.Signal();
 	}
 	return task;
 }
 
-void ThreadPool::RunOrAddTask(const ThreadTask &task)
+void ThreadPool::RunOrAddTask(ThreadTask &&task)
 {
 	assert(running_ == true);
 	if(thread_number_ == 0)
@@ -118,7 +118,7 @@ void ThreadPool::RunOrAddTask(const ThreadTask &task)
 			not_full_.Wait();
 		}
 		assert(IsTaskQueueFull() == false);
-		task_queue_.push_back(task);
+		task_queue_.push_back(std::move(task));
 		not_empty_.Signal();
 	}
 }
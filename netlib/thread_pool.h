@@ -8,6 +8,7 @@
 #include <netlib/condition.h>
 #include <netlib/mutex.h>
 #include <netlib/non_copyable.h>
+#include <netlib/task.h>
 
 namespace netlib
 {
@@ -23,10 +24,10 @@ namespace netlib
 class ThreadPool: public NonCopyable
 {
 public:
-	using ThreadTask = std::function<void()>;
+	using ThreadTask = Task;
 
 	explicit ThreadPool(const int thread_number,
-	                    const ThreadTask &initial_task,
+	                    ThreadTask &&initial_task,
 	                    const int max_queue_size);
 	~ThreadPool();
 	// Stop all threads and call Join() for all threads(all threads can't run again).
@@ -35,8 +36,7 @@ public:
 	// Create thread_number_ threads and start all threads.
 	void Start();
 	// Run task() if thread_number_ is 0; otherwise add task into task queue.
-	void RunOrAddTask(const ThreadTask &task);
-	// TODO: C++11 `void RunOrAddTask(ThreadTask &&task);`
+	void RunOrAddTask(ThreadTask &&task);
 
 private:
 	// The start function of thread. Start() -> RunInThread().
@@ -3,25 +3,55 @@
 using netlib::Timer;
 using netlib::TimeStamp;
 
-int64_t Timer::created_timer_number_ = 0;
-Timer::Timer(const TimerCallback &callback,
+Timer::Timer(TimerCallback &&callback,
              const TimeStamp &time_stamp,
-             double interval):
-	callback_(callback),
+             double interval,
+             double slack):
+	callback_(std::move(callback)),
 	expired_time_(time_stamp),
 	interval_(interval),
+	slack_microsecond_(static_cast<int64_t>(slack * TimeStamp::kMicrosecondPerSecond)),
 	repeat_(interval_ > 0.0),
-	sequence_(++created_timer_number_)
+	sequence_(1),
+	pending_next_(nullptr),
+	wheel_next_(nullptr),
+	wheel_pprev_(nullptr),
+	wheel_level_(0),
+	wheel_slot_(0)
 {}
 
 void Timer::Restart(const TimeStamp &now)
 {
 	if(repeat_ == true)
 	{
-		expired_time_ = AddTime(now, interval_);
+		int64_t interval = static_cast<int64_t>(interval_ * TimeStamp::kMicrosecondPerSecond);
+		interval = (interval > 0) ? interval : 1;
+		int64_t next = expired_time_.microsecond() + interval;
+		if(next <= now.microsecond())
+		{
+			next += ((now.microsecond() - next) / interval + 1) * interval;
+		}
+		expired_time_ = TimeStamp(next);
 	}
 }
 void Timer::Run() const
 {
 	callback_();
 }
+
+void Timer::Reuse(TimerCallback &&callback,
+                  const TimeStamp &time_stamp,
+                  double interval,
+                  double slack)
+{
+	callback_ = std::move(callback);
+	expired_time_ = time_stamp;
+	interval_ = interval;
+	slack_microsecond_ = static_cast<int64_t>(slack * TimeStamp::kMicrosecondPerSecond);
+	repeat_ = interval_ > 0.0;
+}
+void Timer::Recycle()
+{
+	callback_.Reset();
+	++sequence_;
+}
@@ -10,20 +10,33 @@ namespace netlib
 
 // Interface:
 // Ctor
-// Getter: expired_time, repeat, sequence
+// Getter: expired_time, deadline, repeat, sequence
 // Restart
 // Run
+// Reuse
+// Recycle
 
 class Timer: public NonCopyable
 {
+	friend class TimerQueue;
+	friend class TimingWheel;
 public:
-	Timer(const TimerCallback &callback, const TimeStamp &time_stamp, double interval);
+	// The timer may run anywhere in [time_stamp, time_stamp + slack], so that timers
+	// due close together share one wakeup.
+	Timer(TimerCallback &&callback,
+	      const TimeStamp &time_stamp,
+	      double interval,
+	      double slack = 0.0);
 
 	// Getter
-	TimeStamp expired_time() const
+	TimeStamp expired_time() const // The earliest time to run.
 	{
 		return expired_time_;
 	}
+	TimeStamp deadline() const // The latest: expired_time() + slack.
+	{
+		return TimeStamp(expired_time_.microsecond() + slack_microsecond_);
+	}
 	bool repeat() const
 	{
 		return repeat_;
@@ -33,16 +46,35 @@ public:
 		return sequence_;
 	}
 
+	// Move a repeating timer to the first multiple of its interval, counted from its
+	// first expiration, that is after `now`: periods neither drift by the latency of
+	// each run nor pile up after a stall, they are skipped.
 	void Restart(const TimeStamp &now);
 	void Run() const;
+	// Construct again in place a Timer taken off TimerQueue's free list.
+	void Reuse(TimerCallback &&callback,
+	           const TimeStamp &time_stamp,
+	           double interval,
+	           double slack);
+	// Put on the free list: free the callback's captures now, and bump the sequence,
+	// so canceling this Timer through a stale id does nothing.
+	void Recycle();
 
 private:
 	TimerCallback callback_;
 	TimeStamp expired_time_; // Absolute expiration time.
 	double interval_;
+	int64_t slack_microsecond_;
 	bool repeat_;
-	static int64_t created_timer_number_; // FIXME: Atomic
+	// Uses of this Timer object: 1 when constructed, bumped by Recycle(). Only
+	// TimerIds of the same Timer are compared, so no counter is shared.
 	int64_t sequence_;
+	Timer *pending_next_; // TimerQueue's list of timers added by other threads.
+	// Links of the TimingWheel slot list the timer is in; wheel_pprev_ is nullptr if none.
+	Timer *wheel_next_;
+	Timer **wheel_pprev_;
+	int wheel_level_;
+	int wheel_slot_;
 };
 
 }
@@ -22,13 +22,11 @@ public:
 
 private:
 	// Distinguish different Timer object by two values: <Timer*:sequence_number>.
-	// Only use Timer* is not enough since we can't distinguish two different objects that
-	// have the same memory address, which can happen if they are created at different
-	// time(malloc -> free -> malloc). So we add a sequence number that increases
-	// by 1 every time we create a new Timer object.
+	// Only use Timer* is not enough since TimerQueue reuses the Timer objects of
+	// expired and canceled timers. So we add a sequence number, per Timer object, that
+	// increases by 1 every time it is recycled. TimerQueue frees no Timer before
+	// itself: timer_ can always be read, and the id is stale once the sequences differ.
 	Timer *timer_;
-	// TODO: If two different Timer object have same address, then one must be deleted,
-	// the other is alive. How to differentiate them if not use sequence_?
 	int64_t sequence_;
 };
 
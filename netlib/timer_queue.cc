@@ -12,24 +12,35 @@
 #include <netlib/logging.h>
 #include <netlib/timer.h>
 #include <netlib/timer_id.h>
+#include <netlib/timing_wheel.h>
 
 using std::bind;
 using std::pair;
 using netlib::Channel;
 using netlib::EventLoop;
+using netlib::EventLoopOption;
 using netlib::TimerId;
 using netlib::TimerQueue;
+using netlib::TimeStamp;
+using netlib::TimingWheel;
 
-TimerQueue::TimerQueue(EventLoop *owner_loop):
+TimerQueue::TimerQueue(EventLoop *owner_loop, const EventLoopOption &option):
 	owner_loop_(owner_loop),
-	timer_fd_(CreateTimerFd()),
-	timer_fd_channel_(owner_loop_, timer_fd_)
+	timer_fd_((option.timer_mode == EventLoopOption::TIMER_FD) ? CreateTimerFd() : -1),
+	timer_fd_channel_(owner_loop_, timer_fd_),
+	pending_timer_head_(nullptr),
+	timing_wheel_((option.timer_store == EventLoopOption::TIMING_WHEEL) ?
+	              new TimingWheel(option.timing_wheel_tick_microsecond, TimeStamp::Now()) :
+	              nullptr)
 {
-	// The function signature can be different. We can choose not to use the original
-	// signature's arguments, if so, the parameter(s) supplied were ignored.
-	timer_fd_channel_.set_event_callback(Channel::READ_CALLBACK,
-	                                     bind(&TimerQueue::HandleRead, this));
-	timer_fd_channel_.set_requested_event(Channel::READ_EVENT);
+	if(timer_fd_ >= 0)
+	{
+		// The function signature can be different. We can choose not to use the original
+		// signature's arguments, if so, the parameter(s) supplied were ignored.
+		timer_fd_channel_.set_event_callback(Channel::READ_CALLBACK,
+		                                     bind(&TimerQueue::HandleRead, this));
+		timer_fd_channel_.set_requested_event(Channel::READ_EVENT);
+	}
 }
 int TimerQueue::CreateTimerFd()
 {
@@ -44,10 +55,37 @@ int TimerQueue::CreateTimerFd()
 void TimerQueue::HandleRead()
 {
 	owner_loop_->AssertInLoopThread();
-	// 1. Get expired time and read timer fd.
 	TimeStamp expired_time(TimeStamp::Now());
 	ReadTimerFd(expired_time);
-	// 2.	Get expired timers and Run their callback.
+	RunExpiredTimer(expired_time);
+}
+
+int64_t TimerQueue::TimeoutInMicrosecond(const TimeStamp &now) const
+{
+	TimeStamp first_expired_time;
+	if(timing_wheel_)
+	{
+		if(timing_wheel_->size() == 0)
+		{
+			return -1;
+		}
+		first_expired_time = timing_wheel_->NextWakeupTime();
+	}
+	else
+	{
+		if(active_timer_set_.empty() == true)
+		{
+			return -1;
+		}
+		first_expired_time = active_timer_set_.begin()->first;
+	}
+	int64_t timeout = first_expired_time.microsecond() - now.microsecond();
+	return (timeout > 0) ? timeout : 0;
+}
+void TimerQueue::RunExpiredTimer(const TimeStamp &expired_time)
+{
+	owner_loop_->AssertInLoopThread();
+	// 1. Get expired timers and Run their callback.
 	GetAndRemoveExpiredTimer(expired_time);
 	for(TimerVector::iterator it = expired_timer_vector_.begin();
 	        it != expired_timer_vector_.end();
@@ -55,7 +93,7 @@ void TimerQueue::HandleRead()
 	{
 		(*it)->Run();
 	}
-	// 3. Refresh state for next expiration.
+	// 2. Refresh state for next expiration.
 	Refresh(expired_time);
 }
 
@@ -74,21 +112,21 @@ void TimerQueue::ReadTimerFd(const TimeStamp &time_stamp)
 }
 void TimerQueue::GetAndRemoveExpiredTimer(const TimeStamp &expired_time)
 {
-	// 1. Find the first not expired timer by sentry.
-	ExpirationTimerPair sentry(expired_time, reinterpret_cast<Timer*>(UINTPTR_MAX));
-	ExpirationTimerPairSet::iterator first_not_expired =
-	    active_timer_set_.lower_bound(sentry);
-	assert(first_not_expired == active_timer_set_.end() ||
-	       expired_time < first_not_expired->first);
-	// 2. Copy expired timers to expired timer vector.
-	for(ExpirationTimerPairSet::iterator it = active_timer_set_.begin();
-	        it != first_not_expired;
-	        ++it)
+	if(timing_wheel_)
 	{
-		expired_timer_vector_.push_back(it->second);
+		timing_wheel_->Advance(expired_time, expired_timer_vector_);
+		return;
 	}
-	// 3.	Remove expired timers in active timer set.
-	active_timer_set_.erase(active_timer_set_.begin(), first_not_expired);
+	// Timers are ordered by deadline, and run from the first one while they have
+	// expired: all those whose deadline has passed, and the ones after them that are
+	// within their slack, as Linux hrtimers do. Stop at the first one not expired.
+	while(active_timer_set_.empty() == false &&
+	        (expired_time < active_timer_set_.begin()->second->expired_time()) == false)
+	{
+		expired_timer_vector_.push_back(active_timer_set_.begin()->second);
+		active_timer_set_.erase(active_timer_set_.begin());
+	}
+	assert(active_timer_set_.empty() == true || expired_time < active_timer_set_.begin()->first);
 }
 void TimerQueue::Refresh(const TimeStamp &expired_time)
 {
@@ -98,18 +136,25 @@ void TimerQueue::Refresh(const TimeStamp &expired_time)
 	        ++it)
 	{
 		if((*it)->repeat() == true &&
-		        canceling_timer_set_.find((*it)->sequence()) == canceling_timer_set_.end())
+		        canceling_timer_set_.find(*it) == canceling_timer_set_.end())
 		{
 			(*it)->Restart(expired_time);
 			InsertIntoActiveTimerSet(*it);
 		}
 		else
 		{
-			delete *it;
+			ReleaseTimer(*it);
 		}
 	}
 	// 2. Set next expired time.
-	if(active_timer_set_.empty() == false)
+	if(timing_wheel_)
+	{
+		if(timing_wheel_->size() > 0)
+		{
+			SetExpiredTime(timing_wheel_->NextWakeupTime());
+		}
+	}
+	else if(active_timer_set_.empty() == false)
 	{
 		SetExpiredTime(active_timer_set_.begin()->first);
 	}
@@ -121,11 +166,15 @@ void TimerQueue::Refresh(const TimeStamp &expired_time)
 bool TimerQueue::InsertIntoActiveTimerSet(Timer *timer)
 {
 	owner_loop_->AssertInLoopThread();
+	if(timing_wheel_)
+	{
+		return timing_wheel_->Insert(timer);
+	}
 
-	TimeStamp expired_time(timer->expired_time());
-	active_timer_set_.insert(ExpirationTimerPair(expired_time, timer));
+	TimeStamp deadline(timer->deadline());
+	active_timer_set_.insert(ExpirationTimerPair(deadline, timer));
 	bool is_first_expired = false;
-	if(expired_time == active_timer_set_.begin()->first)
+	if(deadline == active_timer_set_.begin()->first)
 	{
 		is_first_expired = true;
 	}
@@ -135,6 +184,10 @@ bool TimerQueue::InsertIntoActiveTimerSet(Timer *timer)
 }
 void TimerQueue::SetExpiredTime(const TimeStamp &expired_time)// Absolute expiration.
 {
+	if(timer_fd_ < 0) // The owner loop asks TimeoutInMicrosecond() before each wait.
+	{
+		return;
+	}
 	int64_t diff_microsecond =
 	    expired_time.microsecond() - TimeStamp::Now().microsecond();
 	if(diff_microsecond < 1000) // Round up and save system call.
@@ -156,10 +209,13 @@ void TimerQueue::SetExpiredTime(const TimeStamp &expired_time)// Absolute expira
 
 TimerQueue::~TimerQueue()
 {
-	// Always set requested event to none before RemoveChannel().
-	timer_fd_channel_.set_requested_event(Channel::NONE_EVENT);
-	timer_fd_channel_.RemoveChannel();
-	::close(timer_fd_);
+	if(timer_fd_ >= 0)
+	{
+		// Always set requested event to none before RemoveChannel().
+		timer_fd_channel_.set_requested_event(Channel::NONE_EVENT);
+		timer_fd_channel_.RemoveChannel();
+		::close(timer_fd_);
+	}
 	// TODO: If not use shared_ptr(cost too much) or unique_ptr(const property of
 	// set element), use what to avoid `delete Timer*;` by ourself?
 	for(ExpirationTimerPairSet::iterator it = active_timer_set_.begin();
@@ -170,22 +226,94 @@ TimerQueue::~TimerQueue()
 		// it->second = nullptr; error: assignment of member
 		// ‘pair<TimeStamp, Timer*>::second’ in read-only object
 	}
+	for(TimerVector::iterator it = free_timer_vector_.begin();
+	        it != free_timer_vector_.end();
+	        ++it)
+	{
+		delete *it;
+	}
+	Timer *pending = pending_timer_head_.exchange(nullptr, std::memory_order_acquire);
+	while(pending != nullptr)
+	{
+		Timer *next = pending->pending_next_;
+		delete pending;
+		pending = next;
+	}
+}
+void TimerQueue::ReleaseTimer(Timer *timer)
+{
+	timer->Recycle();
+	free_timer_vector_.push_back(timer);
 }
 
-TimerId TimerQueue::AddTimer(const TimerCallback &callback,
+TimerId TimerQueue::AddTimer(TimerCallback &&callback,
                              const TimeStamp &expired_time,
-                             double interval)
+                             double interval,
+                             double slack)
 {
-	Timer *timer = new Timer(callback, expired_time, interval);
-	owner_loop_->RunInLoop(bind(&TimerQueue::AddTimerInLoop, this, timer));
-	return TimerId(timer, timer->sequence());
+	if(owner_loop_->IsInLoopThread() == true)
+	{
+		Timer *timer = nullptr;
+		if(free_timer_vector_.empty() == false)
+		{
+			timer = free_timer_vector_.back();
+			free_timer_vector_.pop_back();
+			timer->Reuse(std::move(callback), expired_time, interval, slack);
+		}
+		else
+		{
+			timer = new Timer(std::move(callback), expired_time, interval, slack);
+		}
+		AddTimerInLoop(timer);
+		return TimerId(timer, timer->sequence());
+	}
+	// Only the loop thread touches the free list: the new Timer joins it later.
+	Timer *timer = new Timer(std::move(callback), expired_time, interval, slack);
+	// Read before the loop may run, expire and recycle the timer.
+	int64_t sequence = timer->sequence();
+	Timer *head = pending_timer_head_.load(std::memory_order_relaxed);
+	do
+	{
+		timer->pending_next_ = head;
+	}
+	while(pending_timer_head_.compare_exchange_weak(head,
+	        timer,
+	        std::memory_order_release,
+	        std::memory_order_relaxed) == false);
+	// The first timer into an empty list queues the one task that adds them all.
+	if(head == nullptr)
+	{
+		owner_loop_->QueueInLoop(bind(&TimerQueue::AddPendingTimerInLoop, this));
+	}
+	return TimerId(timer, sequence);
 }
 void TimerQueue::AddTimerInLoop(Timer *timer)
 {
 	owner_loop_->AssertInLoopThread();
 	if(InsertIntoActiveTimerSet(timer) == true)
 	{
-		SetExpiredTime(timer->expired_time());
+		SetExpiredTime(timing_wheel_ ? timing_wheel_->NextWakeupTime() : timer->deadline());
+	}
+}
+void TimerQueue::AddPendingTimerInLoop()
+{
+	owner_loop_->AssertInLoopThread();
+	Timer *timer = pending_timer_head_.exchange(nullptr, std::memory_order_acquire);
+	bool first_changed = false;
+	while(timer != nullptr)
+	{
+		Timer *next = timer->pending_next_;
+		timer->pending_next_ = nullptr;
+		if(InsertIntoActiveTimerSet(timer) == true)
+		{
+			first_changed = true;
+		}
+		timer = next;
+	}
+	if(first_changed == true) // Once per batch.
+	{
+		SetExpiredTime(timing_wheel_ ? timing_wheel_->NextWakeupTime() :
+		               active_timer_set_.begin()->first);
 	}
 }
 
@@ -197,16 +325,39 @@ void TimerQueue::CancelTimerInLoop(const TimerId &timer_id)
 {
 	owner_loop_->AssertInLoopThread();
 
+	// A timer added by the thread that cancels it may still wait in the pending list.
+	if(pending_timer_head_.load(std::memory_order_relaxed) != nullptr)
+	{
+		AddPendingTimerInLoop();
+	}
 	Timer *timer = timer_id.timer_;
+	// No Timer is freed before the queue, so this read is safe even if the id is stale.
+	if(timer->sequence() != timer_id.sequence_) // Expired or canceled, maybe reused since.
+	{
+		return;
+	}
+	if(timing_wheel_)
+	{
+		if(timing_wheel_->Contain(timer) == true)
+		{
+			timing_wheel_->Remove(timer);
+			ReleaseTimer(timer);
+		}
+		else // Running now: don't restart it.
+		{
+			canceling_timer_set_.insert(timer);
+		}
+		return;
+	}
 	ExpirationTimerPairSet::iterator it =
-	    active_timer_set_.find(ExpirationTimerPair(timer->expired_time(), timer));
+	    active_timer_set_.find(ExpirationTimerPair(timer->deadline(), timer));
 	if(it != active_timer_set_.end())
 	{
 		active_timer_set_.erase(it);
-		delete timer;
+		ReleaseTimer(timer);
 	}
 	else
 	{
-		canceling_timer_set_.insert(timer->sequence());
+		canceling_timer_set_.insert(timer);
 	}
 }
@@ -1,9 +1,12 @@
 #ifndef NETLIB_NETLIB_TIMER_QUEUE_H_
 #define NETLIB_NETLIB_TIMER_QUEUE_H_
 
+#include <atomic>
+#include <memory> // unique_ptr<>
 #include <set>
 #include <vector>
 
+#include <netlib/event_loop_option.h>
 #include <netlib/function.h>
 #include <netlib/channel.h>
 #include <netlib/non_copyable.h>
@@ -15,29 +18,44 @@ namespace netlib
 class EventLoop;
 class Timer;
 class TimerId;
+class TimingWheel;
 
 // Interface:
 // Ctor -> -CreateTimerFd -> -HandleRead
-//			-HandleRead -> -ReadTimerFd -> -GetAndRemoveExpiredTimer -> -Refresh.
-//						-Refresh -> -InsertIntoActiveTimerSet -> -SetExpiredTime.
+//			-HandleRead -> -ReadTimerFd -> +RunExpiredTimer
 // Dtor.
+// TimeoutInMicrosecond
+// RunExpiredTimer -> -GetAndRemoveExpiredTimer -> -Refresh.
+//			-Refresh -> -InsertIntoActiveTimerSet -> -SetExpiredTime.
+//			-Refresh -> -ReleaseTimer
 // AddTimer -> -AddTimerInLoop -> -InsertIntoActiveTimerSet -> SetExpiredTime.
-// CancelTimer -> -CancelTimerInLoop.
+//			-AddPendingTimerInLoop -> -InsertIntoActiveTimerSet -> SetExpiredTime.
+// CancelTimer -> -CancelTimerInLoop -> -AddPendingTimerInLoop
+//			-CancelTimerInLoop -> -ReleaseTimer.
 
 class TimerQueue: public NonCopyable
 {
 public:
-	TimerQueue(EventLoop *owner_loop);
+	// Without a timerfd(EventLoopOption::EPOLL_TIMEOUT) the owner loop must sleep at
+	// most TimeoutInMicrosecond() and call RunExpiredTimer() after each wakeup.
+	// option.timer_store chooses where the active timers are kept.
+	TimerQueue(EventLoop *owner_loop, const EventLoopOption &option);
 	~TimerQueue();
 
-	TimerId AddTimer(const TimerCallback &callback,
+	TimerId AddTimer(TimerCallback &&callback,
 	                 const TimeStamp &expired_time,
-	                 double interval);
+	                 double interval,
+	                 double slack);
 	void CancelTimer(const TimerId &timer_id);
 
+	// Microseconds from `now` until the first timer deadline: 0 if it has passed,
+	// -1 if there is no timer.
+	int64_t TimeoutInMicrosecond(const TimeStamp &now) const;
+	void RunExpiredTimer(const TimeStamp &now);
+
 private:
 	using TimerVector = std::vector<Timer*>;
-	using ExpirationTimerPair = std::pair<TimeStamp, Timer*>;
+	using ExpirationTimerPair = std::pair<TimeStamp, Timer*>; // Keyed by deadline().
 	using ExpirationTimerPairSet = std::set<ExpirationTimerPair>;
 
 	int CreateTimerFd();
@@ -48,14 +66,24 @@ private:
 	bool InsertIntoActiveTimerSet(Timer *timer); // Return true if `timer` will expire first.
 	void SetExpiredTime(const TimeStamp &expiration);
 	void AddTimerInLoop(Timer *timer);
+	void AddPendingTimerInLoop(); // All in pending_timer_head_.
 	void CancelTimerInLoop(const TimerId &timer_id);
+	void ReleaseTimer(Timer *timer); // Recycle into free_timer_vector_.
 
 	EventLoop *owner_loop_;
-	const int timer_fd_;
+	const int timer_fd_; // -1 if timers are driven by the epoll_wait() timeout.
 	Channel timer_fd_channel_;
-	ExpirationTimerPairSet active_timer_set_;
+	// Timers added by other threads, pushed lock-free through Timer::pending_next_ and
+	// added in batch by one task, queued by the push that finds the list empty.
+	std::atomic<Timer*> pending_timer_head_;
+	ExpirationTimerPairSet active_timer_set_; // TIMER_SET.
+	std::unique_ptr<TimingWheel> timing_wheel_; // TIMING_WHEEL, nullptr otherwise.
 	TimerVector expired_timer_vector_;
-	std::set<int64_t> canceling_timer_set_;
+	std::set<Timer*> canceling_timer_set_; // Canceled while running.
+	// Expired and canceled Timers, reused by AddTimer() in the loop thread. None is
+	// deleted before the queue, so a stale TimerId always points at a Timer, whose
+	// sequence then differs from the id's. The list keeps the peak number of timers.
+	TimerVector free_timer_vector_;
 };
 
 }
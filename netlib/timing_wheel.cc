@@ -0,0 +1,225 @@
+#include <netlib/timing_wheel.h>
+
+#include <assert.h> // assert()
+#include <string.h> // memset()
+
+#include <netlib/timer.h>
+
+using netlib::Timer;
+using netlib::TimeStamp;
+using netlib::TimingWheel;
+
+TimingWheel::TimingWheel(int64_t tick_microsecond, const TimeStamp &now):
+	tick_microsecond_(tick_microsecond),
+	current_tick_(now.microsecond() / tick_microsecond),
+	next_tick_(INT64_MAX),
+	timer_number_(0)
+{
+	assert(tick_microsecond_ > 0);
+	memset(level_, 0, sizeof level_);
+}
+TimingWheel::~TimingWheel()
+{
+	for(int level = 0; level < kLevelNumber; ++level)
+	{
+		for(int slot = 0; slot < kSlotNumber; ++slot)
+		{
+			Timer *timer = level_[level].slot[slot];
+			while(timer != nullptr)
+			{
+				Timer *next = timer->wheel_next_;
+				delete timer;
+				timer = next;
+			}
+		}
+	}
+}
+
+bool TimingWheel::Insert(Timer *timer)
+{
+	assert(Contain(timer) == false);
+	int64_t expired_tick = ExpiredTick(timer);
+	if(expired_tick <= current_tick_) // Already due: the next tick.
+	{
+		expired_tick = current_tick_ + 1;
+	}
+	int64_t old_next_tick = next_tick_;
+	Link(timer, expired_tick);
+	++timer_number_;
+	return next_tick_ < old_next_tick;
+}
+void TimingWheel::Link(Timer *timer, int64_t expired_tick)
+{
+	int64_t distance = expired_tick - current_tick_;
+	int level = 0;
+	while(level < kLevelNumber - 1 &&
+	        distance >= (static_cast<int64_t>(1) << (kSlotBit * (level + 1))))
+	{
+		++level;
+	}
+	int64_t max_distance = (static_cast<int64_t>(1) << (kSlotBit * kLevelNumber)) - 1;
+	if(distance > max_distance) // Beyond the wheel: park in the farthest slot.
+	{
+		expired_tick = current_tick_ + max_distance;
+	}
+	int shift = kSlotBit * level;
+	int slot = static_cast<int>((expired_tick >> shift) & kSlotMask);
+
+	Level &wheel_level = level_[level];
+	Timer *&head = wheel_level.slot[slot];
+	timer->wheel_next_ = head;
+	if(head != nullptr)
+	{
+		head->wheel_pprev_ = &timer->wheel_next_;
+	}
+	head = timer;
+	timer->wheel_pprev_ = &head;
+	timer->wheel_level_ = level;
+	timer->wheel_slot_ = slot;
+	wheel_level.occupied[slot / 64] |= static_cast<uint64_t>(1) << (slot % 64);
+	++wheel_level.timer_number;
+	// Due then on level 0; on a higher level, cascaded at the start of its block.
+	SetNextTick((expired_tick >> shift) << shift);
+}
+
+int64_t TimingWheel::ExpiredTick(const Timer *timer) const
+{
+	// Round up: never fire before expired_time().
+	int64_t first_tick =
+	    (timer->expired_time().microsecond() + tick_microsecond_ - 1) / tick_microsecond_;
+	int64_t last_tick = timer->deadline().microsecond() / tick_microsecond_;
+	if(last_tick <= first_tick)
+	{
+		return first_tick;
+	}
+	// Within the slack, the tick with the most trailing zero bits, as Linux timer
+	// wheel's apply_slack(): timers of close deadlines end up in the same tick.
+	int bit = 63 - __builtin_clzll(static_cast<uint64_t>(first_tick ^ last_tick));
+	return last_tick & ~((static_cast<int64_t>(1) << bit) - 1);
+}
+
+void TimingWheel::Remove(Timer *timer)
+{
+	assert(Contain(timer) == true);
+	Unlink(timer);
+	--timer_number_;
+	// next_tick_ may now be early: the spurious wakeup finds nothing and recomputes.
+}
+void TimingWheel::Unlink(Timer *timer)
+{
+	*timer->wheel_pprev_ = timer->wheel_next_;
+	if(timer->wheel_next_ != nullptr)
+	{
+		timer->wheel_next_->wheel_pprev_ = timer->wheel_pprev_;
+	}
+	Level &wheel_level = level_[timer->wheel_level_];
+	int slot = timer->wheel_slot_;
+	if(wheel_level.slot[slot] == nullptr)
+	{
+		wheel_level.occupied[slot / 64] &= ~(static_cast<uint64_t>(1) << (slot % 64));
+	}
+	--wheel_level.timer_number;
+	timer->wheel_next_ = nullptr;
+	timer->wheel_pprev_ = nullptr;
+}
+bool TimingWheel::Contain(const Timer *timer) const
+{
+	return timer->wheel_pprev_ != nullptr;
+}
+
+void TimingWheel::Advance(const TimeStamp &now, std::vector<Timer*> &expired_timer_vector)
+{
+	int64_t now_tick = now.microsecond() / tick_microsecond_;
+	while(current_tick_ < now_tick)
+	{
+		if(timer_number_ == 0)
+		{
+			current_tick_ = now_tick;
+			break;
+		}
+		// Nothing happens before next_tick_: jump over the empty ticks.
+		if(next_tick_ - 1 > current_tick_)
+		{
+			current_tick_ = (next_tick_ - 1 < now_tick) ? next_tick_ - 1 : now_tick;
+			if(current_tick_ == now_tick)
+			{
+				break;
+			}
+		}
+		++current_tick_;
+		// Level L - 1 wrapped: bring the next slot of level L down, highest level first.
+		int level = 0;
+		while(level < kLevelNumber - 1 &&
+		        ((current_tick_ >> (kSlotBit * level)) & kSlotMask) == 0)
+		{
+			++level;
+		}
+		for(; level > 0; --level)
+		{
+			Cascade(level);
+		}
+		int slot = static_cast<int>(current_tick_ & kSlotMask);
+		while(level_[0].slot[slot] != nullptr)
+		{
+			Timer *timer = level_[0].slot[slot];
+			Unlink(timer);
+			--timer_number_;
+			expired_timer_vector.push_back(timer);
+		}
+		next_tick_ = INT64_MAX;
+		RecomputeNextTick();
+	}
+}
+void TimingWheel::Cascade(int level)
+{
+	int slot = static_cast<int>((current_tick_ >> (kSlotBit * level)) & kSlotMask);
+	Timer *timer = level_[level].slot[slot];
+	while(timer != nullptr)
+	{
+		Timer *next = timer->wheel_next_;
+		Unlink(timer);
+		int64_t expired_tick = ExpiredTick(timer);
+		Link(timer, (expired_tick < current_tick_) ? current_tick_ : expired_tick);
+		timer = next;
+	}
+}
+void TimingWheel::RecomputeNextTick()
+{
+	for(int level = 0; level < kLevelNumber; ++level)
+	{
+		if(level_[level].timer_number > 0)
+		{
+			int shift = kSlotBit * level;
+			int64_t block = current_tick_ >> shift;
+			int distance = NextOccupiedSlot(level, static_cast<int>(block & kSlotMask));
+			SetNextTick((block + distance) << shift);
+		}
+	}
+}
+int TimingWheel::NextOccupiedSlot(int level, int from) const
+{
+	const uint64_t *occupied = level_[level].occupied;
+	// Scan the words from the one of `from + 1`, around the wheel, back to `from`.
+	int start = (from + 1) & kSlotMask;
+	for(int step = 0; step <= kWordNumber; ++step) // The first word twice.
+	{
+		int word = (start / 64 + step) % kWordNumber;
+		uint64_t bit = occupied[word];
+		if(step == 0)
+		{
+			bit &= ~static_cast<uint64_t>(0) << (start % 64); // Slots before `start`.
+		}
+		else if(step == kWordNumber)
+		{
+			bit &= (start % 64 == 0) ? 0 : ~static_cast<uint64_t>(0) >> (64 - start % 64);
+		}
+		if(bit != 0)
+		{
+			int slot = word * 64 + __builtin_ctzll(bit);
+			int distance = (slot - from) & kSlotMask;
+			return (distance == 0) ? kSlotNumber : distance;
+		}
+	}
+	assert(false); // Only called for a level with timers.
+	return kSlotNumber;
+}
@@ -0,0 +1,105 @@
+#ifndef NETLIB_NETLIB_TIMING_WHEEL_H_
+#define NETLIB_NETLIB_TIMING_WHEEL_H_
+
+#include <stdint.h> // int64_t, uint64_t
+
+#include <vector>
+
+#include <netlib/non_copyable.h>
+#include <netlib/time_stamp.h>
+
+namespace netlib
+{
+
+class Timer;
+
+// Interface:
+// Ctor
+// Dtor
+// Insert -> -ExpiredTick
+//			-Link -> -SetNextTick
+// Remove -> -Unlink
+// Contain
+// Advance -> -Cascade -> -ExpiredTick
+//			-Cascade -> -Link
+//			-Unlink
+//			-RecomputeNextTick -> -NextOccupiedSlot
+// NextWakeupTime
+// Getter: size, tick_microsecond
+
+// Hashed hierarchical timing wheel(Varghese & Lauck), as in the Linux kernel timers:
+// kLevelNumber levels of kSlotNumber slots, level L counting in units of
+// kSlotNumber^L ticks. A timer goes to the lowest level whose range covers its
+// distance from now, in the slot of its expiration; each time level L-1 wraps, the
+// next slot of level L is cascaded, i.e. its timers are inserted again, now closer.
+// Slots are intrusive lists of Timers: Insert() and Remove() are O(1), Advance() is
+// O(1) per tick passed plus the timers it moves.
+//
+// Timers expire at the first tick boundary at or after their expired_time(), so up to
+// one tick late, and in no particular order within a tick. A timer with slack expires
+// at the roundest tick before its deadline() instead, shared with other timers.
+class TimingWheel: public NonCopyable
+{
+public:
+	TimingWheel(int64_t tick_microsecond, const TimeStamp &now);
+	~TimingWheel(); // Delete the timers still in the wheel.
+
+	// Return true if the next wakeup time moves earlier.
+	bool Insert(Timer *timer);
+	void Remove(Timer *timer);
+	bool Contain(const Timer *timer) const;
+	// Take out the timers due by `now`, in expiration order of their ticks.
+	void Advance(const TimeStamp &now, std::vector<Timer*> &expired_timer_vector);
+	// When Advance() has work: the first due tick, or an earlier cascade. Only valid if
+	// size() > 0. May be early after a Remove(), never late.
+	TimeStamp NextWakeupTime() const
+	{
+		return TimeStamp(next_tick_ * tick_microsecond_);
+	}
+
+	int size() const
+	{
+		return timer_number_;
+	}
+	int64_t tick_microsecond() const
+	{
+		return tick_microsecond_;
+	}
+
+private:
+	static const int kSlotBit = 8;
+	static const int kSlotNumber = 1 << kSlotBit; // 256
+	static const int kSlotMask = kSlotNumber - 1;
+	static const int kLevelNumber = 4; // 2^32 ticks: 49 days with a 1ms tick.
+	static const int kWordNumber = kSlotNumber / 64; // Of the occupancy bitmap.
+
+	struct Level
+	{
+		Timer *slot[kSlotNumber];
+		uint64_t occupied[kWordNumber]; // Bit i is set if slot[i] is not empty.
+		int timer_number;
+	};
+
+	int64_t ExpiredTick(const Timer *timer) const;
+	void Link(Timer *timer, int64_t expired_tick);
+	void Unlink(Timer *timer);
+	void Cascade(int level);
+	void SetNextTick(int64_t tick)
+	{
+		next_tick_ = (tick < next_tick_) ? tick : next_tick_;
+	}
+	void RecomputeNextTick();
+	// Distance(1 to kSlotNumber) from slot `from` of `level`, which must have timers,
+	// to its next occupied slot; `from` itself comes last, a full turn later.
+	int NextOccupiedSlot(int level, int from) const;
+
+	const int64_t tick_microsecond_;
+	int64_t current_tick_; // Ticks since Epoch, all processed.
+	int64_t next_tick_; // INT64_MAX if empty.
+	int timer_number_;
+	Level level_[kLevelNumber];
+};
+
+}
+
+#endif // NETLIB_NETLIB_TIMING_WHEEL_H_
@@ -0,0 +1,249 @@
+#include <endian.h> // htobe32(), be32toh()
+#include <stdio.h> // printf()
+#include <string.h> // memmove()
+
+#include <string>
+#include <vector>
+
+#include <netlib/buffer.h>
+#include <netlib/time_stamp.h>
+
+using std::string;
+using netlib::Buffer;
+using netlib::TimeStamp;
+
+const int kMicrosecondPerSecond = 1000 * 1000;
+const int kTotalByte = 1024 * 1024 * 1024; // Scan 1GB per case.
+
+// The byte loop used by Buffer::FindCRLF() before vectorization.
+const char *ByteLoopFindCRLF(const char *start, const char *end)
+{
+	for(const char *ptr = start, *last = end - 1; ptr < last; ++ptr)
+	{
+		if(*ptr == '\r' && *(ptr + 1) == '\n')
+		{
+			return ptr;
+		}
+	}
+	return nullptr;
+}
+
+void FindCRLFBench(int length)
+{
+	Buffer buffer(length);
+	buffer.Append(string(length - 2, 'a') + "\r\n");
+	const char *expected = buffer.ReadableBegin() + length - 2;
+	const char *end = buffer.ReadableBegin() + buffer.ReadableByte();
+	int round = kTotalByte / length;
+
+	TimeStamp start(TimeStamp::Now());
+	for(int index = 0; index < round; ++index)
+	{
+		// Prevent the compiler from hoisting the pure loop out of the benchmark loop.
+		const char *volatile begin = buffer.ReadableBegin();
+		if(ByteLoopFindCRLF(begin, end) != expected)
+		{
+			printf("ByteLoopFindCRLF() error!\n");
+		}
+	}
+	double byte_loop_time = TimeDifferenceInSecond(TimeStamp::Now(), start);
+
+	start = TimeStamp::Now();
+	for(int index = 0; index < round; ++index)
+	{
+		if(buffer.FindCRLF() != expected)
+		{
+			printf("FindCRLF() error!\n");
+		}
+	}
+	double find_crlf_time = TimeDifferenceInSecond(TimeStamp::Now(), start);
+
+	start = TimeStamp::Now();
+	for(int index = 0; index < round; ++index)
+	{
+		if(buffer.FindEOL() != expected + 1)
+		{
+			printf("FindEOL() error!\n");
+		}
+	}
+	double find_eol_time = TimeDifferenceInSecond(TimeStamp::Now(), start);
+
+	printf("%8d bytes: byte loop %9.3f us, FindCRLF %9.3f us, FindEOL %9.3f us, "
+	       "speedup %.2fx\n",
+	       length,
+	       byte_loop_time * kMicrosecondPerSecond / round,
+	       find_crlf_time * kMicrosecondPerSecond / round,
+	       find_eol_time * kMicrosecondPerSecond / round,
+	       byte_loop_time / find_crlf_time);
+}
+
+// The byte loop used by Buffer::MemoryCopy() before memcpy()/memmove().
+void ByteLoopCopy(char *dest, const char *src, int length)
+{
+	for(int index = 0; index < length; ++index)
+	{
+		dest[index] = src[index];
+	}
+}
+
+void AppendBench(int length)
+{
+	string data(length, 'a');
+	int round = kTotalByte / length;
+
+	// Same work as the old Append() into an emptied buffer: no resize, only copy.
+	std::vector<char> storage(Buffer::kInitialPrependableByte + length);
+	TimeStamp start(TimeStamp::Now());
+	for(int index = 0; index < round; ++index)
+	{
+		ByteLoopCopy(storage.data() + Buffer::kInitialPrependableByte, data.data(), length);
+	}
+	double byte_loop_time = TimeDifferenceInSecond(TimeStamp::Now(), start);
+
+	Buffer buffer(length);
+	start = TimeStamp::Now();
+	for(int index = 0; index < round; ++index)
+	{
+		buffer.Append(data.data(), length);
+		buffer.RetrieveAll();
+	}
+	double append_time = TimeDifferenceInSecond(TimeStamp::Now(), start);
+
+	const double kMegabyte = 1024.0 * 1024.0;
+	printf("Append %8d bytes: byte loop %9.1f MB/s, memcpy %9.1f MB/s, speedup %.2fx\n",
+	       length,
+	       kTotalByte / kMegabyte / byte_loop_time,
+	       kTotalByte / kMegabyte / append_time,
+	       byte_loop_time / append_time);
+}
+
+// The path before the typed API: Append() the hand-converted bytes, and the old
+// out-of-line PeekInt32() that copied through MemoryCopy() with a runtime length.
+__attribute__((noinline)) int32_t OldPeekInt32(const Buffer &buffer, size_t length)
+{
+	int32_t be32 = 0;
+	::memmove(&be32, buffer.ReadableBegin(), length);
+	return static_cast<int32_t>(be32toh(static_cast<uint32_t>(be32)));
+}
+
+void IntegerBench()
+{
+	const int kRound = 64 * 1024 * 1024;
+	const int kBatch = 1024; // Integers per Append/Read batch.
+	Buffer buffer(kBatch * 10);
+	int64_t sum = 0;
+
+	TimeStamp start(TimeStamp::Now());
+	for(int round = 0; round < kRound; round += kBatch)
+	{
+		for(int index = 0; index < kBatch; ++index)
+		{
+			int32_t be32 = static_cast<int32_t>(htobe32(static_cast<uint32_t>(index)));
+			buffer.Append(reinterpret_cast<const char*>(&be32), static_cast<int>(sizeof be32));
+		}
+		for(int index = 0; index < kBatch; ++index)
+		{
+			sum += OldPeekInt32(buffer, sizeof(int32_t));
+			buffer.Retrieve(static_cast<int>(sizeof(int32_t)));
+		}
+	}
+	double old_time = TimeDifferenceInSecond(TimeStamp::Now(), start);
+
+	start = TimeStamp::Now();
+	for(int round = 0; round < kRound; round += kBatch)
+	{
+		for(int index = 0; index < kBatch; ++index)
+		{
+			buffer.AppendInt32(index);
+		}
+		for(int index = 0; index < kBatch; ++index)
+		{
+			sum -= buffer.ReadInt32();
+		}
+	}
+	double int32_time = TimeDifferenceInSecond(TimeStamp::Now(), start);
+
+	start = TimeStamp::Now();
+	for(int round = 0; round < kRound; round += kBatch)
+	{
+		for(int index = 0; index < kBatch; ++index)
+		{
+			buffer.AppendVarint(static_cast<uint64_t>(index));
+		}
+		uint64_t value = 0;
+		for(int index = 0; index < kBatch; ++index)
+		{
+			buffer.ReadVarint(value);
+			sum += static_cast<int64_t>(value);
+		}
+	}
+	double varint_time = TimeDifferenceInSecond(TimeStamp::Now(), start);
+
+	const double kNanosecondPerSecond = 1e9;
+	printf("Int32 round trip: Append+PeekInt32 %.2f ns, AppendInt32+ReadInt32 %.2f ns, "
+	       "speedup %.2fx; varint(<= 2 bytes) %.2f ns, checksum %ld\n",
+	       old_time * kNanosecondPerSecond / kRound,
+	       int32_time * kNanosecondPerSecond / kRound,
+	       old_time / int32_time,
+	       varint_time * kNanosecondPerSecond / kRound,
+	       sum);
+}
+
+// A relay that reads 1000 bytes frames and always keeps a partial frame behind,
+// so the linear buffer compacts on almost every read and the ring never does.
+void RelayBench(bool ring)
+{
+	const int kRound = 4 * 1024 * 1024;
+	const int kReadByte = 1000;
+	const int kPartialByte = 2500;
+	string data(kReadByte, 'r');
+	Buffer buffer(4096 - Buffer::kInitialPrependableByte);
+	buffer.SetRingMode(ring);
+	buffer.Append(data.data(), kPartialByte);
+
+	TimeStamp start(TimeStamp::Now());
+	for(int round = 0; round < kRound; ++round)
+	{
+		buffer.Append(data.data(), kReadByte);
+		buffer.Retrieve(kReadByte);
+	}
+	double time = TimeDifferenceInSecond(TimeStamp::Now(), start);
+	printf("Relay(%s): %.2f ns per read, capacity %d\n",
+	       ring ? "ring" : "linear",
+	       time * 1e9 / kRound,
+	       buffer.capacity());
+}
+
+int main()
+{
+	FindCRLFBench(64);
+	FindCRLFBench(4 * 1024);
+	FindCRLFBench(1024 * 1024);
+
+	for(int length = 8; length <= 1024 * 1024; length *= 8)
+	{
+		AppendBench(length);
+	}
+	AppendBench(1024 * 1024);
+
+	IntegerBench();
+
+	RelayBench(false);
+	RelayBench(true);
+}
+/*
+$ ./buffer_bench
+      64 bytes: byte loop     0.119 us, FindCRLF     0.093 us, FindEOL     0.096 us, speedup 1.28x
+    4096 bytes: byte loop     7.533 us, FindCRLF     0.793 us, FindEOL     0.943 us, speedup 9.50x
+ 1048576 bytes: byte loop  2131.094 us, FindCRLF   145.196 us, FindEOL   156.094 us, speedup 14.68x
+Append        8 bytes: byte loop     365.4 MB/s, memcpy     367.3 MB/s, speedup 1.01x
+Append       64 bytes: byte loop     343.6 MB/s, memcpy    3537.6 MB/s, speedup 10.30x
+Append      512 bytes: byte loop     693.4 MB/s, memcpy   25423.9 MB/s, speedup 36.67x
+Append     4096 bytes: byte loop     795.3 MB/s, memcpy   67855.0 MB/s, speedup 85.32x
+Append    32768 bytes: byte loop     807.7 MB/s, memcpy   35551.9 MB/s, speedup 44.02x
+Append   262144 bytes: byte loop     720.4 MB/s, memcpy   36254.2 MB/s, speedup 50.32x
+Append  1048576 bytes: byte loop     887.7 MB/s, memcpy   22774.3 MB/s, speedup 25.66x
+Int32 round trip: Append+PeekInt32 12.24 ns, AppendInt32+ReadInt32 3.13 ns, speedup 3.91x; varint(<= 2 bytes) 7.95 ns, checksum 34326183936
+Relay(linear): 47.04 ns per read, capacity 4096
+Relay(ring): 15.94 ns per read, capacity 4096
+*/
@@ -1,9 +1,33 @@
+#include <errno.h> // errno, EMFILE
 #include <stdio.h>
+#include <sys/mman.h> // memfd_create()
+#include <sys/syscall.h> // SYS_memfd_create
+#include <unistd.h> // pipe(), write(), close(), syscall()
 
 #include <netlib/buffer.h>
+#include <netlib/buffer_slice.h>
+#include <netlib/thread.h>
 
 using std::string;
 using netlib::Buffer;
+using netlib::BufferSlice;
+using netlib::BufferView;
+using netlib::SlabPool;
+using netlib::Thread;
+
+// Count the rings Buffer maps: each one creates a memfd. Fail with memfd_errno if set.
+int memfd_number = 0;
+int memfd_errno = 0;
+extern "C" int memfd_create(const char *name, unsigned int flags) noexcept
+{
+	++memfd_number;
+	if(memfd_errno != 0)
+	{
+		errno = memfd_errno;
+		return -1;
+	}
+	return static_cast<int>(::syscall(SYS_memfd_create, name, flags));
+}
 
 int main()
 {
@@ -13,19 +37,205 @@ int main()
 	buffer.Append("helloworld\r\n", 12);
 	assert(*buffer.FindCRLF() == '\r');
 
-	buffer.Append(string(2000, 'a'));
+	buffer.Append(string(2000, 'a')); // Grows to 2 * (8 + 1024) bytes.
 	assert(buffer.PrependableByte() == 8 &&
 	       buffer.ReadableByte() == 2027 &&
-	       buffer.WritableByte() == 0);
+	       buffer.WritableByte() == 29);
 	printf("Retrieve 27 bytes:%s", buffer.RetrieveAsString(27).c_str());
 	assert(buffer.PrependableByte() == 35 &&
 	       buffer.ReadableByte() == 2000 &&
-	       buffer.WritableByte() == 0);
+	       buffer.WritableByte() == 29);
 
-	buffer.Append(string(20, 'b'));
+	buffer.Append(string(40, 'b')); // Moves the readable bytes to the front.
 	assert(buffer.PrependableByte() == 8 &&
-	       buffer.ReadableByte() == 2020 &&
-	       buffer.WritableByte() == 7);
-	assert(buffer.RetrieveAllAsString() == string(2000, 'a') + string(20, 'b'));
+	       buffer.ReadableByte() == 2040 &&
+	       buffer.WritableByte() == 16);
+	assert(buffer.RetrieveAllAsString() == string(2000, 'a') + string(40, 'b'));
+
+	// Appending piece by piece reallocates O(log n) times, also for varints that
+	// reserve kMaxVarintByte bytes but use one.
+	Buffer growing_buffer(16);
+	int reallocate_number = 0;
+	for(int index = 0, capacity = growing_buffer.capacity(); index < 100000; ++index)
+	{
+		if(index % 2 == 0)
+		{
+			growing_buffer.Append("x", 1);
+		}
+		else
+		{
+			growing_buffer.AppendVarint(1);
+		}
+		if(growing_buffer.capacity() != capacity)
+		{
+			capacity = growing_buffer.capacity();
+			++reallocate_number;
+		}
+	}
+	assert(growing_buffer.ReadableByte() == 100000 && reallocate_number <= 14);
+
+	// Put the delimiter at every offset around the 16/32 bytes vector boundary.
+	for(int offset = 0; offset < 100; ++offset)
+	{
+		buffer.Append(string(offset, 'c') + "\r\r\n");
+		assert(buffer.FindCRLF() == buffer.ReadableBegin() + offset + 1);
+		assert(buffer.FindEOL() == buffer.ReadableBegin() + offset + 2);
+		assert(buffer.FindByte('\r') == buffer.ReadableBegin() + offset);
+		assert(buffer.FindByte('d') == nullptr);
+		assert(buffer.FindCRLF(buffer.ReadableBegin() + offset + 2) == nullptr);
+		buffer.RetrieveAll();
+		buffer.Append(string(offset, 'c') + "\r");
+		assert(buffer.FindCRLF() == nullptr && buffer.FindEOL() == nullptr);
+		buffer.RetrieveAll();
+	}
+	// Overflow goes through the caller's extra buffer; Shrink() gives memory back.
+	int pipe_fd[2];
+	assert(::pipe(pipe_fd) == 0);
+	string data(3000, 'e');
+	assert(::write(pipe_fd[1], data.data(), data.size()) == 3000);
+	Buffer small_buffer(100);
+	char extra_buffer[4096];
+	int saved_errno = 0;
+	assert(small_buffer.ReadFd(pipe_fd[0], saved_errno, extra_buffer, 4096) == 3000);
+	assert(small_buffer.ReadableByte() == 3000 && small_buffer.RetrieveAllAsString() == data);
+	assert(small_buffer.WritableByte() == 3000);
+	small_buffer.Shrink(16);
+	assert(small_buffer.ReadableByte() == 0 && small_buffer.WritableByte() == 16);
+	::close(pipe_fd[0]);
+	::close(pipe_fd[1]);
+
+	// Integers are stored big-endian and read back with their sign.
+	Buffer integer_buffer;
+	integer_buffer.AppendInt8(-2);
+	integer_buffer.AppendInt16(0x0102);
+	integer_buffer.AppendInt32(-3);
+	integer_buffer.AppendInt64(0x0102030405060708);
+	integer_buffer.PrependInt32(15);
+	assert(integer_buffer.ReadableByte() == 4 + 1 + 2 + 4 + 8);
+	assert(integer_buffer.ReadableBegin()[3] == 15 && integer_buffer.ReadableBegin()[5] == 1);
+	assert(integer_buffer.ReadInt32() == 15);
+	assert(integer_buffer.PeekInt8() == -2 && integer_buffer.ReadInt8() == -2);
+	assert(integer_buffer.ReadInt16() == 0x0102);
+	assert(integer_buffer.ReadInt32() == -3);
+	assert(integer_buffer.ReadableBegin()[7] == 8);
+	assert(integer_buffer.ReadInt64() == 0x0102030405060708);
+	assert(integer_buffer.ReadableByte() == 0);
+
+	const uint64_t kVarint[] = {0, 1, 127, 128, 300, 16383, 16384, 0xffffffff, UINT64_MAX};
+	const int kVarintByte[] = {1, 1, 1, 2, 2, 2, 3, 5, 10};
+	for(int index = 0; index < 9; ++index)
+	{
+		integer_buffer.AppendVarint(kVarint[index]);
+		assert(integer_buffer.ReadableByte() == kVarintByte[index]);
+		uint64_t value = 0;
+		// Every proper prefix is incomplete.
+		for(int length = 1; length < kVarintByte[index]; ++length)
+		{
+			Buffer prefix;
+			prefix.Append(integer_buffer.ReadableBegin(), length);
+			assert(prefix.PeekVarint(value) == 0);
+		}
+		assert(integer_buffer.ReadVarint(value) == kVarintByte[index]);
+		assert(value == kVarint[index] && integer_buffer.ReadableByte() == 0);
+	}
+	uint64_t value = 0;
+	integer_buffer.Append(string(Buffer::kMaxVarintByte, '\x80'));
+	assert(integer_buffer.ReadVarint(value) == -1);
+	assert(integer_buffer.ReadableByte() == Buffer::kMaxVarintByte);
+	integer_buffer.RetrieveAll();
+	integer_buffer.Append(string(Buffer::kMaxVarintByte - 1, '\xff') + "\x02"); // 2^64 + ...
+	assert(integer_buffer.ReadVarint(value) == -1);
+	integer_buffer.RetrieveAll();
+
+	// Ring mode: the readable bytes stay contiguous across the wrap without moving.
+	Buffer ring_buffer;
+	ring_buffer.Append("head");
+	ring_buffer.SetRingMode(true);
+	assert(ring_buffer.ring_mode() == true && ring_buffer.RetrieveAsString(4) == "head");
+	const int kRingSize = ring_buffer.capacity();
+	assert(kRingSize % 4096 == 0 && ring_buffer.WritableByte() == kRingSize);
+	string pattern;
+	for(int index = 0; index < kRingSize; ++index)
+	{
+		pattern.push_back(static_cast<char>('a' + index % 26));
+	}
+	for(int round = 0; round < 10; ++round)
+	{
+		ring_buffer.Append(pattern.data(), kRingSize - 100);
+		assert(ring_buffer.capacity() == kRingSize && ring_buffer.ReadableByte() >= kRingSize - 100);
+		ring_buffer.Retrieve(ring_buffer.ReadableByte() - 50);
+		assert(ring_buffer.PeekView(50) == BufferView(pattern.data() + kRingSize - 150, 50));
+	}
+	assert(::pipe(pipe_fd) == 0);
+	ring_buffer.Append(pattern.data(), kRingSize - 50); // Full.
+	assert(ring_buffer.WritableByte() == 0);
+	Buffer ring_copy(ring_buffer);
+	assert(ring_buffer.WriteFd(pipe_fd[1], saved_errno) == kRingSize);
+	assert(ring_buffer.ReadableByte() == 0);
+	assert(ring_buffer.ReadFd(pipe_fd[0], saved_errno, extra_buffer, 4096) == kRingSize);
+	assert(ring_buffer.capacity() == kRingSize && ring_buffer.ReadableView() == ring_copy.ReadableView());
+	ring_buffer.Append(pattern); // Grows, keeping the content.
+	assert(ring_buffer.capacity() > kRingSize && ring_buffer.ReadableByte() == 2 * kRingSize);
+	assert(ring_buffer.RetrieveAsString(kRingSize) == ring_copy.RetrieveAllAsString());
+	assert(ring_buffer.RetrieveAllAsString() == pattern);
+	// Shrink() maps a new ring only when it is smaller.
+	int old_memfd_number = memfd_number;
+	ring_buffer.Shrink(100);
+	assert(ring_buffer.capacity() == kRingSize && memfd_number == old_memfd_number + 1);
+	for(int round = 0; round < 1000; ++round)
+	{
+		ring_buffer.Append("data", 4);
+		ring_buffer.RetrieveAll();
+		ring_buffer.Shrink(1024);
+	}
+	assert(ring_buffer.capacity() == kRingSize && memfd_number == old_memfd_number + 1);
+	// Without memfds a ring can't be mapped: buffers stay or become linear, keeping
+	// their bytes even when they wrap.
+	memfd_errno = EMFILE;
+	Buffer linear_buffer;
+	linear_buffer.Append("keep");
+	assert(linear_buffer.SetRingMode(true) == false && linear_buffer.ring_mode() == false);
+	assert(linear_buffer.RetrieveAllAsString() == "keep");
+	ring_buffer.Append(pattern.data(), kRingSize - 100);
+	ring_buffer.Retrieve(kRingSize - 150);
+	ring_buffer.Append(pattern.data(), kRingSize - 50); // Full, wrapping.
+	Buffer wrapped_copy(ring_buffer);
+	assert(wrapped_copy.ring_mode() == false && wrapped_copy.ReadableView() == ring_buffer.ReadableView());
+	ring_buffer.Append(pattern.data(), 100); // Grows into linear storage.
+	assert(ring_buffer.ring_mode() == false && ring_buffer.ReadableByte() == kRingSize + 100);
+	assert(ring_buffer.RetrieveAsString(kRingSize) == wrapped_copy.RetrieveAllAsString());
+	assert(ring_buffer.RetrieveAllAsString() == pattern.substr(0, 100));
+	memfd_errno = 0;
+	::close(pipe_fd[0]);
+	::close(pipe_fd[1]);
+
+	// Views parse in place; a slice keeps its bytes after the buffer is reused.
+	Buffer view_buffer;
+	view_buffer.Append("id:puzzle\r\nnext");
+	BufferView request = view_buffer.PeekView(
+	                         static_cast<int>(view_buffer.FindCRLF() - view_buffer.ReadableBegin()));
+	assert(request == BufferView("id:puzzle", 9) && request.Find(':') == 2);
+	assert(request.Find('x') == -1 && request.SubView(3) == string("puzzle"));
+	assert(request.SubView(3, 100).length() == 6 && request.SubView(9).empty() == true);
+	assert(view_buffer.ReadableView().length() == 15);
+	SlabPool slab_pool;
+	BufferSlice slice(&slab_pool, request);
+	BufferSlice id = slice.SubSlice(0, 2);
+	view_buffer.RetrieveAll();
+	view_buffer.Append(string(100, 'z'));
+	assert(slice.view() == string("id:puzzle") && id.view() == string("id"));
+	BufferSlice orphan; // Outlives its pool, and returns its slab to what is left of it.
+	{
+		SlabPool scoped_pool;
+		orphan = BufferSlice(&scoped_pool, slice.view());
+	}
+	assert(orphan.view() == string("id:puzzle"));
+	Thread thread([slice]
+	{
+		assert(slice.SubSlice(3, 6).view().ToString() == "puzzle");
+	});
+	thread.Start();
+	thread.Join();
+
 	printf("All passed!\n");
 }
@@ -0,0 +1,148 @@
+#include <stdio.h> // printf()
+#include <sys/wait.h> // waitpid()
+#include <unistd.h> // fork(), _exit()
+
+#include <algorithm> // sort()
+#include <string>
+#include <vector>
+
+#include <netlib/buffer.h>
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_metrics.h>
+#include <netlib/event_loop_option.h>
+#include <netlib/logging.h>
+#include <netlib/socket_address.h>
+#include <netlib/tcp_client.h>
+#include <netlib/tcp_connection.h>
+#include <netlib/tcp_server.h>
+
+using std::string;
+using std::vector;
+using netlib::Buffer;
+using netlib::EventLoop;
+using netlib::EventLoopMetrics;
+using netlib::EventLoopOption;
+using netlib::SocketAddress;
+using netlib::TcpClient;
+using netlib::TcpConnectionPtr;
+using netlib::TcpServer;
+using netlib::TimeStamp;
+
+const int kBasePort = 7300;
+const int kMessageSize = 64;
+const int kWarmupNumber = 1000;
+const int kSampleNumber = 20 * 1000;
+
+// Runs in a child process, which exits at the end.
+// One connection ping-pongs kMessageSize bytes. The server's IO loop runs in its own
+// thread with `busy_poll_microsecond`; the client loop in this thread always blocks,
+// so every round trip crosses threads twice.
+void LatencyBench(int port, int busy_poll_microsecond)
+{
+	SetLogLevel(WARN);
+	EventLoop loop;
+	const string message(kMessageSize, 'm');
+	vector<int64_t> rtt_vector;
+	rtt_vector.reserve(kSampleNumber);
+	int round_number = 0;
+	TimeStamp send_time;
+	EventLoop *io_loop = nullptr;
+
+	TcpServer server(&loop, SocketAddress(port), "BusyPollServer", 1);
+	EventLoopOption option;
+	option.busy_poll_microsecond = busy_poll_microsecond;
+	server.set_loop_option(option);
+	server.set_connection_callback([&io_loop](const TcpConnectionPtr &connection)
+	{
+		if(connection->Connected() == true)
+		{
+			connection->SetTcpNoDelay(true);
+			io_loop = connection->loop();
+		}
+	});
+	server.set_message_callback([](const TcpConnectionPtr &connection,
+	                               Buffer *buffer,
+	                               const TimeStamp&)
+	{
+		connection->Send(buffer);
+	});
+	server.Start();
+
+	TcpClient client(&loop, SocketAddress("127.0.0.1", port), "Client");
+	client.set_connection_callback([&](const TcpConnectionPtr &connection)
+	{
+		if(connection->Connected() == true)
+		{
+			connection->SetTcpNoDelay(true);
+			send_time = TimeStamp::Now();
+			connection->Send(message);
+		}
+	});
+	client.set_message_callback([&](const TcpConnectionPtr &connection,
+	                                Buffer *buffer,
+	                                const TimeStamp&)
+	{
+		while(buffer->ReadableByte() >= kMessageSize)
+		{
+			buffer->Retrieve(kMessageSize);
+			TimeStamp now(TimeStamp::Now());
+			if(++round_number > kWarmupNumber)
+			{
+				rtt_vector.push_back(now.microsecond() - send_time.microsecond());
+			}
+			if(round_number == kWarmupNumber + kSampleNumber)
+			{
+				loop.Quit();
+				return;
+			}
+			send_time = now;
+			connection->Send(message);
+		}
+	});
+	client.Connect();
+	TimeStamp start(TimeStamp::Now());
+	loop.Loop();
+	double second = TimeDifferenceInSecond(TimeStamp::Now(), start);
+
+	EventLoopMetrics metrics = io_loop->Metrics();
+	int64_t spin_microsecond = metrics.busy_poll_spin_microsecond;
+	int64_t work_microsecond = metrics.busy_poll_work_microsecond;
+
+	std::sort(rtt_vector.begin(), rtt_vector.end());
+	printf("busy poll %5d us: RTT p50 %4lld us, p99 %5lld us, p99.9 %5lld us, "
+	       "%6.0f round trips/s, server spin %6.1f ms, work %6.1f ms\n",
+	       busy_poll_microsecond,
+	       static_cast<long long>(rtt_vector[kSampleNumber / 2]),
+	       static_cast<long long>(rtt_vector[kSampleNumber * 99 / 100]),
+	       static_cast<long long>(rtt_vector[kSampleNumber * 999 / 1000]),
+	       (kWarmupNumber + kSampleNumber) / second,
+	       static_cast<double>(spin_microsecond) / 1000,
+	       static_cast<double>(work_microsecond) / 1000);
+	fflush(stdout);
+	_exit(0); // Skip the teardown of a loop that no longer runs.
+}
+
+int main()
+{
+	const int budget_array[] = {0, 50, 1000};
+	int port = kBasePort;
+	for(int budget: budget_array)
+	{
+		++port;
+		pid_t pid = ::fork();
+		if(pid == 0)
+		{
+			LatencyBench(port, budget);
+		}
+		::waitpid(pid, nullptr, 0);
+	}
+}
+/*
+$ ./busy_poll_bench # -O2, 1 CPU VM.
+busy poll     0 us: RTT p50   15 us, p99    36 us, p99.9   127 us,  62376 round trips/s, server spin    0.0 ms, work    0.0 ms
+busy poll    50 us: RTT p50   15 us, p99    72 us, p99.9    99 us,  43532 round trips/s, server spin  134.0 ms, work  288.9 ms
+busy poll  1000 us: RTT p50   15 us, p99   291 us, p99.9  1041 us,  38437 round trips/s, server spin  178.5 ms, work  323.3 ms
+With a single CPU the spinning server thread takes the time slice the client needs
+to answer, so spinning only adds latency here: busy polling pays off only when the
+loop thread has a core of its own. Spin/work are not counted with busy polling off.
+*/
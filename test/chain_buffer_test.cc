@@ -0,0 +1,81 @@
+#include <assert.h> // assert()
+#include <stdio.h> // printf()
+#include <fcntl.h> // O_NONBLOCK
+#include <unistd.h> // pipe2(), read()
+
+#include <string>
+
+#include <netlib/chain_buffer.h>
+#include <netlib/event_loop.h>
+
+using std::string;
+using netlib::ChainBuffer;
+using netlib::EventLoop;
+
+string MakeData(int length)
+{
+	string data;
+	for(int index = 0; index < length; ++index)
+	{
+		data.push_back(static_cast<char>('a' + index % 26));
+	}
+	return data;
+}
+
+int main()
+{
+	EventLoop loop;
+	const int kBlockSize = ChainBuffer::kBlockSize;
+
+	ChainBuffer buffer(loop.slab_allocator());
+	string data = MakeData(2 * kBlockSize + 100);
+	buffer.Append(data.data(), 10);
+	buffer.Append(data.substr(10));
+	assert(buffer.ReadableByte() == 2 * kBlockSize + 100 && buffer.BlockNumber() == 3);
+
+	buffer.Retrieve(kBlockSize + 1);
+	assert(buffer.ReadableByte() == kBlockSize + 99 && buffer.BlockNumber() == 2);
+	buffer.Retrieve(kBlockSize - 1);
+	assert(buffer.ReadableByte() == 100 && buffer.BlockNumber() == 1);
+
+	int pipe_fd[2];
+	assert(::pipe2(pipe_fd, O_NONBLOCK) == 0);
+	int saved_errno = 0;
+	assert(buffer.WriteFd(pipe_fd[1], saved_errno) == 100);
+	assert(buffer.ReadableByte() == 0 && buffer.BlockNumber() == 0);
+	char output[100];
+	assert(::read(pipe_fd[0], output, sizeof output) == 100);
+	assert(string(output, 100) == data.substr(2 * kBlockSize));
+
+	// More blocks than IOV_MAX and bytes than the pipe holds: write a prefix.
+	string big_data = MakeData(2000 * kBlockSize);
+	buffer.Append(big_data);
+	int write_byte = buffer.WriteFd(pipe_fd[1], saved_errno);
+	assert(write_byte > 0 && buffer.ReadableByte() == 2000 * kBlockSize - write_byte);
+	string received(write_byte, '\0');
+	assert(::read(pipe_fd[0], &received[0], write_byte) == write_byte);
+	assert(received == big_data.substr(0, write_byte));
+	assert(buffer.WriteFd(pipe_fd[1], saved_errno) > 0); // Drained pipe accepts more.
+	buffer.RetrieveAll();
+	assert(buffer.ReadableByte() == 0 && buffer.BlockNumber() == 0);
+	while(::read(pipe_fd[0], &received[0], received.size()) > 0) {}
+
+	// Appended blocks are queued as they are and released once written.
+	std::shared_ptr<string> owner(std::make_shared<string>(MakeData(3 * kBlockSize)));
+	buffer.Append("head", 4);
+	buffer.AppendBlock(owner, owner->data(), static_cast<int>(owner->size()));
+	buffer.Append("tail", 4);
+	assert(buffer.BlockNumber() == 3 && owner.use_count() == 2);
+	assert(buffer.ReadableByte() == 3 * kBlockSize + 8);
+	buffer.Retrieve(5);
+	assert(buffer.BlockNumber() == 2);
+	assert(buffer.WriteFd(pipe_fd[1], saved_errno) == 3 * kBlockSize + 3);
+	assert(buffer.BlockNumber() == 0 && owner.use_count() == 1);
+	received.resize(3 * kBlockSize + 3);
+	assert(::read(pipe_fd[0], &received[0], received.size()) == 3 * kBlockSize + 3);
+	assert(received == owner->substr(1) + "tail");
+
+	::close(pipe_fd[0]);
+	::close(pipe_fd[1]);
+	printf("All passed!\n");
+}
@@ -0,0 +1,151 @@
+#include <stdio.h> // printf()
+#include <sys/wait.h> // waitpid()
+#include <unistd.h> // fork(), _exit()
+
+#include <memory> // unique_ptr<>
+#include <string>
+#include <vector>
+
+#include <netlib/buffer.h>
+#include <netlib/event_loop.h>
+#include <netlib/logging.h>
+#include <netlib/socket_address.h>
+#include <netlib/tcp_client.h>
+#include <netlib/tcp_connection.h>
+#include <netlib/tcp_server.h>
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using netlib::Buffer;
+using netlib::EventLoop;
+using netlib::SocketAddress;
+using netlib::TcpClient;
+using netlib::TcpConnectionPtr;
+using netlib::TcpServer;
+using netlib::TimeStamp;
+
+const int kConnectionNumber = 16;
+const int kRequestSize = 16;
+const int kMaxResponseNumber = 20 * 1000; // Of all connections.
+const int kMaxResponseByte = 512 * 1024 * 1024;
+const int kPort = 7191;
+
+// Runs in a child process, which exits at the end.
+// Request/response over loopback: every connection sends a request, waits for the whole
+// response and sends the next one. Server and clients share one loop, so epoll_ctl
+// counts cover both ends.
+void RequestResponseBench(bool edge_triggered, int response_size)
+{
+	SetLogLevel(WARN);
+	EventLoop loop;
+	const string request(kRequestSize, 'q'), response(response_size, 'r');
+	const int response_number = (kMaxResponseByte / response_size < kMaxResponseNumber) ?
+	                            kMaxResponseByte / response_size : kMaxResponseNumber;
+	int sent_number = 0, received_number = 0;
+
+	TcpServer server(&loop, SocketAddress(kPort), "EdgeTriggeredServer");
+	server.set_connection_callback([edge_triggered](const TcpConnectionPtr &connection)
+	{
+		if(connection->Connected() == true && edge_triggered == true)
+		{
+			connection->SetEdgeTriggered(true);
+		}
+	});
+	server.set_message_callback([&response](const TcpConnectionPtr &connection,
+	                                        Buffer *buffer,
+	                                        const TimeStamp&)
+	{
+		while(buffer->ReadableByte() >= kRequestSize)
+		{
+			buffer->Retrieve(kRequestSize);
+			connection->Send(response);
+		}
+	});
+	server.Start();
+
+	vector<unique_ptr<TcpClient>> client_vector;
+	for(int index = 0; index < kConnectionNumber; ++index)
+	{
+		client_vector.push_back(unique_ptr<TcpClient>(
+		                            new TcpClient(&loop, SocketAddress("127.0.0.1", kPort), "Client")));
+		TcpClient *client = client_vector.back().get();
+		client->set_connection_callback([&, edge_triggered](const TcpConnectionPtr &connection)
+		{
+			if(connection->Connected() == true)
+			{
+				if(edge_triggered == true)
+				{
+					connection->SetEdgeTriggered(true);
+				}
+				++sent_number;
+				connection->Send(request);
+			}
+		});
+		client->set_message_callback([&](const TcpConnectionPtr &connection,
+		                                 Buffer *buffer,
+		                                 const TimeStamp&)
+		{
+			while(buffer->ReadableByte() >= response_size)
+			{
+				buffer->Retrieve(response_size);
+				if(++received_number == response_number)
+				{
+					loop.Quit();
+				}
+				else if(sent_number < response_number)
+				{
+					++sent_number;
+					connection->Send(request);
+				}
+			}
+		});
+		client->Connect();
+	}
+
+	TimeStamp start(TimeStamp::Now());
+	int64_t ctl_before = loop.poller_control_number();
+	loop.Loop();
+	double second = TimeDifferenceInSecond(TimeStamp::Now(), start);
+	int64_t ctl_number = loop.poller_control_number() - ctl_before;
+	printf("%s response %7d B: %6.0f responses/s, %7lld epoll_ctl(%.2f per response)\n",
+	       edge_triggered ? "edge " : "level",
+	       response_size,
+	       response_number / second,
+	       static_cast<long long>(ctl_number),
+	       static_cast<double>(ctl_number) / response_number);
+	fflush(stdout);
+	_exit(0); // Skip the teardown of a loop that no longer runs.
+}
+
+int main()
+{
+	const int response_size_array[] = {1024, 64 * 1024, 1024 * 1024, 8 * 1024 * 1024};
+	for(int response_size: response_size_array)
+	{
+		for(int edge_triggered = 0; edge_triggered <= 1; ++edge_triggered)
+		{
+			// A child process for each run: the loop, server and clients exit with it.
+			pid_t pid = ::fork();
+			if(pid == 0)
+			{
+				RequestResponseBench(edge_triggered == 1, response_size);
+			}
+			::waitpid(pid, nullptr, 0);
+		}
+	}
+}
+/*
+$ ./edge_triggered_bench # -O2, 1 CPU VM, tcp_wmem max 4MB.
+level response    1024 B: 122715 responses/s,      48 epoll_ctl(0.00 per response)
+edge  response    1024 B: 117610 responses/s,      80 epoll_ctl(0.00 per response)
+level response   65536 B:  41753 responses/s,      48 epoll_ctl(0.01 per response)
+edge  response   65536 B:  45984 responses/s,      80 epoll_ctl(0.01 per response)
+level response 1048576 B:   2572 responses/s,      48 epoll_ctl(0.09 per response)
+edge  response 1048576 B:   2706 responses/s,      80 epoll_ctl(0.16 per response)
+level response 8388608 B:    109 responses/s,     164 epoll_ctl(2.56 per response)
+edge  response 8388608 B:    130 responses/s,      80 epoll_ctl(1.25 per response)
+The 48 calls are connection setup; edge mode adds one EPOLL_CTL_MOD per connection in
+SetEdgeTriggered() and then none. Level mode pays 2 more per response once responses
+outgrow the socket send buffer and queue in output_buffer_.
+*/
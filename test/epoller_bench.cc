@@ -0,0 +1,172 @@
+#include <stdio.h> // printf()
+#include <sys/eventfd.h> // eventfd()
+#include <unistd.h> // close()
+
+#include <memory> // unique_ptr<>
+#include <set>
+#include <vector>
+
+#include <netlib/channel.h>
+#include <netlib/event_loop.h>
+#include <netlib/time_stamp.h>
+
+using std::set;
+using std::unique_ptr;
+using std::vector;
+using netlib::Channel;
+using netlib::EventLoop;
+using netlib::TimeStamp;
+
+// Only the registration bookkeeping of Epoller, so it can be measured beyond the fd
+// limit of this process. `Entry` stands for Channel: just an fd.
+struct Entry
+{
+	int fd;
+};
+
+// The old way: std::set<Channel*>, one lookup for the assert and one for insert/erase.
+class SetTable
+{
+public:
+	void Insert(Entry *entry)
+	{
+		if(set_.find(entry) == set_.end())
+		{
+			set_.insert(entry);
+		}
+	}
+	void Erase(Entry *entry)
+	{
+		if(set_.find(entry) != set_.end())
+		{
+			set_.erase(entry);
+		}
+	}
+	bool Has(Entry *entry) const
+	{
+		return set_.find(entry) != set_.end();
+	}
+
+private:
+	set<Entry*> set_;
+};
+
+// The new way: Channel* indexed by fd.
+class FdTable
+{
+public:
+	void Insert(Entry *entry)
+	{
+		int size = static_cast<int>(table_.size());
+		if(entry->fd >= size)
+		{
+			table_.resize(static_cast<size_t>((entry->fd < size * 2) ? size * 2 : entry->fd + 1),
+			              nullptr);
+		}
+		table_[entry->fd] = entry;
+	}
+	void Erase(Entry *entry)
+	{
+		table_[entry->fd] = nullptr;
+	}
+	bool Has(Entry *entry) const
+	{
+		return entry->fd < static_cast<int>(table_.size()) && table_[entry->fd] == entry;
+	}
+
+private:
+	vector<Entry*> table_;
+};
+
+// Register `number` entries, then churn each one: remove and re-register it as a new
+// "connection" on the reused fd, the way accept() recycles the lowest free fd.
+template<typename Table>
+double ChurnBench(int number)
+{
+	vector<Entry> entry_vector(number * 2);
+	for(int index = 0; index < number * 2; ++index)
+	{
+		entry_vector[index].fd = index % number;
+	}
+	Table table;
+	int has_number = 0;
+	TimeStamp start = TimeStamp::Now();
+	for(int index = 0; index < number; ++index)
+	{
+		table.Insert(&entry_vector[index]);
+	}
+	for(int index = 0; index < number; ++index)
+	{
+		has_number += table.Has(&entry_vector[index]) ? 1 : 0;
+		table.Erase(&entry_vector[index]);
+		table.Insert(&entry_vector[number + index]);
+	}
+	for(int index = number; index < number * 2; ++index)
+	{
+		table.Erase(&entry_vector[index]);
+	}
+	double second = TimeDifferenceInSecond(TimeStamp::Now(), start);
+	if(has_number != number)
+	{
+		printf("ERROR: has_number = %d\n", has_number);
+	}
+	// 5 operations per entry: insert, has, erase, insert again and the final erase.
+	return second * 1e9 / (number * 5.0);
+}
+
+// Real Epoller: `live_number` registered eventfds, then `churn_number` times
+// add(READ_EVENT) -> NONE_EVENT -> RemoveChannel of one more channel.
+void EpollerBench(int live_number, int churn_number)
+{
+	EventLoop loop;
+	vector<int> fd_vector;
+	vector<unique_ptr<Channel>> channel_vector;
+	for(int index = 0; index < live_number; ++index)
+	{
+		int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		fd_vector.push_back(fd);
+		channel_vector.push_back(unique_ptr<Channel>(new Channel(&loop, fd)));
+		channel_vector.back()->set_requested_event(Channel::READ_EVENT);
+	}
+	int churn_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	TimeStamp start = TimeStamp::Now();
+	for(int index = 0; index < churn_number; ++index)
+	{
+		Channel channel(&loop, churn_fd);
+		channel.set_requested_event(Channel::READ_EVENT);
+		channel.set_requested_event(Channel::NONE_EVENT);
+		channel.RemoveChannel();
+	}
+	double second = TimeDifferenceInSecond(TimeStamp::Now(), start);
+	printf("Epoller: %d live channels, %d churns: %.0f ns per churn(2 epoll_ctl)\n",
+	       live_number, churn_number, second * 1e9 / churn_number);
+	for(int index = 0; index < live_number; ++index)
+	{
+		channel_vector[index]->set_requested_event(Channel::NONE_EVENT);
+		channel_vector[index]->RemoveChannel();
+		::close(fd_vector[index]);
+	}
+	::close(churn_fd);
+}
+
+int main()
+{
+	const int number_array[] = {10 * 1000, 100 * 1000, 1000 * 1000};
+	for(int number: number_array)
+	{
+		double set_ns = ChurnBench<SetTable>(number);
+		double table_ns = ChurnBench<FdTable>(number);
+		printf("%7d registrations: std::set %.1f ns/op, fd table %.1f ns/op\n",
+		       number, set_ns, table_ns);
+	}
+	EpollerBench(10 * 1000, 1000 * 1000);
+}
+/*
+$ ./epoller_bench # -O2, 1 CPU VM, fd limit 20000 so the real Epoller keeps 10k live.
+  10000 registrations: std::set 58.0 ns/op, fd table 1.6 ns/op
+ 100000 registrations: std::set 167.4 ns/op, fd table 3.9 ns/op
+1000000 registrations: std::set 256.8 ns/op, fd table 3.9 ns/op
+Epoller: 10000 live channels, 1000000 churns: 1001 ns per churn(2 epoll_ctl)
+With std::set<Channel*> in Epoller:
+Epoller: 10000 live channels, 1000000 churns: 1512 ns per churn(2 epoll_ctl)
+*/
@@ -0,0 +1,95 @@
+#include <assert.h>
+#include <stdio.h> // printf()
+#include <unistd.h> // pipe(), read(), write(), close(), usleep()
+
+#include <atomic>
+
+#include <netlib/channel.h>
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_metrics.h>
+#include <netlib/event_loop_option.h>
+#include <netlib/thread.h>
+
+using netlib::Channel;
+using netlib::EventLoop;
+using netlib::EventLoopMetrics;
+using netlib::EventLoopOption;
+using netlib::Thread;
+
+void TestMetrics(const EventLoopOption &option)
+{
+	EventLoop loop(option);
+	EventLoopMetrics before = loop.Metrics();
+	assert(before.iteration_number == 0);
+
+	int pipe_fd[2];
+	assert(::pipe(pipe_fd) == 0);
+	Channel channel(&loop, pipe_fd[0]);
+	channel.set_event_callback(Channel::READ_CALLBACK, [&](const netlib::TimeStamp&)
+	{
+		char byte;
+		assert(::read(pipe_fd[0], &byte, 1) == 1);
+	});
+	channel.set_requested_event(Channel::READ_EVENT);
+
+	// Snapshots from another thread while the loop runs: counters never go back.
+	std::atomic<bool> done(false);
+	Thread reader([&]()
+	{
+		EventLoopMetrics last = loop.Metrics();
+		while(done.load() == false)
+		{
+			EventLoopMetrics now = loop.Metrics();
+			assert(now.iteration_number >= last.iteration_number);
+			assert(now.task_number >= last.task_number);
+			assert(now.io_microsecond >= last.io_microsecond);
+			last = now;
+			::usleep(100);
+		}
+	});
+	reader.Start();
+
+	int task_number = 0;
+	assert(::write(pipe_fd[1], "ab", 2) == 2);
+	loop.RunAfter([&]()
+	{
+		// Queued from the loop thread: all of them are run in one pass.
+		for(int index = 0; index < 10; ++index)
+		{
+			loop.QueueInLoop([&task_number]() { ++task_number; });
+		}
+		loop.QueueInLoop([]() { ::usleep(20 * 1000); }); // The slowest callback.
+	}, 0.02);
+	loop.RunAfter([&]() { loop.Quit(); }, 0.1);
+	loop.Loop();
+	done = true;
+	reader.Join();
+
+	EventLoopMetrics after = loop.Metrics();
+	assert(task_number == 10);
+	assert(after.iteration_number > 0);
+	assert(after.event_number >= 2); // The pipe, twice: level-triggered, one byte a read.
+	assert(after.max_event_number >= 1);
+	assert(after.task_number >= 11);
+	assert(after.max_task_number >= 11);
+	assert(after.task_microsecond >= 20 * 1000);
+	assert(after.slowest_callback_microsecond >= 20 * 1000);
+	assert(after.busy_poll_spin_microsecond == 0); // Busy polling is off.
+	double saturation = EventLoopMetrics::Saturation(before, after);
+	assert(saturation > 0.1 && saturation <= 1.0);
+
+	channel.set_requested_event(Channel::NONE_EVENT);
+	channel.RemoveChannel();
+	::close(pipe_fd[0]);
+	::close(pipe_fd[1]);
+}
+
+int main()
+{
+	EventLoopOption option;
+	option.timer_mode = EventLoopOption::TIMER_FD;
+	TestMetrics(option);
+	option.timer_mode = EventLoopOption::EPOLL_TIMEOUT;
+	TestMetrics(option);
+	printf("event_loop_metrics_test passed\n");
+}
@@ -1,3 +1,4 @@
+#include <assert.h> // assert()
 #include <unistd.h> // getpid(), sleep()
 #include <stdio.h> // printf()
 
@@ -0,0 +1,104 @@
+// Servers close connections nothing is read from for kIdleSecond, and only those.
+
+#include <assert.h>
+#include <stdio.h> // printf()
+
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_option.h>
+#include <netlib/idle_connection_ring.h>
+#include <netlib/logging.h>
+#include <netlib/socket_address.h>
+#include <netlib/tcp_client.h>
+#include <netlib/tcp_connection.h>
+#include <netlib/tcp_server.h>
+
+using netlib::EventLoop;
+using netlib::EventLoopOption;
+using netlib::SocketAddress;
+using netlib::TcpClient;
+using netlib::TcpConnectionPtr;
+using netlib::TcpServer;
+using netlib::TimeStamp;
+using netlib::TimerId;
+
+const int kPort = 7500;
+const double kIdleSecond = 0.1;
+const double kTickSecond = 0.02;
+const double kChatSecond = 0.4; // The chatty client sends until then.
+
+struct Client
+{
+	Client(EventLoop *loop, int port, const char *name):
+		client(loop, SocketAddress("127.0.0.1", port), name),
+		down_second(0)
+	{}
+
+	TcpClient client;
+	TcpConnectionPtr connection;
+	double down_second; // From start to the close of the connection.
+};
+
+int main()
+{
+	SetLogLevel(WARN);
+	EventLoopOption option;
+	option.idle_timeout_tick_microsecond = static_cast<int>(kTickSecond * 1000 * 1000);
+	EventLoop loop(option);
+	TimeStamp start = TimeStamp::Now();
+
+	TcpServer server(&loop, SocketAddress(kPort), "IdleServer");
+	server.set_idle_timeout(kIdleSecond);
+	server.Start();
+	TcpServer shutdown_server(&loop, SocketAddress(kPort + 1), "IdleShutdownServer");
+	shutdown_server.set_idle_timeout(kIdleSecond, true);
+	shutdown_server.Start();
+
+	Client silent(&loop, kPort, "Silent");
+	Client chatty(&loop, kPort, "Chatty");
+	Client shutdown(&loop, kPort + 1, "Shutdown");
+	int down_number = 0;
+	for(Client *client : {&silent, &chatty, &shutdown})
+	{
+		client->client.set_connection_callback([&, client](const TcpConnectionPtr &connection)
+		{
+			if(connection->Connected() == true)
+			{
+				client->connection = connection;
+				return;
+			}
+			client->down_second = TimeDifferenceInSecond(TimeStamp::Now(), start);
+			client->connection.reset();
+			if(++down_number == 3)
+			{
+				loop.Quit();
+			}
+		});
+		client->client.Connect();
+	}
+
+	// Every 30ms, well within the timeout, until kChatSecond.
+	int chat_number = 0;
+	TimerId chat = loop.RunEvery([&]()
+	{
+		if(TimeDifferenceInSecond(TimeStamp::Now(), start) >= kChatSecond)
+		{
+			loop.CancelTimer(chat);
+		}
+		else if(chatty.connection)
+		{
+			chatty.connection->Send("ping");
+			++chat_number;
+		}
+	}, 0.03);
+	loop.Loop();
+
+	printf("silent closed after %.3fs, chatty after %.3fs(%d pings), shutdown after %.3fs\n",
+	       silent.down_second, chatty.down_second, chat_number, shutdown.down_second);
+	assert(silent.down_second >= kIdleSecond && silent.down_second < kChatSecond);
+	assert(shutdown.down_second >= kIdleSecond && shutdown.down_second < kChatSecond);
+	assert(chat_number > 0);
+	assert(chatty.down_second >= kChatSecond + kIdleSecond - 0.03);
+	assert(chatty.down_second < kChatSecond + 0.5);
+	assert(loop.idle_connection_ring()->size() == 0);
+	printf("idle_connection_test passed\n");
+}
@@ -0,0 +1,88 @@
+// A connection that goes quiet after a burst gets its read size back to the minimum.
+
+#include <assert.h>
+#include <stdio.h> // printf()
+
+#include <string>
+
+#include <netlib/event_loop.h>
+#include <netlib/logging.h>
+#include <netlib/socket_address.h>
+#include <netlib/tcp_client.h>
+#include <netlib/tcp_connection.h>
+#include <netlib/tcp_server.h>
+
+using std::string;
+using netlib::Buffer;
+using netlib::EventLoop;
+using netlib::SocketAddress;
+using netlib::TcpClient;
+using netlib::TcpConnectionPtr;
+using netlib::TcpServer;
+using netlib::TimeStamp;
+
+const int kPort = 7600;
+const int kBurstByte = 4 * 1024 * 1024;
+const double kQuietSecond = 3.0; // More than TcpConnection's idle shrink delay.
+
+int main()
+{
+	SetLogLevel(WARN);
+	EventLoop loop;
+	TcpServer server(&loop, SocketAddress(kPort), "IdleShrinkServer");
+	TcpConnectionPtr server_connection;
+	int down_number = 0; // Quit when both ends are closed.
+	int received_byte = 0, max_read_size = 0;
+	server.set_connection_callback([&](const TcpConnectionPtr &connection)
+	{
+		if(connection->Connected() == true)
+		{
+			server_connection = connection;
+			return;
+		}
+		server_connection.reset();
+		if(++down_number == 2)
+		{
+			loop.Quit();
+		}
+	});
+	server.set_message_callback([&](const TcpConnectionPtr &connection,
+	                                Buffer *buffer,
+	                                const TimeStamp&)
+	{
+		received_byte += buffer->ReadableByte();
+		buffer->RetrieveAll();
+		max_read_size = (connection->read_size() > max_read_size) ?
+		                connection->read_size() : max_read_size;
+	});
+	server.Start();
+
+	TcpClient client(&loop, SocketAddress("127.0.0.1", kPort), "Burst");
+	client.set_connection_callback([&](const TcpConnectionPtr &connection)
+	{
+		if(connection->Connected() == true)
+		{
+			connection->Send(string(kBurstByte, 'b'));
+		}
+		else if(++down_number == 2)
+		{
+			loop.Quit();
+		}
+	});
+	client.Connect();
+
+	int burst_read_size = 0, quiet_read_size = 0;
+	loop.RunAfter([&]() { burst_read_size = server_connection->read_size(); }, 0.5);
+	loop.RunAfter([&]()
+	{
+		quiet_read_size = server_connection->read_size();
+		server_connection->ForceClose();
+	}, kQuietSecond);
+	loop.Loop();
+
+	printf("received %d bytes, read size %d at most, %d after the burst, %d when quiet\n",
+	       received_byte, max_read_size, burst_read_size, quiet_read_size);
+	assert(received_byte == kBurstByte && max_read_size > 1024 && burst_read_size > 1024);
+	assert(quiet_read_size == 1024);
+	printf("idle_shrink_test passed\n");
+}
@@ -0,0 +1,126 @@
+// Echo through the completion-based requests of an IO_URING loop: recv, writev and
+// accept, a burst that takes many partial writes, the idle shrink that cancels the
+// pending recv, and Shutdown() that waits for the pending writev.
+
+#include <assert.h>
+#include <stdio.h> // printf()
+
+#include <string>
+
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_option.h>
+#include <netlib/logging.h>
+#include <netlib/socket_address.h>
+#include <netlib/tcp_client.h>
+#include <netlib/tcp_connection.h>
+#include <netlib/tcp_server.h>
+
+using std::string;
+using netlib::Buffer;
+using netlib::EventLoop;
+using netlib::EventLoopOption;
+using netlib::SocketAddress;
+using netlib::TcpClient;
+using netlib::TcpConnectionPtr;
+using netlib::TcpServer;
+using netlib::TimeStamp;
+
+const int kPort = 7700;
+const int kMessageNumber = 64;
+const double kQuietSecond = 2.5; // More than TcpConnection's idle shrink delay.
+
+int main()
+{
+	SetLogLevel(WARN);
+	EventLoopOption option;
+	option.poller_type = EventLoopOption::IO_URING;
+	EventLoop loop(option);
+	if(loop.io_uring_poller() == nullptr)
+	{
+		printf("io_uring is unavailable, io_uring_echo_test skipped\n");
+		return 0;
+	}
+
+	TcpServer server(&loop, SocketAddress(kPort), "EchoServer");
+	TcpConnectionPtr server_connection;
+	int down_number = 0; // Quit when both ends are closed.
+	server.set_connection_callback([&](const TcpConnectionPtr &connection)
+	{
+		if(connection->Connected() == true)
+		{
+			server_connection = connection;
+			return;
+		}
+		server_connection.reset();
+		if(++down_number == 2)
+		{
+			loop.Quit();
+		}
+	});
+	server.set_message_callback([&](const TcpConnectionPtr &connection,
+	                                Buffer *buffer,
+	                                const TimeStamp&)
+	{
+		connection->Send(buffer);
+	});
+	server.Start();
+
+	// 1B to 304KB messages, about 1MB in all: the echo needs many partial writes.
+	string sent;
+	for(int index = 0; index < kMessageNumber; ++index)
+	{
+		sent.append((index % 19 + 1) << (index % 15), static_cast<char>('a' + index % 26));
+	}
+	string received;
+	int server_burst_read_size = 0, server_quiet_read_size = 0;
+	bool ping_sent = false, ping_received = false;
+	TcpClient client(&loop, SocketAddress("127.0.0.1", kPort), "EchoClient");
+	client.set_connection_callback([&](const TcpConnectionPtr &connection)
+	{
+		if(connection->Connected() == true)
+		{
+			for(int index = 0, offset = 0; index < kMessageNumber; ++index)
+			{
+				int length = (index % 19 + 1) << (index % 15);
+				connection->Send(sent.data() + offset, length);
+				offset += length;
+			}
+		}
+		else if(++down_number == 2)
+		{
+			loop.Quit();
+		}
+	});
+	client.set_message_callback([&](const TcpConnectionPtr &connection,
+	                                Buffer *buffer,
+	                                const TimeStamp&)
+	{
+		received.append(buffer->ReadableBegin(), buffer->ReadableByte());
+		buffer->RetrieveAll();
+		if(ping_sent == true && received == sent + "ping")
+		{
+			ping_received = true;
+			connection->Shutdown();
+		}
+		else if(ping_sent == false && received.size() == sent.size())
+		{
+			server_burst_read_size = server_connection->read_size();
+			TcpConnectionPtr client_connection(connection);
+			loop.RunAfter([&, client_connection]()
+			{
+				// The pending recv was canceled to shrink, then submitted again.
+				server_quiet_read_size = server_connection->read_size();
+				ping_sent = true;
+				client_connection->Send(string("ping"));
+			}, kQuietSecond);
+		}
+	});
+	client.Connect();
+	loop.Loop();
+
+	printf("echoed %zu bytes, server read size %d after the burst, %d when quiet\n",
+	       received.size(), server_burst_read_size, server_quiet_read_size);
+	assert(received == sent + "ping" && ping_received == true);
+	assert(server_burst_read_size > 1024 && server_quiet_read_size == 1024);
+	printf("io_uring_echo_test passed\n");
+}
@@ -0,0 +1,93 @@
+#include <assert.h>
+#include <stdio.h> // printf()
+#include <unistd.h> // pipe(), read(), write(), close()
+
+#include <string>
+#include <vector>
+
+#include <netlib/channel.h>
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_option.h>
+#include <netlib/loop_watchdog.h>
+#include <netlib/time_stamp.h>
+
+using std::string;
+using std::vector;
+using netlib::Channel;
+using netlib::EventLoop;
+using netlib::EventLoopOption;
+using netlib::LoopWatchdog;
+using netlib::TimeStamp;
+
+struct Stall
+{
+	int fd;
+	double second;
+	string backtrace;
+};
+
+// Busy, not sleeping: the backtrace signal would cut a sleep short.
+__attribute__((noinline)) void SpinFor(double second)
+{
+	TimeStamp start = TimeStamp::Now();
+	while(TimeDifferenceInSecond(TimeStamp::Now(), start) < second)
+	{}
+}
+
+int main()
+{
+	EventLoopOption option;
+	option.timer_mode = EventLoopOption::EPOLL_TIMEOUT; // Timers are kTimerDispatch.
+	EventLoop loop(option);
+	vector<Stall> stall_vector; // Written by the watchdog thread, read after Stop().
+	LoopWatchdog watchdog(0.05);
+	watchdog.set_stall_callback([&](EventLoop *stuck_loop,
+	                                int fd,
+	                                double second,
+	                                const string &backtrace)
+	{
+		assert(stuck_loop == &loop);
+		stall_vector.push_back(Stall{fd, second, backtrace});
+	});
+	watchdog.Register(&loop);
+	watchdog.Start();
+
+	int pipe_fd[2];
+	assert(::pipe(pipe_fd) == 0);
+	Channel channel(&loop, pipe_fd[0]);
+	channel.set_event_callback(Channel::READ_CALLBACK, [&](const TimeStamp&)
+	{
+		char byte;
+		assert(::read(pipe_fd[0], &byte, 1) == 1);
+		SpinFor(0.2);
+	});
+	channel.set_requested_event(Channel::READ_EVENT);
+
+	loop.RunAfter([]() { SpinFor(0.2); }, 0.01);
+	loop.RunAfter([&]() { loop.QueueInLoop([]() { SpinFor(0.2); }); }, 0.3);
+	loop.RunAfter([&]() { assert(::write(pipe_fd[1], "a", 1) == 1); }, 0.6);
+	loop.RunAfter([]() { SpinFor(0.02); }, 0.9); // Below the threshold.
+	loop.RunAfter([&]() { loop.Quit(); }, 1.0);
+	loop.Loop();
+	watchdog.Unregister(&loop);
+	watchdog.Stop();
+
+	// Each stall is reported once, however long it lasts.
+	assert(stall_vector.size() == 3);
+	assert(watchdog.stall_number() == 3);
+	assert(stall_vector[0].fd == EventLoop::kTimerDispatch);
+	assert(stall_vector[1].fd == EventLoop::kTaskDispatch);
+	assert(stall_vector[2].fd == pipe_fd[0]);
+	for(const Stall &stall: stall_vector)
+	{
+		assert(stall.second >= 0.05);
+		assert(stall.backtrace.find("SpinFor") != string::npos);
+	}
+	printf("%s", stall_vector[2].backtrace.c_str());
+
+	channel.set_requested_event(Channel::NONE_EVENT);
+	channel.RemoveChannel();
+	::close(pipe_fd[0]);
+	::close(pipe_fd[1]);
+	printf("loop_watchdog_test passed\n");
+}
@@ -0,0 +1,121 @@
+#include <stdio.h> // printf()
+
+#include <memory> // unique_ptr<>
+#include <vector>
+
+#include <netlib/function.h>
+#include <netlib/mpsc_task_queue.h>
+#include <netlib/mutex.h>
+#include <netlib/thread.h>
+#include <netlib/time_stamp.h>
+
+using std::unique_ptr;
+using std::vector;
+using netlib::MpscTaskQueue;
+using netlib::MutexLock;
+using netlib::MutexLockGuard;
+using netlib::TaskCallback;
+using netlib::Thread;
+using netlib::TimeStamp;
+
+const int kTotalTask = 4 * 1000 * 1000;
+
+// What EventLoop did before: push_back under a mutex, swap the vector out.
+class MutexTaskQueue
+{
+public:
+	void Push(TaskCallback &&task)
+	{
+		MutexLockGuard lock(mutex_);
+		task_vector_.push_back(std::move(task));
+	}
+	int RunAll()
+	{
+		vector<TaskCallback> local_task_vector;
+		{
+			MutexLockGuard lock(mutex_);
+			local_task_vector.swap(task_vector_);
+		}
+		for(vector<TaskCallback>::iterator it = local_task_vector.begin();
+		        it != local_task_vector.end();
+		        ++it)
+		{
+			(*it)();
+		}
+		return static_cast<int>(local_task_vector.size());
+	}
+
+private:
+	MutexLock mutex_;
+	vector<TaskCallback> task_vector_;
+};
+
+// `producer_number` threads push kTotalTask tasks in all while this thread, the
+// consumer, runs them. Return the seconds until the last task has run.
+template<typename Queue>
+double Bench(int producer_number)
+{
+	Queue queue;
+	int64_t sum = 0;
+	int task_per_producer = kTotalTask / producer_number;
+	vector<unique_ptr<Thread>> producer_vector;
+	for(int index = 0; index < producer_number; ++index)
+	{
+		producer_vector.push_back(unique_ptr<Thread>(new Thread([&queue, &sum, task_per_producer]
+		{
+			for(int task = 0; task < task_per_producer; ++task)
+			{
+				queue.Push([&sum, task]
+				{
+					sum += task;
+				});
+			}
+		})));
+	}
+
+	TimeStamp start(TimeStamp::Now());
+	for(int index = 0; index < producer_number; ++index)
+	{
+		producer_vector[index]->Start();
+	}
+	for(int run_number = 0; run_number < task_per_producer * producer_number;)
+	{
+		run_number += queue.RunAll();
+	}
+	double time = TimeDifferenceInSecond(TimeStamp::Now(), start);
+	for(int index = 0; index < producer_number; ++index)
+	{
+		producer_vector[index]->Join();
+	}
+	int64_t expected = static_cast<int64_t>(task_per_producer - 1) * task_per_producer / 2;
+	if(sum != expected * producer_number)
+	{
+		printf("Bench(): sum error!\n");
+	}
+	return time;
+}
+
+int main()
+{
+	for(int producer_number = 1; producer_number <= 32; producer_number *= 2)
+	{
+		double mutex_time = Bench<MutexTaskQueue>(producer_number);
+		double mpsc_time = Bench<MpscTaskQueue>(producer_number);
+		printf("%2d producers: mutex+vector %7.1f ns/task, mpsc %7.1f ns/task, speedup %.2fx\n",
+		       producer_number,
+		       mutex_time * 1e9 / kTotalTask,
+		       mpsc_time * 1e9 / kTotalTask,
+		       mutex_time / mpsc_time);
+	}
+}
+/*
+$ ./mpsc_task_queue_bench # -O2, on a 1 CPU VM: producers never really contend.
+ 1 producers: mutex+vector   139.7 ns/task, mpsc    78.9 ns/task, speedup 1.77x
+ 2 producers: mutex+vector   115.5 ns/task, mpsc   112.9 ns/task, speedup 1.02x
+ 4 producers: mutex+vector   120.2 ns/task, mpsc   134.1 ns/task, speedup 0.90x
+ 8 producers: mutex+vector   166.2 ns/task, mpsc   151.0 ns/task, speedup 1.10x
+16 producers: mutex+vector   179.7 ns/task, mpsc   147.8 ns/task, speedup 1.22x
+32 producers: mutex+vector   168.4 ns/task, mpsc   157.3 ns/task, speedup 1.07x
+With a new/delete per node, on the same VM, mpsc took 146, 156, 141, 135, 134 and
+147 ns/task: recycling the nodes is what makes the queue win with few producers.
+*/
@@ -0,0 +1,157 @@
+#include <stdio.h> // printf()
+#include <sys/wait.h> // waitpid()
+#include <unistd.h> // fork(), _exit()
+
+#include <memory> // unique_ptr<>
+#include <string>
+#include <vector>
+
+#include <netlib/buffer.h>
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_option.h>
+#include <netlib/logging.h>
+#include <netlib/socket_address.h>
+#include <netlib/tcp_client.h>
+#include <netlib/tcp_connection.h>
+#include <netlib/tcp_server.h>
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using netlib::Buffer;
+using netlib::EventLoop;
+using netlib::EventLoopOption;
+using netlib::SocketAddress;
+using netlib::TcpClient;
+using netlib::TcpConnectionPtr;
+using netlib::TcpServer;
+using netlib::TimeStamp;
+
+const int kBasePort = 7200;
+
+// Runs in a child process, which exits at the end.
+// Ping-pong over loopback: each of `connection_number` connections sends a message,
+// the server echoes it, and the client sends it again once it is back. Server and
+// clients share one loop, with the poller `option` asks for.
+void PingPongBench(const EventLoopOption &option,
+                   int port,
+                   int connection_number,
+                   int message_size,
+                   int message_number)
+{
+	SetLogLevel(WARN);
+	EventLoop loop(option);
+	const string message(message_size, 'm');
+	int sent_number = 0, received_number = 0;
+
+	TcpServer server(&loop, SocketAddress(port), "PingPongServer");
+	server.set_message_callback([](const TcpConnectionPtr &connection,
+	                               Buffer *buffer,
+	                               const TimeStamp&)
+	{
+		connection->Send(buffer);
+	});
+	server.Start();
+
+	vector<unique_ptr<TcpClient>> client_vector;
+	for(int index = 0; index < connection_number; ++index)
+	{
+		client_vector.push_back(unique_ptr<TcpClient>(
+		                            new TcpClient(&loop, SocketAddress("127.0.0.1", port), "Client")));
+		TcpClient *client = client_vector.back().get();
+		client->set_connection_callback([&](const TcpConnectionPtr &connection)
+		{
+			if(connection->Connected() == true)
+			{
+				++sent_number;
+				connection->Send(message);
+			}
+		});
+		client->set_message_callback([&](const TcpConnectionPtr &connection,
+		                                 Buffer *buffer,
+		                                 const TimeStamp&)
+		{
+			while(buffer->ReadableByte() >= message_size)
+			{
+				buffer->Retrieve(message_size);
+				if(++received_number == message_number)
+				{
+					loop.Quit();
+				}
+				else if(sent_number < message_number)
+				{
+					++sent_number;
+					connection->Send(message);
+				}
+			}
+		});
+		client->Connect();
+	}
+
+	TimeStamp start(TimeStamp::Now());
+	loop.Loop();
+	double second = TimeDifferenceInSecond(TimeStamp::Now(), start);
+	printf("%-8s %4d connections %6d B: %8.0f messages/s, %6.1f MB/s, %.2f poller controls per message\n",
+	       (option.poller_type == EventLoopOption::IO_URING) ? "io_uring" : "epoll",
+	       connection_number,
+	       message_size,
+	       message_number / second,
+	       static_cast<double>(message_number) * message_size / second / 1024 / 1024,
+	       static_cast<double>(loop.poller_control_number()) / message_number);
+	fflush(stdout);
+	_exit(0); // Skip the teardown of a loop that no longer runs.
+}
+
+int main()
+{
+	struct Case
+	{
+		int connection_number;
+		int message_size;
+		int message_number;
+	};
+	const Case case_array[] =
+	{
+		{1, 64, 100 * 1000}, // Ping-pong latency.
+		{100, 64, 200 * 1000},
+		{1000, 64, 200 * 1000},
+		{10, 64 * 1024, 50 * 1000} // Echo throughput.
+	};
+	int port = kBasePort;
+	for(const Case &bench_case: case_array)
+	{
+		for(int type = EventLoopOption::EPOLL; type <= EventLoopOption::IO_URING; ++type)
+		{
+			// A new port each run: the exited child's io_uring is torn down in the
+			// background, and its listening socket(SO_REUSEPORT) may linger a while.
+			++port;
+			EventLoopOption option;
+			option.poller_type = static_cast<EventLoopOption::PollerType>(type);
+			pid_t pid = ::fork();
+			if(pid == 0)
+			{
+				PingPongBench(option,
+				              port,
+				              bench_case.connection_number,
+				              bench_case.message_size,
+				              bench_case.message_number);
+			}
+			::waitpid(pid, nullptr, 0);
+		}
+	}
+}
+/*
+$ ./poller_bench # -O2, 1 CPU VM, Linux 6.18.
+epoll       1 connections     64 B:    93985 messages/s,    5.7 MB/s, 0.00 poller controls per message
+io_uring    1 connections     64 B:    85244 messages/s,    5.2 MB/s, 2.00 poller controls per message
+epoll     100 connections     64 B:    89587 messages/s,    5.5 MB/s, 0.00 poller controls per message
+io_uring  100 connections     64 B:    89374 messages/s,    5.5 MB/s, 2.00 poller controls per message
+epoll    1000 connections     64 B:    74009 messages/s,    4.5 MB/s, 0.02 poller controls per message
+io_uring 1000 connections     64 B:    75229 messages/s,    4.6 MB/s, 2.02 poller controls per message
+epoll      10 connections  65536 B:    26807 messages/s, 1675.4 MB/s, 0.00 poller controls per message
+io_uring   10 connections  65536 B:    26935 messages/s, 1683.5 MB/s, 2.00 poller controls per message
+Both make one system call per loop iteration to wait(epoll_wait() or io_uring_enter()).
+io_uring re-arms a one-shot poll per completion, 2 per message here(server and client
+side), but they ride in the io_uring_enter() that waits, so they cost no system call.
+The IO itself is still read()/writev() on both paths.
+*/
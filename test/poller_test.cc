@@ -0,0 +1,162 @@
+#include <assert.h>
+#include <stdio.h> // printf()
+#include <unistd.h> // pipe(), read(), write(), close(), usleep()
+
+#include <atomic>
+
+#include <netlib/channel.h>
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_option.h>
+#include <netlib/event_loop_thread.h>
+#include <netlib/thread.h>
+
+using netlib::Channel;
+using netlib::EventLoop;
+using netlib::EventLoopOption;
+using netlib::EventLoopThread;
+using netlib::Thread;
+
+// A loop can't run again once quit: the steps of a test run from timers 50ms apart.
+void TestChannel(const EventLoopOption &option)
+{
+	EventLoop loop(option);
+	int pipe_fd[2];
+	assert(::pipe(pipe_fd) == 0);
+	Channel channel(&loop, pipe_fd[0]);
+	Channel other(&loop, pipe_fd[0]);
+	int read_number = 0, other_number = 0;
+	channel.set_event_callback(Channel::READ_CALLBACK, [&](const netlib::TimeStamp&)
+	{
+		char byte;
+		assert(::read(pipe_fd[0], &byte, 1) == 1);
+		++read_number;
+	});
+	other.set_event_callback(Channel::READ_CALLBACK, [&](const netlib::TimeStamp&)
+	{
+		char byte;
+		assert(::read(pipe_fd[0], &byte, 1) == 1);
+		++other_number;
+	});
+
+	// Level-triggered: 3 bytes, one read each, all delivered.
+	channel.set_requested_event(Channel::READ_EVENT);
+	assert(loop.HasChannel(&channel) == true);
+	assert(::write(pipe_fd[1], "abc", 3) == 3);
+	loop.RunAfter([&]()
+	{
+		assert(read_number == 3);
+		// Disabled: the byte stays in the pipe.
+		channel.set_requested_event(Channel::NONE_EVENT);
+		assert(::write(pipe_fd[1], "d", 1) == 1);
+	}, 0.05);
+	loop.RunAfter([&]()
+	{
+		assert(read_number == 3);
+		// Enabled again: the pending byte shows up.
+		channel.set_requested_event(Channel::READ_EVENT);
+	}, 0.1);
+	loop.RunAfter([&]()
+	{
+		assert(read_number == 4);
+		// Removed: nothing is delivered any more, and the fd can be registered again.
+		channel.set_requested_event(Channel::NONE_EVENT);
+		channel.RemoveChannel();
+		assert(loop.HasChannel(&channel) == false);
+		assert(::write(pipe_fd[1], "e", 1) == 1);
+		other.set_requested_event(Channel::READ_EVENT);
+	}, 0.15);
+	loop.RunAfter([&]()
+	{
+		assert(read_number == 4);
+		assert(other_number == 1);
+		other.set_requested_event(Channel::NONE_EVENT);
+		other.RemoveChannel();
+		loop.Quit();
+	}, 0.2);
+	loop.Loop();
+	::close(pipe_fd[0]);
+	::close(pipe_fd[1]);
+}
+
+// io_uring only(epoll_ctl() rejects a closed fd at once): a poll that fails reports
+// EPOLLERR once and is not re-armed in every later Poll().
+void TestFailedPoll(const EventLoopOption &option)
+{
+	EventLoop loop(option);
+	int pipe_fd[2];
+	assert(::pipe(pipe_fd) == 0);
+	::close(pipe_fd[1]);
+	Channel channel(&loop, pipe_fd[0]);
+	int error_number = 0;
+	channel.set_event_callback(Channel::ERROR_CALLBACK, [&](const netlib::TimeStamp&)
+	{
+		++error_number;
+	});
+	channel.set_requested_event(Channel::READ_EVENT);
+	::close(pipe_fd[0]); // Before the poll request is submitted.
+	int64_t control_number = 0;
+	loop.RunAfter([&]() { control_number = loop.poller_control_number(); }, 0.02);
+	loop.RunAfter([&]()
+	{
+		assert(error_number == 1);
+		assert(loop.poller_control_number() == control_number);
+		channel.set_requested_event(Channel::NONE_EVENT);
+		channel.RemoveChannel();
+		loop.Quit();
+	}, 0.07);
+	loop.Loop();
+}
+
+void TestWakeup(const EventLoopOption &option)
+{
+	EventLoopThread loop_thread(option);
+	EventLoop *loop = loop_thread.StartLoop();
+	std::atomic<int> run_number(0);
+	Thread thread([&]()
+	{
+		for(int index = 0; index < 1000; ++index)
+		{
+			loop->QueueInLoop([&run_number]() { ++run_number; });
+		}
+	});
+	thread.Start();
+	thread.Join();
+	while(run_number.load() != 1000)
+	{
+		::usleep(1000);
+	}
+}
+
+void TestTimer(const EventLoopOption &option)
+{
+	EventLoop loop(option);
+	int fire_number = 0;
+	loop.RunEvery([&]()
+	{
+		if(++fire_number == 3)
+		{
+			loop.Quit();
+		}
+	}, 0.01);
+	loop.Loop();
+	assert(fire_number == 3);
+}
+
+int main()
+{
+	EventLoopOption option;
+	for(int type = EventLoopOption::EPOLL; type <= EventLoopOption::IO_URING; ++type)
+	{
+		option.poller_type = static_cast<EventLoopOption::PollerType>(type);
+		option.timer_mode = EventLoopOption::TIMER_FD;
+		TestChannel(option);
+		TestWakeup(option);
+		TestTimer(option);
+		option.timer_mode = EventLoopOption::EPOLL_TIMEOUT;
+		TestChannel(option);
+		TestTimer(option);
+	}
+	option.poller_type = EventLoopOption::IO_URING;
+	TestFailedPoll(option);
+	printf("poller_test passed\n");
+}
@@ -0,0 +1,129 @@
+// Worker threads hammer TcpConnection::Send(const void*, int) with stack buffers that
+// are overwritten right after each call; the client checks every byte arrives intact
+// and in per-thread order.
+
+#include <stdio.h> // printf(), snprintf()
+#include <string.h> // memset()
+
+#include <string>
+#include <vector>
+
+#include <netlib/buffer.h>
+#include <netlib/event_loop.h>
+#include <netlib/logging.h>
+#include <netlib/socket_address.h>
+#include <netlib/tcp_client.h>
+#include <netlib/tcp_connection.h>
+#include <netlib/tcp_server.h>
+#include <netlib/thread.h>
+
+using std::bind;
+using std::string;
+using std::vector;
+using netlib::Buffer;
+using netlib::EventLoop;
+using netlib::SocketAddress;
+using netlib::TcpClient;
+using netlib::TcpConnectionPtr;
+using netlib::TcpServer;
+using netlib::Thread;
+using netlib::TimeStamp;
+
+const int kThreadNumber = 8;
+const int kMessageNumber = 50 * 1000; // Per thread.
+const int kMessageLength = 100; // "thread seq payload...\n"
+
+EventLoop *g_loop;
+TcpClient *g_client;
+vector<Thread*> g_sender;
+vector<int> g_next_sequence(kThreadNumber, 0);
+int g_received_message = 0;
+
+// Hold the connection only while sending, so that it closes once the client leaves.
+void SendInThread(const std::weak_ptr<netlib::TcpConnection> &weak_connection,
+                  int thread_index)
+{
+	TcpConnectionPtr connection(weak_connection.lock());
+	assert(connection);
+	for(int sequence = 0; sequence < kMessageNumber; ++sequence)
+	{
+		char message[kMessageLength];
+		int length = snprintf(message, sizeof message, "%d %d ", thread_index, sequence);
+		memset(message + length, 'a' + sequence % 26, kMessageLength - length - 1);
+		message[kMessageLength - 1] = '\n';
+		connection->Send(message, kMessageLength);
+		memset(message, 0, sizeof message); // The loop must not see this.
+	}
+}
+
+void HandleServerConnection(const TcpConnectionPtr &connection)
+{
+	if(connection->Connected() == true)
+	{
+		for(int index = 0; index < kThreadNumber; ++index)
+		{
+			std::weak_ptr<netlib::TcpConnection> weak_connection(connection);
+			g_sender.push_back(new Thread(bind(SendInThread, weak_connection, index)));
+			g_sender.back()->Start();
+		}
+	}
+}
+
+void HandleClientConnection(const TcpConnectionPtr &connection)
+{
+	if(connection->Connected() == false)
+	{
+		g_loop->Quit();
+	}
+}
+
+void HandleClientMessage(const TcpConnectionPtr&, Buffer *buffer, const TimeStamp&)
+{
+	while(buffer->ReadableByte() >= kMessageLength)
+	{
+		const char *eol = buffer->FindEOL();
+		assert(eol == buffer->ReadableBegin() + kMessageLength - 1);
+		int thread_index = -1, sequence = -1;
+		int parsed_number = sscanf(buffer->ReadableBegin(), "%d %d ", &thread_index, &sequence);
+		assert(parsed_number == 2);
+		assert(0 <= thread_index && thread_index < kThreadNumber);
+		int expected_sequence = g_next_sequence[thread_index]++;
+		assert(sequence == expected_sequence);
+		assert(*(eol - 1) == 'a' + sequence % 26);
+		buffer->Retrieve(kMessageLength);
+		if(++g_received_message == kThreadNumber * kMessageNumber)
+		{
+			g_client->Disconnect();
+		}
+	}
+}
+
+int main()
+{
+	SetLogLevel(WARN);
+	EventLoop loop;
+	g_loop = &loop;
+	SocketAddress server_address(7190);
+	TcpServer server(&loop, server_address, "SendStressServer", 2);
+	server.set_connection_callback(HandleServerConnection);
+	server.Start();
+
+	TcpClient client(&loop, SocketAddress("127.0.0.1", 7190), "SendStressClient");
+	g_client = &client;
+	client.set_connection_callback(HandleClientConnection);
+	client.set_message_callback(HandleClientMessage);
+	client.Connect();
+	TimeStamp start(TimeStamp::Now());
+	loop.Loop();
+
+	double used_time = TimeDifferenceInSecond(TimeStamp::Now(), start);
+	for(int index = 0; index < kThreadNumber; ++index)
+	{
+		g_sender[index]->Join();
+		assert(g_next_sequence[index] == kMessageNumber);
+		delete g_sender[index];
+	}
+	printf("%d threads sent %d messages in %f seconds.\n",
+	       kThreadNumber, g_received_message, used_time);
+	printf("All passed!\n");
+}
@@ -0,0 +1,95 @@
+#include <stdio.h> // printf()
+
+#include <netlib/buffer.h>
+#include <netlib/event_loop.h>
+#include <netlib/slab_allocator.h>
+#include <netlib/thread.h>
+
+using netlib::Buffer;
+using netlib::EventLoop;
+using netlib::SlabAllocator;
+using netlib::Thread;
+
+void RoundUpTest()
+{
+	assert(SlabAllocator::RoundUp(0) == SlabAllocator::kMinSize);
+	assert(SlabAllocator::RoundUp(64) == 64);
+	assert(SlabAllocator::RoundUp(65) == 128);
+	assert(SlabAllocator::RoundUp(1032) == 2048);
+	assert(SlabAllocator::RoundUp(SlabAllocator::kMaxSize) == SlabAllocator::kMaxSize);
+	assert(SlabAllocator::RoundUp(SlabAllocator::kMaxSize + 1) == SlabAllocator::kMaxSize + 1);
+}
+
+void HitMissTest(EventLoop &loop)
+{
+	SlabAllocator *allocator = loop.slab_allocator();
+	char *first = allocator->Allocate(1000);
+	assert(allocator->hit_number() == 0 && allocator->miss_number() == 1);
+	allocator->Deallocate(first, 1000);
+	assert(allocator->cached_byte() == 1024);
+	char *second = allocator->Allocate(1024);
+	assert(second == first && allocator->hit_number() == 1);
+	assert(allocator->cached_byte() == 0);
+	allocator->Deallocate(second, 1024);
+
+	// Larger than kMaxSize: neither cached nor counted.
+	char *large = allocator->Allocate(SlabAllocator::kMaxSize + 1);
+	allocator->Deallocate(large, SlabAllocator::kMaxSize + 1);
+	assert(allocator->cached_byte() == 1024 && allocator->miss_number() == 1);
+}
+
+void BufferTest(EventLoop &loop)
+{
+	SlabAllocator *allocator = loop.slab_allocator();
+	int64_t hit_number = allocator->hit_number();
+	for(int round = 0; round < 100; ++round)
+	{
+		Buffer buffer(Buffer::kOneKilobyte, allocator);
+		assert(buffer.WritableByte() == 2048 - Buffer::kInitialPrependableByte);
+		for(int index = 0; index < 10000; ++index)
+		{
+			buffer.Append("x", 1);
+		}
+		assert(buffer.ReadableByte() == 10000);
+		Buffer copy(buffer);
+		assert(copy.RetrieveAllAsString() == buffer.RetrieveAllAsString());
+	}
+	// After the first round every storage comes from the free lists.
+	assert(allocator->hit_number() > hit_number);
+
+	Buffer detached(100, allocator);
+	detached.Append("abc", 3);
+	int64_t cached_byte = allocator->cached_byte();
+	detached.DetachAllocator();
+	assert(allocator->cached_byte() > cached_byte);
+	assert(detached.RetrieveAllAsString() == "abc");
+}
+
+void OtherThreadTest(EventLoop &loop)
+{
+	SlabAllocator *allocator = loop.slab_allocator();
+	int64_t hit_number = allocator->hit_number();
+	int64_t miss_number = allocator->miss_number();
+	int64_t cached_byte = allocator->cached_byte();
+	Thread thread([allocator]
+	{
+		char *data = allocator->Allocate(100);
+		allocator->Deallocate(data, 100);
+		Buffer buffer(Buffer::kOneKilobyte, allocator);
+		buffer.Append("hello", 5);
+	});
+	thread.Start();
+	thread.Join();
+	assert(allocator->hit_number() == hit_number && allocator->miss_number() == miss_number);
+	assert(allocator->cached_byte() == cached_byte);
+}
+
+int main()
+{
+	EventLoop loop;
+	RoundUpTest();
+	HitMissTest(loop);
+	BufferTest(loop);
+	OtherThreadTest(loop);
+	printf("SlabAllocator test passed.\n");
+}
@@ -0,0 +1,126 @@
+#include <stdio.h> // printf()
+#include <stdlib.h> // malloc(), free()
+#include <unistd.h> // _exit()
+
+#include <atomic>
+#include <new> // bad_alloc
+#include <string>
+
+#include <netlib/buffer.h>
+#include <netlib/count_down_latch.h>
+#include <netlib/event_loop.h>
+#include <netlib/logging.h>
+#include <netlib/socket_address.h>
+#include <netlib/tcp_client.h>
+#include <netlib/tcp_connection.h>
+#include <netlib/tcp_server.h>
+#include <netlib/thread.h>
+
+using std::string;
+using netlib::Buffer;
+using netlib::CountDownLatch;
+using netlib::EventLoop;
+using netlib::SocketAddress;
+using netlib::TcpClient;
+using netlib::TcpConnectionPtr;
+using netlib::TcpServer;
+using netlib::Thread;
+using netlib::TimeStamp;
+
+// Every operator new of the process, in all threads.
+std::atomic<int64_t> g_new_number(0);
+void *operator new(size_t size)
+{
+	g_new_number.fetch_add(1, std::memory_order_relaxed);
+	void *pointer = ::malloc(size);
+	if(pointer == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+void operator delete(void *pointer) noexcept
+{
+	::free(pointer);
+}
+void operator delete(void *pointer, size_t) noexcept
+{
+	::free(pointer);
+}
+
+const int kPort = 7400;
+const int kMessageSize = 64;
+const int kMessageNumber = 200 * 1000;
+
+// Another thread Send()s kMessageNumber messages on the server side of a connection,
+// each one a task queued to the loop; the client counts the bytes back in.
+int main()
+{
+	SetLogLevel(WARN);
+	EventLoop loop;
+	const string message(kMessageSize, 'm');
+	TcpConnectionPtr server_connection;
+	CountDownLatch connected(1);
+	int64_t received_byte = 0;
+
+	TcpServer server(&loop, SocketAddress(kPort), "TaskServer");
+	server.set_connection_callback([&](const TcpConnectionPtr &connection)
+	{
+		if(connection->Connected() == true)
+		{
+			server_connection = connection;
+			connected.CountDown();
+		}
+	});
+	server.Start();
+	TcpClient client(&loop, SocketAddress("127.0.0.1", kPort), "Client");
+	client.set_message_callback([&](const TcpConnectionPtr&, Buffer *buffer, const TimeStamp&)
+	{
+		received_byte += buffer->ReadableByte();
+		buffer->RetrieveAll();
+		if(received_byte == static_cast<int64_t>(kMessageNumber) * kMessageSize)
+		{
+			loop.Quit();
+		}
+	});
+	client.Connect();
+
+	int64_t new_before = 0;
+	TimeStamp start;
+	Thread sender([&]()
+	{
+		connected.Wait();
+		new_before = g_new_number.load();
+		start = TimeStamp::Now();
+		for(int index = 0; index < kMessageNumber; ++index)
+		{
+			server_connection->Send(message.data(), kMessageSize);
+		}
+	});
+	sender.Start();
+	loop.Loop();
+	double second = TimeDifferenceInSecond(TimeStamp::Now(), start);
+	sender.Join();
+	printf("%d cross-thread Send()s of %d B: %.2f operator new per Send, %.0f Send/s\n",
+	       kMessageNumber,
+	       kMessageSize,
+	       static_cast<double>(g_new_number.load() - new_before) / kMessageNumber,
+	       kMessageNumber / second);
+	fflush(stdout);
+	_exit(0); // Skip the teardown of a loop that no longer runs.
+}
+/*
+$ ./task_bench # -O2, 1 CPU VM.
+Before, std::function tasks:
+200000 cross-thread Send()s of 64 B: 4.99 operator new per Send, 1037248 Send/s
+200000 cross-thread Send()s of 64 B: 4.99 operator new per Send, 752930 Send/s
+200000 cross-thread Send()s of 64 B: 4.99 operator new per Send, 853119 Send/s
+After, Task:
+200000 cross-thread Send()s of 64 B: 3.00 operator new per Send, 1154494 Send/s
+200000 cross-thread Send()s of 64 B: 3.00 operator new per Send, 1084305 Send/s
+200000 cross-thread Send()s of 64 B: 3.00 operator new per Send, 1302787 Send/s
+Gone: the heap copy of the 48-byte bind() inside std::function, and the second one
+Push(const TaskCallback&) made into the queue node. Left: the queue node, the
+shared_ptr<Slab> control block, and a new slab whenever the sender outruns the loop
+and the free list is empty.
+*/
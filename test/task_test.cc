@@ -0,0 +1,120 @@
+#include <assert.h>
+#include <stdio.h> // printf()
+
+#include <functional> // bind(), function<>
+#include <memory> // shared_ptr<>, unique_ptr<>
+#include <utility> // move()
+
+#include <netlib/task.h>
+
+using std::shared_ptr;
+using std::unique_ptr;
+using netlib::Task;
+
+int g_live_number = 0; // Callables alive.
+
+// Move-only, with `Size` bytes of payload.
+template<int Size>
+struct Callable
+{
+	explicit Callable(int *count_arg): count(count_arg), owner(new int(0))
+	{
+		++g_live_number;
+	}
+	Callable(Callable &&rhs) noexcept: count(rhs.count), owner(std::move(rhs.owner))
+	{
+		++g_live_number;
+	}
+	~Callable()
+	{
+		--g_live_number;
+	}
+	void operator()()
+	{
+		++*count;
+		++*owner;
+	}
+
+	int *count;
+	unique_ptr<int> owner;
+	char padding[Size];
+};
+
+void Add(const shared_ptr<int> &lhs, const shared_ptr<int> &rhs, int *sum)
+{
+	*sum += *lhs + *rhs;
+}
+
+void TestEmpty()
+{
+	Task task;
+	assert(static_cast<bool>(task) == false);
+	Task null_task(nullptr);
+	assert(static_cast<bool>(null_task) == false);
+	Task moved(std::move(task));
+	assert(static_cast<bool>(moved) == false);
+}
+
+template<int Size>
+void TestCallable(bool inline_expected)
+{
+	assert(Task::IsInline<Callable<Size>>() == inline_expected);
+	int count = 0;
+	{
+		Task task = Task(Callable<Size>(&count));
+		assert(static_cast<bool>(task) == true);
+		task();
+		task(); // Can be run more than once, as a repeating timer does.
+		assert(count == 2);
+
+		Task moved(std::move(task));
+		assert(static_cast<bool>(task) == false);
+		moved();
+		assert(count == 3);
+
+		Task assigned;
+		assigned = std::move(moved);
+		assigned();
+		assert(count == 4);
+		assigned = Task(Callable<Size>(&count)); // Destructs the old callable.
+		assert(g_live_number == 1);
+		assigned.Reset();
+		assert(g_live_number == 0);
+		assert(static_cast<bool>(assigned) == false);
+	}
+	assert(g_live_number == 0);
+}
+
+void TestBind()
+{
+	shared_ptr<int> lhs(new int(1)), rhs(new int(2));
+	int sum = 0;
+	// The bind() every cross-thread send makes: two shared_ptr and a member pointer fit.
+	auto bound = std::bind(&Add, lhs, rhs, &sum);
+	static_assert(Task::IsInline<decltype(bound)>() == true, "bind() of two shared_ptr");
+	Task task(std::move(bound));
+	assert(lhs.use_count() == 2);
+	Task moved(std::move(task)); // No copy of the shared_ptr.
+	assert(lhs.use_count() == 2);
+	moved();
+	assert(sum == 3);
+	moved.Reset();
+	assert(lhs.use_count() == 1);
+
+	// A std::function is a callable like any other.
+	std::function<void()> function([&sum]() { sum = 0; });
+	Task from_function(function);
+	from_function();
+	assert(sum == 0);
+}
+
+int main()
+{
+	TestEmpty();
+	TestCallable<8>(true);
+	TestCallable<1024>(false);
+	TestBind();
+	printf("sizeof(Task) = %zu, sizeof(std::function<void()>) = %zu\n",
+	       sizeof(Task), sizeof(std::function<void()>));
+	printf("task_test passed\n");
+}
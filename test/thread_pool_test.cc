@@ -2,6 +2,7 @@
 #include <netlib/thread_pool.h>
 #include <netlib/count_down_latch.h>
 
+#include <stdio.h> // printf()
 #include <unistd.h> // sleep()
 
 using std::bind;
@@ -0,0 +1,162 @@
+// Threads add sub-millisecond timers and cancel random earlier ones, pending, running,
+// expired or canceled already, while the loop thread does the same and reuses the
+// Timers they leave. A stale TimerId must never cancel the timer that reused its Timer:
+// every timer not canceled fires exactly once, none fires after its cancel returns.
+
+#include <assert.h>
+#include <stdio.h> // printf()
+#include <stdlib.h> // rand_r()
+#include <unistd.h> // usleep()
+
+#include <atomic>
+#include <functional> // function<>
+#include <memory> // make_shared()
+#include <vector>
+
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_option.h>
+#include <netlib/event_loop_thread.h>
+#include <netlib/thread.h>
+#include <netlib/time_stamp.h>
+#include <netlib/timer_id.h>
+
+using std::vector;
+using netlib::EventLoop;
+using netlib::EventLoopOption;
+using netlib::EventLoopThread;
+using netlib::Thread;
+using netlib::TimeStamp;
+using netlib::TimerId;
+
+const int kThreadNumber = 4;
+const int kTimerNumber = 50 * 1000; // Per thread, half of them never canceled.
+const int kBurstNumber = 500; // In the loop thread.
+const int kBurstSize = 200;
+const int kRepeatNumber = 3; // Repeating timers cancel themselves after that many runs.
+
+double RandomDelay(unsigned *seed)
+{
+	return (rand_r(seed) % 1000) / 1000000.0; // Up to 1ms.
+}
+
+void Stress(const EventLoopOption &option)
+{
+	EventLoopThread loop_thread(option);
+	EventLoop *loop = loop_thread.StartLoop();
+	std::atomic<int> kept_fired(0), cancelable_fired(0), repeat_fired(0);
+	int kept_number = 0, repeat_number = 0; // Of the loop thread.
+
+	// The loop thread: synchronous cancels, so a canceled timer must never run.
+	vector<TimerId> loop_timer_id_vector;
+	vector<char> loop_canceled_vector(kBurstNumber * kBurstSize, 0);
+	unsigned loop_seed = 100;
+	std::atomic<int> burst_done(0);
+	std::function<void()> burst = [&]()
+	{
+		for(int index = 0; index < kBurstSize; ++index)
+		{
+			int number = static_cast<int>(loop_timer_id_vector.size());
+			if(number % 2 == 0)
+			{
+				++kept_number;
+				loop_timer_id_vector.push_back(loop->RunAfter([&]() { ++kept_fired; },
+				                               RandomDelay(&loop_seed)));
+				continue;
+			}
+			loop_timer_id_vector.push_back(loop->RunAfter([&, number]()
+			{
+				assert(loop_canceled_vector[number] == 0);
+				++cancelable_fired;
+			}, RandomDelay(&loop_seed)));
+			int victim = (rand_r(&loop_seed) % (number / 2 + 1)) * 2 + 1;
+			victim = (victim <= number) ? victim : number;
+			loop->CancelTimer(loop_timer_id_vector[victim]);
+			loop_canceled_vector[victim] = 1;
+		}
+		// One repeating timer per burst, canceled twice from its own callback.
+		++repeat_number;
+		auto run_number = std::make_shared<int>(0);
+		auto self = std::make_shared<TimerId>(nullptr, 0);
+		*self = loop->RunEvery([&, run_number, self]()
+		{
+			assert(*run_number < kRepeatNumber);
+			++repeat_fired;
+			if(++*run_number == kRepeatNumber)
+			{
+				loop->CancelTimer(*self);
+				loop->CancelTimer(*self);
+			}
+		}, 0.0005);
+		if(++burst_done < kBurstNumber)
+		{
+			loop->QueueInLoop([&]() { burst(); });
+		}
+	};
+	loop->RunInLoop([&]() { burst(); });
+
+	// Other threads: their cancels race with expiry and reuse.
+	vector<Thread*> thread_vector;
+	for(int thread_index = 0; thread_index < kThreadNumber; ++thread_index)
+	{
+		thread_vector.push_back(new Thread([&, thread_index]()
+		{
+			unsigned seed = static_cast<unsigned>(thread_index + 1);
+			vector<TimerId> timer_id_vector;
+			timer_id_vector.reserve(kTimerNumber);
+			for(int index = 0; index < kTimerNumber; ++index)
+			{
+				if(index % 2 == 0)
+				{
+					timer_id_vector.push_back(loop->RunAfter([&]() { ++kept_fired; },
+					                          RandomDelay(&seed)));
+					continue;
+				}
+				timer_id_vector.push_back(loop->RunAfter([&]() { ++cancelable_fired; },
+				                          RandomDelay(&seed)));
+				int victim = (rand_r(&seed) % (index / 2 + 1)) * 2 + 1;
+				loop->CancelTimer(timer_id_vector[victim <= index ? victim : index]);
+			}
+			// Long stale by now, their Timers reused by the loop thread's timers.
+			for(int index = 1; index < kTimerNumber; index += 2)
+			{
+				loop->CancelTimer(timer_id_vector[index]);
+			}
+		}));
+		thread_vector.back()->Start();
+	}
+	for(int index = 0; index < kThreadNumber; ++index)
+	{
+		thread_vector[index]->Join();
+		delete thread_vector[index];
+	}
+
+	int kept_total = kThreadNumber * kTimerNumber / 2 + kBurstNumber * kBurstSize / 2;
+	TimeStamp deadline = AddTime(TimeStamp::Now(), 20.0);
+	while((kept_fired.load() < kept_total || burst_done < kBurstNumber ||
+	        repeat_fired.load() < kBurstNumber * kRepeatNumber) &&
+	        TimeStamp::Now() < deadline)
+	{
+		usleep(10 * 1000);
+	}
+	usleep(50 * 1000); // Time for extra, wrong, runs.
+	printf("store %d: %d kept fired, %d of %d cancelable fired, %d repeats\n",
+	       static_cast<int>(option.timer_store),
+	       kept_fired.load(),
+	       cancelable_fired.load(),
+	       kThreadNumber * kTimerNumber / 2 + kBurstNumber * kBurstSize / 2,
+	       repeat_fired.load());
+	assert(kept_number == kBurstNumber * kBurstSize / 2);
+	assert(repeat_number == kBurstNumber);
+	assert(kept_fired.load() == kept_total);
+	assert(repeat_fired.load() == kBurstNumber * kRepeatNumber);
+}
+
+int main()
+{
+	EventLoopOption option;
+	Stress(option);
+	option.timer_store = EventLoopOption::TIMING_WHEEL;
+	option.timing_wheel_tick_microsecond = 100;
+	Stress(option);
+	printf("timer_cancel_stress_test passed\n");
+}
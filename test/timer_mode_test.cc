@@ -0,0 +1,103 @@
+#include <assert.h>
+#include <stdio.h> // printf()
+#include <unistd.h> // usleep()
+
+#include <atomic>
+
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_option.h>
+#include <netlib/event_loop_thread.h>
+#include <netlib/thread.h>
+#include <netlib/time_stamp.h>
+#include <netlib/timer_id.h>
+
+using netlib::EventLoop;
+using netlib::EventLoopOption;
+using netlib::EventLoopThread;
+using netlib::Thread;
+using netlib::TimeStamp;
+using netlib::TimerId;
+
+// Same timer behavior is expected no matter which mode drives the TimerQueue.
+void TestMode(const EventLoopOption &option)
+{
+	EventLoop loop(option);
+	TimeStamp start = TimeStamp::Now();
+	int once_number = 0, every_number = 0, canceled_number = 0;
+	double once_delay = 0;
+
+	loop.RunAfter([&]()
+	{
+		++once_number;
+		once_delay = TimeDifferenceInSecond(TimeStamp::Now(), start);
+	}, 0.05);
+	TimerId every = loop.RunEvery([&]()
+	{
+		if(++every_number == 5)
+		{
+			loop.CancelTimer(every);
+		}
+	}, 0.01);
+	TimerId canceled = loop.RunAfter([&]() { ++canceled_number; }, 0.1);
+	loop.RunAfter([&]() { loop.CancelTimer(canceled); }, 0.06);
+
+	// A timer added by another thread must shorten a wait that is already in progress.
+	Thread thread([&]()
+	{
+		loop.RunAfter([&]() { loop.Quit(); }, 0.15);
+	});
+	loop.RunAfter([&]() { thread.Start(); }, 0.08);
+	loop.Loop();
+	thread.Join();
+
+	double elapsed = TimeDifferenceInSecond(TimeStamp::Now(), start);
+	assert(once_number == 1);
+	assert(once_delay >= 0.05 && once_delay < 0.5);
+	assert(every_number == 5);
+	assert(canceled_number == 0);
+	assert(elapsed >= 0.23 && elapsed < 1.0);
+	printf("mode %d precise %d store %d: once fired after %.6fs, quit after %.6fs\n",
+	       static_cast<int>(option.timer_mode),
+	       option.precise_timeout == true ? 1 : 0,
+	       static_cast<int>(option.timer_store),
+	       once_delay,
+	       elapsed);
+}
+
+void TestLoopThread(const EventLoopOption &option)
+{
+	EventLoopThread loop_thread(option);
+	EventLoop *loop = loop_thread.StartLoop();
+	assert(loop->option().timer_mode == option.timer_mode);
+
+	std::atomic<int> fired(0);
+	loop->RunAfter([&]() { ++fired; }, 0.02);
+	while(fired.load() == 0)
+	{
+		usleep(1000);
+	}
+	assert(fired.load() == 1);
+}
+
+int main()
+{
+	EventLoopOption option;
+	assert(option.timer_mode == EventLoopOption::TIMER_FD);
+	TestMode(option);
+	TestLoopThread(option);
+
+	option.timer_mode = EventLoopOption::EPOLL_TIMEOUT;
+	TestMode(option);
+	TestLoopThread(option);
+
+	option.precise_timeout = true;
+	TestMode(option);
+
+	option.timer_store = EventLoopOption::TIMING_WHEEL;
+	TestMode(option);
+	option.timer_mode = EventLoopOption::TIMER_FD;
+	TestMode(option);
+	TestLoopThread(option);
+
+	printf("timer_mode_test passed\n");
+}
@@ -0,0 +1,188 @@
+#include <stdio.h> // printf()
+#include <stdlib.h> // rand_r()
+
+#include <vector>
+
+#include <netlib/count_down_latch.h>
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_metrics.h>
+#include <netlib/event_loop_option.h>
+#include <netlib/event_loop_thread.h>
+#include <netlib/logging.h>
+#include <netlib/time_stamp.h>
+#include <netlib/timer_id.h>
+
+using std::vector;
+using netlib::CountDownLatch;
+using netlib::EventLoop;
+using netlib::EventLoopMetrics;
+using netlib::EventLoopOption;
+using netlib::EventLoopThread;
+using netlib::TimeStamp;
+using netlib::TimerId;
+
+const int kTimerNumber = 1000 * 1000;
+const int kChurnWindow = 10 * 1000;
+
+const char *StoreName(EventLoopOption::TimerStore store)
+{
+	return (store == EventLoopOption::TIMER_SET) ? "TIMER_SET   " : "TIMING_WHEEL";
+}
+
+// kTimerNumber timers 1 to 60 seconds away added, then all canceled, from the loop
+// thread, as an idle timeout per connection is. Nothing fires.
+void AddCancelBench(EventLoopOption::TimerStore store)
+{
+	EventLoopOption option;
+	option.timer_store = store;
+	EventLoop loop(option);
+	vector<TimerId> timer_id_vector;
+	timer_id_vector.reserve(kTimerNumber);
+	unsigned seed = 1;
+
+	TimeStamp start = TimeStamp::Now();
+	for(int index = 0; index < kTimerNumber; ++index)
+	{
+		double delay = 1.0 + 59.0 * rand_r(&seed) / RAND_MAX;
+		timer_id_vector.push_back(loop.RunAfter([]() {}, delay));
+	}
+	TimeStamp added = TimeStamp::Now();
+	for(int index = 0; index < kTimerNumber; ++index)
+	{
+		loop.CancelTimer(timer_id_vector[index]);
+	}
+	TimeStamp canceled = TimeStamp::Now();
+	printf("%s add %.0f ns/timer, cancel %.0f ns/timer\n",
+	       StoreName(store),
+	       TimeDifferenceInSecond(added, start) * 1e9 / kTimerNumber,
+	       TimeDifferenceInSecond(canceled, added) * 1e9 / kTimerNumber);
+}
+
+// Steady state: kChurnWindow timers live, the oldest canceled for each new one, as
+// a request timeout per message is. Canceled Timers are reused from then on.
+void ChurnBench(EventLoopOption::TimerStore store)
+{
+	EventLoopOption option;
+	option.timer_store = store;
+	EventLoop loop(option);
+	vector<TimerId> timer_id_vector;
+	unsigned seed = 3;
+	for(int index = 0; index < kChurnWindow; ++index)
+	{
+		timer_id_vector.push_back(loop.RunAfter([]() {}, 10.0 + rand_r(&seed) % 1000 / 1000.0));
+	}
+
+	TimeStamp start = TimeStamp::Now();
+	for(int index = 0; index < kTimerNumber; ++index)
+	{
+		TimerId &timer_id = timer_id_vector[index % kChurnWindow];
+		loop.CancelTimer(timer_id);
+		timer_id = loop.RunAfter([]() {}, 10.0 + rand_r(&seed) % 1000 / 1000.0);
+	}
+	printf("%s churn %.0f ns/(cancel + add)\n",
+	       StoreName(store),
+	       TimeDifferenceInSecond(TimeStamp::Now(), start) * 1e9 / kTimerNumber);
+}
+
+// This thread adds kTimerNumber timers, 10 to 11 seconds away, to a loop running in
+// another thread: the tasks and eventfd writes they cost the loop.
+void ForeignAddBench(EventLoopOption::TimerStore store)
+{
+	EventLoopOption option;
+	option.timer_store = store;
+	EventLoopThread loop_thread(option);
+	EventLoop *loop = loop_thread.StartLoop();
+	unsigned seed = 4;
+	EventLoopMetrics before = loop->Metrics();
+	int64_t wakeup_before = loop->wakeup_write_number();
+
+	TimeStamp start = TimeStamp::Now();
+	for(int index = 0; index < kTimerNumber; ++index)
+	{
+		loop->RunAfter([]() {}, 10.0 + rand_r(&seed) % 1000 / 1000.0);
+	}
+	CountDownLatch added(1); // Queued after the timers: they are all in.
+	loop->QueueInLoop([&added]() { added.CountDown(); });
+	added.Wait();
+	double second = TimeDifferenceInSecond(TimeStamp::Now(), start);
+	EventLoopMetrics after = loop->Metrics();
+	printf("%s foreign add %.0f ns/timer, %.3f task/timer, %.3f wakeup/timer\n",
+	       StoreName(store),
+	       second * 1e9 / kTimerNumber,
+	       static_cast<double>(after.task_number - before.task_number) / kTimerNumber,
+	       static_cast<double>(loop->wakeup_write_number() - wakeup_before) / kTimerNumber);
+}
+
+// kTimerNumber timers spread over one second, starting after the time adding them
+// takes, all left to fire. Busy time counts the timerfd reads and the dispatch.
+void ExpireBench(EventLoopOption::TimerStore store)
+{
+	EventLoopOption option;
+	option.timer_store = store;
+	EventLoop loop(option);
+	int fired_number = 0;
+	unsigned seed = 2;
+
+	for(int index = 0; index < kTimerNumber; ++index)
+	{
+		double delay = 3.0 + 1.0 * rand_r(&seed) / RAND_MAX;
+		loop.RunAfter([&]()
+		{
+			if(++fired_number == kTimerNumber)
+			{
+				loop.Quit();
+			}
+		}, delay);
+	}
+	EventLoopMetrics before = loop.Metrics();
+	loop.Loop();
+	EventLoopMetrics after = loop.Metrics();
+	int64_t busy_microsecond = (after.io_microsecond - before.io_microsecond) +
+	                           (after.timer_microsecond - before.timer_microsecond);
+	printf("%s expire %.0f ns/timer in %lld wakeups\n",
+	       StoreName(store),
+	       static_cast<double>(busy_microsecond) * 1e3 / kTimerNumber,
+	       static_cast<long long>(after.iteration_number - before.iteration_number));
+}
+
+int main()
+{
+	SetLogLevel(WARN);
+	AddCancelBench(EventLoopOption::TIMER_SET);
+	AddCancelBench(EventLoopOption::TIMING_WHEEL);
+	ChurnBench(EventLoopOption::TIMER_SET);
+	ChurnBench(EventLoopOption::TIMING_WHEEL);
+	ForeignAddBench(EventLoopOption::TIMER_SET);
+	ForeignAddBench(EventLoopOption::TIMING_WHEEL);
+	ExpireBench(EventLoopOption::TIMER_SET);
+	ExpireBench(EventLoopOption::TIMING_WHEEL);
+}
+/*
+$ ./timer_queue_bench # -O2, 1 CPU VM, TIMER_FD mode.
+TIMER_SET    add 1685 ns/timer, cancel 1285 ns/timer
+TIMING_WHEEL add 82 ns/timer, cancel 90 ns/timer
+TIMER_SET    churn 431 ns/(cancel + add)
+TIMING_WHEEL churn 81 ns/(cancel + add)
+TIMER_SET    expire 522 ns/timer in 1734 wakeups
+TIMING_WHEEL expire 385 ns/timer in 707 wakeups
+TIMER_SET    add 1939 ns/timer, cancel 1476 ns/timer
+TIMING_WHEEL add 111 ns/timer, cancel 94 ns/timer
+TIMER_SET    churn 610 ns/(cancel + add)
+TIMING_WHEEL churn 102 ns/(cancel + add)
+TIMER_SET    expire 451 ns/timer in 1867 wakeups
+TIMING_WHEEL expire 347 ns/timer in 769 wakeups
+Add and cancel of a million timers are 10-20x cheaper with the wheel: a slot push and
+unlink instead of a red-black tree of a million nodes, most of which miss the cache.
+Expiry costs about the same, since both mostly run and recycle each Timer; the wheel
+batches by 1ms ticks, so it wakes up 2-3x less.
+Churn before Timers were recycled, 3 runs: TIMER_SET 676/593/833 ns,
+TIMING_WHEEL 134/94/139 ns; after: 554/652/621 and 85/122/120 ns. The malloc() and
+free() of a Timer are cheap from glibc's thread cache, so the free list is mostly about
+cancel safety; the gain is within this VM's noise for the set, ~20% for the wheel.
+Foreign add, 3 runs each, one task per timer before the pending list:
+before: TIMER_SET 1645/1603/1488 ns, TIMING_WHEEL 487/448/401 ns, 1.000 task/timer
+after:  TIMER_SET 1191/1212/1294 ns, TIMING_WHEEL 207/294/285 ns, <0.035 task/timer
+While the loop is busy inserting, the other thread keeps pushing onto the same batch,
+so the set takes a single task; the wheel drains faster and takes one per ~30 timers.
+The set never lets the loop sleep, so neither takes eventfd wakeups there.
+*/
@@ -0,0 +1,103 @@
+#include <assert.h>
+#include <stdio.h> // printf()
+
+#include <vector>
+
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_metrics.h>
+#include <netlib/event_loop_option.h>
+#include <netlib/time_stamp.h>
+#include <netlib/timer.h>
+
+using std::vector;
+using netlib::EventLoop;
+using netlib::EventLoopMetrics;
+using netlib::EventLoopOption;
+using netlib::Task;
+using netlib::TimeStamp;
+using netlib::Timer;
+
+const int kHeartbeatNumber = 100;
+const double kInterval = 0.05;
+const double kSpread = 0.02; // First runs spread evenly over this long.
+const double kRunSecond = 0.6;
+
+// Restart() keeps to the multiples of the interval from the first expiration.
+void TestRestart()
+{
+	const int64_t start = 1000 * 1000;
+	Timer timer(Task(), TimeStamp(start), 0.01);
+	timer.Restart(TimeStamp(start + 300)); // Run 300us late.
+	assert(timer.expired_time().microsecond() == start + 10000);
+	timer.Restart(TimeStamp(start + 10000)); // On time.
+	assert(timer.expired_time().microsecond() == start + 20000);
+	timer.Restart(TimeStamp(start + 55000)); // Stalled: skip the missed periods.
+	assert(timer.expired_time().microsecond() == start + 60000);
+
+	Timer slack_timer(Task(), TimeStamp(start), 0.01, 0.002);
+	assert(slack_timer.deadline().microsecond() == start + 2000);
+	slack_timer.Restart(TimeStamp(start + 1500)); // Within its slack.
+	assert(slack_timer.expired_time().microsecond() == start + 10000);
+	assert(slack_timer.deadline().microsecond() == start + 12000);
+}
+
+// kHeartbeatNumber periodic timers, each due at its own time: the loop wakeups they
+// take from kInterval on, with and without slack to cover the spread.
+int64_t Heartbeat(const EventLoopOption &option, double slack)
+{
+	EventLoop loop(option);
+	vector<int> run_vector(kHeartbeatNumber, 0);
+	vector<TimeStamp> first_vector(kHeartbeatNumber);
+	TimeStamp start = AddTime(TimeStamp::Now(), kInterval + 0.01);
+	for(int index = 0; index < kHeartbeatNumber; ++index)
+	{
+		TimeStamp first = AddTime(start, kSpread * index / kHeartbeatNumber);
+		first_vector[index] = first;
+		// RunEvery() starts one interval from now: start it one interval early.
+		loop.RunAt([&loop, &run_vector, &first_vector, index, slack]()
+		{
+			loop.RunEvery([&run_vector, &first_vector, index, slack]()
+			{
+				int run = ++run_vector[index];
+				double late = TimeDifferenceInSecond(TimeStamp::Now(), first_vector[index]) -
+				              kInterval * (run - 1);
+				assert(late >= 0); // Never before its time.
+			}, kInterval, slack);
+		}, AddTime(first, -kInterval));
+	}
+	EventLoopMetrics before;
+	loop.RunAt([&]() { before = loop.Metrics(); }, AddTime(start, kInterval - 0.005));
+	loop.RunAfter([&]() { loop.Quit(); }, kRunSecond);
+	loop.Loop();
+	EventLoopMetrics after = loop.Metrics();
+
+	int run_number = 0;
+	for(int index = 0; index < kHeartbeatNumber; ++index)
+	{
+		run_number += run_vector[index];
+		assert(run_vector[index] >= 8); // ~ (kRunSecond - 0.06) / kInterval
+	}
+	int64_t wakeup_number = after.iteration_number - before.iteration_number;
+	printf("store %d slack %.3f: %d runs in %lld wakeups\n",
+	       static_cast<int>(option.timer_store),
+	       slack,
+	       run_number,
+	       static_cast<long long>(wakeup_number));
+	return wakeup_number;
+}
+
+int main()
+{
+	TestRestart();
+
+	EventLoopOption option;
+	int64_t exact = Heartbeat(option, 0.0);
+	int64_t coalesced = Heartbeat(option, kSpread);
+	assert(coalesced * 4 < exact);
+
+	option.timer_store = EventLoopOption::TIMING_WHEEL;
+	exact = Heartbeat(option, 0.0);
+	coalesced = Heartbeat(option, kSpread);
+	assert(coalesced * 2 < exact);
+	printf("timer_slack_test passed\n");
+}
@@ -0,0 +1,163 @@
+#include <assert.h>
+#include <stdio.h> // printf()
+#include <stdlib.h> // rand_r()
+
+#include <map>
+#include <utility> // pair<>
+#include <vector>
+
+#include <netlib/time_stamp.h>
+#include <netlib/timer.h>
+#include <netlib/timing_wheel.h>
+
+using std::map;
+using std::pair;
+using std::vector;
+using netlib::Task;
+using netlib::TimeStamp;
+using netlib::Timer;
+using netlib::TimingWheel;
+
+const int64_t kTick = 1000; // 1ms
+const int64_t kSecond = TimeStamp::kMicrosecondPerSecond;
+unsigned g_seed = 1;
+
+int64_t Random(int64_t bound) // [0, bound)
+{
+	int64_t value = (static_cast<int64_t>(rand_r(&g_seed)) << 31) | rand_r(&g_seed);
+	return value % bound;
+}
+int64_t RandomDelay()
+{
+	switch(Random(5))
+	{
+	case 0:
+		return Random(256 * kTick); // Level 0.
+	case 1:
+		return Random(60 * kSecond);
+	case 2:
+		return Random(5 * 3600 * kSecond);
+	case 3:
+		return Random(100 * kTick) + 1000 * kSecond;
+	default:
+		return Random(10 * 24 * 3600 * kSecond) + 50 * 24 * 3600 * kSecond; // Beyond 2^32 ticks.
+	}
+}
+
+// The wheel against a plain model: each timer must come out of an Advance() whose
+// tick reaches the tick its expiration rounds up to, no later than the first one that
+// reaches its deadline's tick(or that first tick, if later), and never after a Remove().
+int main()
+{
+	int64_t now = 1500000000 * kSecond + 123456; // Not aligned to a tick.
+	TimingWheel wheel(kTick, TimeStamp(now));
+	// Pending timers and the first and last tick they may be due.
+	map<Timer*, pair<int64_t, int64_t>> due_tick_map;
+	vector<Timer*> expired_timer_vector;
+	int fired_number = 0, removed_number = 0, next_check_number = 0;
+
+	auto add = [&](int64_t delay)
+	{
+		// A third with up to 50ms of slack.
+		int64_t slack = (Random(3) == 0) ? Random(50 * kTick) : 0;
+		Timer *timer = new Timer(Task(),
+		                         TimeStamp(now + delay),
+		                         0.0,
+		                         static_cast<double>(slack) / kSecond);
+		int64_t first_tick = (now + delay + kTick - 1) / kTick;
+		int64_t last_tick = (now + delay + slack) / kTick;
+		int64_t now_tick = now / kTick;
+		first_tick = (first_tick > now_tick) ? first_tick : now_tick + 1;
+		last_tick = (last_tick > first_tick) ? last_tick : first_tick;
+		due_tick_map[timer] = pair<int64_t, int64_t>(first_tick, last_tick);
+		wheel.Insert(timer);
+	};
+	for(int index = 0; index < 20000; ++index)
+	{
+		add(RandomDelay());
+	}
+
+	int64_t step_number = 0;
+	while(wheel.size() > 0)
+	{
+		assert(wheel.size() == static_cast<int>(due_tick_map.size()));
+		// Never late: the wakeup is no later than the first due timer.
+		int64_t first_due_tick = INT64_MAX;
+		for(map<Timer*, pair<int64_t, int64_t>>::iterator it = due_tick_map.begin();
+		        it != due_tick_map.end();
+		        ++it)
+		{
+			int64_t last_tick = it->second.second;
+			first_due_tick = (last_tick < first_due_tick) ? last_tick : first_due_tick;
+		}
+		int64_t wakeup = wheel.NextWakeupTime().microsecond();
+		assert(wakeup <= first_due_tick * kTick);
+		++next_check_number;
+
+		int64_t previous_tick = now / kTick;
+		switch(Random(4))
+		{
+		case 0:
+			now += Random(5 * kTick);
+			break;
+		case 1:
+			now = (wakeup > now) ? wakeup : now; // What a loop does.
+			break;
+		case 2:
+			now += Random(10 * kSecond);
+			break;
+		default:
+			now += Random(10 * 3600 * kSecond);
+		}
+		wheel.Advance(TimeStamp(now), expired_timer_vector);
+		int64_t now_tick = now / kTick;
+		for(size_t index = 0; index < expired_timer_vector.size(); ++index)
+		{
+			Timer *timer = expired_timer_vector[index];
+			map<Timer*, pair<int64_t, int64_t>>::iterator it = due_tick_map.find(timer);
+			assert(it != due_tick_map.end()); // Once, and not after Remove().
+			assert(it->second.first <= now_tick); // Not early.
+			assert(it->second.second > previous_tick); // Not late.
+			assert(timer->expired_time().microsecond() <= now);
+			assert(wheel.Contain(timer) == false);
+			due_tick_map.erase(it);
+			delete timer;
+			++fired_number;
+		}
+		expired_timer_vector.clear();
+
+		// Churn: remove a few pending timers, add a few new ones.
+		for(int index = 0; index < 3 && due_tick_map.empty() == false; ++index)
+		{
+			map<Timer*, pair<int64_t, int64_t>>::iterator it = due_tick_map.lower_bound(
+			    reinterpret_cast<Timer*>(Random(INT64_MAX)));
+			if(it == due_tick_map.end())
+			{
+				it = due_tick_map.begin();
+			}
+			assert(wheel.Contain(it->first) == true);
+			wheel.Remove(it->first);
+			delete it->first;
+			due_tick_map.erase(it);
+			++removed_number;
+		}
+		if(step_number++ < 5000)
+		{
+			add(RandomDelay());
+			add(Random(3 * kTick));
+		}
+	}
+	assert(due_tick_map.empty() == true);
+	printf("%d fired, %d removed in %lld steps(%d wakeup checks)\n",
+	       fired_number, removed_number, static_cast<long long>(step_number), next_check_number);
+
+	// Destructing the wheel deletes the timers left in it.
+	{
+		TimingWheel other(kTick, TimeStamp(now));
+		for(int index = 0; index < 100; ++index)
+		{
+			other.Insert(new Timer(Task(), TimeStamp(now + RandomDelay()), 0.0));
+		}
+	}
+	printf("timing_wheel_test passed\n");
+}
@@ -0,0 +1,90 @@
+#include <stdio.h> // printf()
+
+#include <memory> // unique_ptr<>
+#include <vector>
+
+#include <netlib/count_down_latch.h>
+#include <netlib/event_loop.h>
+#include <netlib/event_loop_thread.h>
+#include <netlib/thread.h>
+#include <netlib/time_stamp.h>
+
+using std::unique_ptr;
+using std::vector;
+using netlib::CountDownLatch;
+using netlib::EventLoop;
+using netlib::EventLoopThread;
+using netlib::Thread;
+using netlib::TimeStamp;
+
+const int kTaskPerProducer = 200 * 1000;
+
+// `producer_number` threads flood one loop with QueueInLoop(); count how many of
+// their Wakeup()s wrote the eventfd.
+void FloodBench(int producer_number)
+{
+	EventLoopThread loop_thread;
+	EventLoop *loop = loop_thread.StartLoop();
+	int64_t run_number = 0; // Only touched in the loop thread.
+	int64_t write_before = loop->wakeup_write_number();
+	int64_t saved_before = loop->saved_wakeup_number();
+
+	vector<unique_ptr<Thread>> producer_vector;
+	for(int index = 0; index < producer_number; ++index)
+	{
+		producer_vector.push_back(unique_ptr<Thread>(new Thread([loop, &run_number]
+		{
+			for(int task = 0; task < kTaskPerProducer; ++task)
+			{
+				loop->QueueInLoop([&run_number]
+				{
+					++run_number;
+				});
+			}
+		})));
+	}
+	TimeStamp start(TimeStamp::Now());
+	for(int index = 0; index < producer_number; ++index)
+	{
+		producer_vector[index]->Start();
+	}
+	for(int index = 0; index < producer_number; ++index)
+	{
+		producer_vector[index]->Join();
+	}
+	// Runs after every flooded task: the queue is FIFO per producer and this thread
+	// joined them all.
+	CountDownLatch latch(1);
+	loop->QueueInLoop(std::bind(&CountDownLatch::CountDown, &latch));
+	latch.Wait();
+	double time = TimeDifferenceInSecond(TimeStamp::Now(), start);
+
+	int64_t task_number = static_cast<int64_t>(producer_number) * kTaskPerProducer;
+	int64_t write_number = loop->wakeup_write_number() - write_before;
+	int64_t saved_number = loop->saved_wakeup_number() - saved_before;
+	printf("%2d producers: %lld tasks(run %lld) in %.3f s, eventfd writes %lld, saved %lld "
+	       "(%.1f tasks per write)\n",
+	       producer_number,
+	       static_cast<long long>(task_number),
+	       static_cast<long long>(run_number),
+	       time,
+	       static_cast<long long>(write_number),
+	       static_cast<long long>(saved_number),
+	       static_cast<double>(task_number) / static_cast<double>(write_number));
+}
+
+int main()
+{
+	for(int producer_number = 1; producer_number <= 16; producer_number *= 2)
+	{
+		FloodBench(producer_number);
+	}
+}
+/*
+$ ./wakeup_bench # 1 CPU VM. Before coalescing every task cost one eventfd write.
+ 1 producers: 200000 tasks(run 200000) in 0.071 s, eventfd writes 5636, saved 194365 (35.5 tasks per write)
+ 2 producers: 400000 tasks(run 400000) in 0.098 s, eventfd writes 1747, saved 398254 (229.0 tasks per write)
+ 4 producers: 800000 tasks(run 800000) in 0.203 s, eventfd writes 6, saved 799995 (133333.3 tasks per write)
+ 8 producers: 1600000 tasks(run 1600000) in 0.282 s, eventfd writes 3, saved 1599998 (533333.3 tasks per write)
+16 producers: 3200000 tasks(run 3200000) in 0.517 s, eventfd writes 3, saved 3199998 (1066666.7 tasks per write)
+*/